@@ -0,0 +1,93 @@
+// bench_arena.cpp - times request-shaped allocation (many small, short-lived
+// blocks that are all freed when the request ends) through the global heap
+// and through a memory_arena that is reset after each request
+#include "rarena.h"
+#include "rdynarray.h"
+#include "rstring.h"
+#include <chrono>
+#include <cstdio>
+using namespace rtypes;
+
+namespace
+{
+    // a request makes a few dozen blocks of 16 to 512 bytes, and a handful
+    // of containers and strings whose buffers grow as they are filled
+    const int BLOCKS = 48;
+    const int STRINGS = 8;
+    const int REQUESTS = 20000; // per round
+    const int ROUNDS = 15;
+
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+    template<class Alloc>
+    BENCH_NOINLINE size_type raw_request(Alloc& allocator)
+    {
+        void* blocks[BLOCKS];
+        size_type sum = 0;
+        for (int i = 0;i<BLOCKS;i++)
+        {
+            size_type bytes = 16 << (i%6);
+            blocks[i] = allocator.allocate(bytes);
+            static_cast<char*>(blocks[i])[0] = char(i);
+        }
+        for (int i = 0;i<BLOCKS;i++)
+        {
+            sum += static_cast<char*>(blocks[i])[0];
+            allocator.deallocate(blocks[i],16 << (i%6));
+        }
+        return sum;
+    }
+    template<class Alloc>
+    BENCH_NOINLINE size_type container_request(const Alloc& allocator)
+    {
+        dynamic_array<int,Alloc> values(allocator);
+        for (int i = 0;i<100;i++)
+            values.push_back(i);
+        size_type sum = values.size();
+        for (int i = 0;i<STRINGS;i++)
+        {
+            deep_string<char,Alloc> s(allocator);
+            for (int j = 0;j<40+20*i;j++)
+                s.push_back(char('a' + j%26));
+            sum += s.length();
+        }
+        return sum;
+    }
+
+    template<typename Fn>
+    double best_ns_per_request(Fn fn)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int p = 0;p<REQUESTS;p++)
+                fn();
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double ns = elapsed.count() / REQUESTS;
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    memory_arena arena(64 * 1024);
+    default_allocator heap;
+    arena_allocator bound(arena);
+    size_type sink = 0;
+    double rawHeap = best_ns_per_request([&](){ sink += raw_request(heap); });
+    double rawArena = best_ns_per_request([&](){ sink += raw_request(bound); arena.reset(); });
+    double contHeap = best_ns_per_request([&](){ sink += container_request(heap); });
+    double contArena = best_ns_per_request([&](){ sink += container_request(bound); arena.reset(); });
+    std::printf("%d blocks, global heap:    %8.0f ns/request\n",BLOCKS,rawHeap);
+    std::printf("%d blocks, arena + reset:  %8.0f ns/request\n",BLOCKS,rawArena);
+    std::printf("array + %d strings, heap:  %8.0f ns/request\n",STRINGS,contHeap);
+    std::printf("array + %d strings, arena: %8.0f ns/request\n",STRINGS,contArena);
+    return sink==0 ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+// bench_fork_join.cpp - times recursive fork/join work on the task
+// scheduler with 1 to N workers against the same work run serially: a
+// fine-grained recursion (the cost of spawning and joining) and a coarse
+// recursive array sum (how the work spreads over the workers)
+#include "rthread.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+using namespace rtypes;
+
+namespace
+{
+    const int FIB_N = 32;
+    const int FIB_CUTOFF = 12; // (below this the recursion runs serially)
+    const size_type SUM_ELEMENTS = 1 << 25;
+    const size_type SUM_GRAIN = 1 << 14;
+    const int ROUNDS = 5;
+
+    uint64 fib_serial(int n)
+    { return n<2 ? uint64(n) : fib_serial(n-1)+fib_serial(n-2); }
+    uint64 fib(task_scheduler& sched,int n)
+    {
+        if (n < FIB_CUTOFF)
+            return fib_serial(n);
+        uint64 a, b;
+        task_group g(sched);
+        g.spawn([&sched,&a,n](){ a = fib(sched,n-1); });
+        b = fib(sched,n-2);
+        g.wait();
+        return a+b;
+    }
+
+    uint64 sum_serial(const uint32* p,size_type n)
+    {
+        uint64 s = 0;
+        for (size_type i = 0;i<n;i++)
+            s += p[i];
+        return s;
+    }
+    uint64 sum(task_scheduler& sched,const uint32* p,size_type n)
+    {
+        if (n <= SUM_GRAIN)
+            return sum_serial(p,n);
+        uint64 a, b;
+        task_group g(sched);
+        g.spawn([&sched,&a,p,n](){ a = sum(sched,p,n/2); });
+        b = sum(sched,p+n/2,n-n/2);
+        g.wait();
+        return a+b;
+    }
+
+    // the whole computation is spawned from the main thread so that it
+    // starts on a worker's deque, as a real program's would
+    template<typename Fn>
+    double best_ms(Fn fn)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            fn();
+            std::chrono::duration<double,std::milli> elapsed = std::chrono::steady_clock::now()-start;
+            if (r==0 || elapsed.count()<best)
+                best = elapsed.count();
+        }
+        return best;
+    }
+}
+
+int main(int argc,const char* argv[])
+{
+    int maxWorkers = (argc>1 ? std::atoi(argv[1]) : int(std::thread::hardware_concurrency()));
+    if (maxWorkers < 1)
+        maxWorkers = 1;
+    std::vector<uint32> data(SUM_ELEMENTS);
+    for (size_type i = 0;i<SUM_ELEMENTS;i++)
+        data[i] = uint32(i*2654435761u);
+    uint64 sink = 0;
+    double fibSerial = best_ms([&](){ sink += fib_serial(FIB_N); });
+    double sumSerial = best_ms([&](){ sink += sum_serial(&data[0],SUM_ELEMENTS); });
+    std::printf("(%u hardware threads)\n",std::thread::hardware_concurrency());
+    std::printf("workers  fib(%d) ms  speedup  sum of %zu ms  speedup\n",FIB_N,size_t(SUM_ELEMENTS));
+    std::printf("%7s  %10.1f  %7s  %13.1f  %7s\n","serial",fibSerial,"",sumSerial,"");
+    for (int workers = 1;workers<=maxWorkers;workers*=2)
+    {
+        task_scheduler sched(workers);
+        double fibMs = best_ms([&](){
+            task_group g(sched);
+            g.spawn([&](){ sink += fib(sched,FIB_N); });
+        });
+        double sumMs = best_ms([&](){
+            task_group g(sched);
+            g.spawn([&](){ sink += sum(sched,&data[0],SUM_ELEMENTS); });
+        });
+        std::printf("%7d  %10.1f  %6.2fx  %13.1f  %6.2fx\n",workers,fibMs,fibSerial/fibMs,sumMs,sumSerial/sumMs);
+    }
+    return sink==0 ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+// bench_hash_set.cpp - times hash_set lookups (hits and misses) for sets of
+// 10 to 10M elements against std::unordered_set and, while it stays
+// tolerable, the list-backed set
+#include "rset.h"
+#include <unordered_set>
+#include <chrono>
+#include <cstdio>
+using namespace rtypes;
+
+namespace
+{
+    const size_type LOOKUPS = 1 << 20; // per round
+    const int ROUNDS = 5;
+    const size_type LIST_SET_LIMIT = 1000; // (its lookups are linear)
+
+    // scattered keys (the splitmix64 finalizer, so that they share no
+    // structure with the sets' hashing); the keys of even numbers are
+    // inserted and those of odd numbers miss
+    inline uint64 scatter(uint64 x)
+    {
+        x = (x ^ (x>>30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x>>27)) * 0x94d049bb133111ebull;
+        return x ^ (x>>31);
+    }
+    inline uint64 present_key(size_type i)
+    { return scatter(2*uint64(i)); }
+    inline uint64 key_at(size_type i)
+    { return scatter(2*uint64(i) + 1); }
+
+    template<class Set>
+    bool has(const Set& s,uint64 k)
+    { return s.contains(k); }
+    bool has(const std::unordered_set<uint64>& s,uint64 k)
+    { return s.find(k) != s.end(); }
+
+    // looks up keys of elements in a pseudo-random order (or keys that are
+    // absent) and returns the best time per lookup
+    template<class Set>
+    double best_ns_per_lookup(const Set& s,size_type elems,bool hits,size_type& found,size_type lookups = LOOKUPS)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            size_type j = r;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_type i = 0;i<lookups;i++)
+            {
+                j = (j + 0x9e3779b9u) % elems;
+                found += has(s,hits ? present_key(j) : key_at(j));
+            }
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double ns = elapsed.count() / lookups;
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    size_type found = 0;
+    std::printf("%10s %22s %22s %22s\n","elements","hash_set hit/miss","unordered_set hit/miss","list set hit/miss");
+    for (size_type elems = 10;elems<=10000000;elems*=10)
+    {
+        double hsHit, hsMiss, usHit, usMiss;
+        {
+            hash_set<uint64> hs;
+            for (size_type i = 0;i<elems;i++)
+                hs.insert(present_key(i));
+            hsHit = best_ns_per_lookup(hs,elems,true,found);
+            hsMiss = best_ns_per_lookup(hs,elems,false,found);
+        }
+        {
+            std::unordered_set<uint64> us;
+            for (size_type i = 0;i<elems;i++)
+                us.insert(present_key(i));
+            usHit = best_ns_per_lookup(us,elems,true,found);
+            usMiss = best_ns_per_lookup(us,elems,false,found);
+        }
+        std::printf("%10zu %10.1f %10.1f  %10.1f %10.1f",size_t(elems),hsHit,hsMiss,usHit,usMiss);
+        if (elems <= LIST_SET_LIMIT)
+        {
+            set<uint64> ls;
+            for (size_type i = 0;i<elems;i++)
+                ls.insert(present_key(i));
+            double lsHit = best_ns_per_lookup(ls,elems,true,found,LOOKUPS/64);
+            double lsMiss = best_ns_per_lookup(ls,elems,false,found,LOOKUPS/64);
+            std::printf("  %10.1f %10.1f",lsHit,lsMiss);
+        }
+        std::printf("  ns/lookup\n");
+    }
+    return found==0 ? 1 : 0;
+}
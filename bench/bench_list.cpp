@@ -0,0 +1,94 @@
+// bench_list.cpp - times list push, pop and iteration with nodes from the
+// global heap, with nodes from a node_pool, and with std::list
+#include "rlist.h"
+#include "rpool.h"
+#include <list>
+#include <chrono>
+#include <cstdio>
+using namespace rtypes;
+
+namespace
+{
+    const int NODES = 1 << 20;
+    const int ROUNDS = 7;
+
+    struct phase_times
+    {
+        double push, iterate, churn, clear;
+    };
+
+    double ns_since(std::chrono::steady_clock::time_point& start)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::chrono::duration<double,std::nano> elapsed = now-start;
+        start = now;
+        return elapsed.count() / NODES;
+    }
+
+    // (std::list has no pop that returns the element, so each kind of
+    // list is driven through these)
+    template<class L>
+    int pop_one(L& l)
+    { return l.pop_front(); }
+    int pop_one(std::list<int>& l)
+    {
+        int v = l.front();
+        l.pop_front();
+        return v;
+    }
+
+    // push NODES elements, sum them, then pop one and push one NODES times
+    // (so that freed nodes are reused), then clear the list
+    template<class L>
+    phase_times run(L& l,long long& sink)
+    {
+        phase_times best = {0,0,0,0};
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            phase_times t;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int i = 0;i<NODES;i++)
+                l.push_back(i);
+            t.push = ns_since(start);
+            for (typename L::iterator iter = l.begin();iter!=l.end();++iter)
+                sink += *iter;
+            t.iterate = ns_since(start);
+            for (int i = 0;i<NODES;i++)
+            {
+                sink += pop_one(l);
+                l.push_back(i);
+            }
+            t.churn = ns_since(start);
+            l.clear();
+            t.clear = ns_since(start);
+            if (r==0 || t.push<best.push)
+                best.push = t.push;
+            if (r==0 || t.iterate<best.iterate)
+                best.iterate = t.iterate;
+            if (r==0 || t.churn<best.churn)
+                best.churn = t.churn;
+            if (r==0 || t.clear<best.clear)
+                best.clear = t.clear;
+        }
+        return best;
+    }
+
+    void report(const char* name,const phase_times& t)
+    {
+        std::printf("%-16s push %6.2f  iterate %6.2f  pop+push %6.2f  clear %6.2f ns/node\n",
+            name,t.push,t.iterate,t.churn,t.clear);
+    }
+}
+
+int main()
+{
+    long long sink = 0;
+    list<int> heapList;
+    report("list (heap)",run(heapList,sink));
+    node_pool pool(1024);
+    list<int,pool_allocator> poolList( (pool_allocator(pool)) );
+    report("list (node_pool)",run(poolList,sink));
+    std::list<int> stdList;
+    report("std::list",run(stdList,sink));
+    return sink==0 ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+// bench_list_sort.cpp - times list::sort on sorted, reversed and random
+// input of 1K to 10M nodes (or up to the count given as the first argument)
+#include "rlist.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+using namespace rtypes;
+
+namespace
+{
+    const int ROUNDS = 3;
+
+    inline uint32 scatter(uint32 x)
+    {
+        x = (x ^ (x>>16)) * 0x45d9f3bu;
+        x = (x ^ (x>>16)) * 0x45d9f3bu;
+        return x ^ (x>>16);
+    }
+
+    enum order { SORTED, REVERSED, RANDOM };
+
+    double best_ns_per_node(size_type nodes,order o,bool& ok)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            list<uint32> l;
+            for (size_type i = 0;i<nodes;i++)
+                l.push_back(o==SORTED ? uint32(i) : o==REVERSED ? uint32(nodes-i) : scatter(uint32(i)));
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            l.sort();
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double ns = elapsed.count() / nodes;
+            uint32 prev = 0;
+            for (list<uint32>::iterator iter = l.begin();iter!=l.end();++iter)
+            {
+                ok = ok && prev<=*iter;
+                prev = *iter;
+            }
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+}
+
+int main(int argc,const char* argv[])
+{
+    size_type maxNodes = (argc>1 ? size_type(std::atol(argv[1])) : 10000000);
+    bool ok = true;
+    std::printf("%9s  %12s  %12s  %12s\n","nodes","sorted","reversed","random");
+    for (size_type nodes = 1000;nodes<=maxNodes;nodes*=10)
+    {
+        double s = best_ns_per_node(nodes,SORTED,ok);
+        double v = best_ns_per_node(nodes,REVERSED,ok);
+        double x = best_ns_per_node(nodes,RANDOM,ok);
+        std::printf("%9zu  %12.1f  %12.1f  %12.1f  ns/node\n",size_t(nodes),s,v,x);
+    }
+    if (!ok)
+        std::printf("a list was not sorted\n");
+    return ok ? 0 : 1;
+}
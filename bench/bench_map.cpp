@@ -0,0 +1,154 @@
+// bench_map.cpp - times map (the Swiss table) insertion and lookup against
+// a list of key/value pairs searched in order (what a program without an
+// associative container would use) and std::unordered_map
+#include "rmap.h"
+#include "rdynarray.h"
+#include "rlist.h"
+#include "rstring.h"
+#include <unordered_map>
+#include <string>
+#include <chrono>
+#include <cstdio>
+using namespace rtypes;
+
+namespace
+{
+    const size_type LOOKUPS = 1 << 20; // per round
+    const int ROUNDS = 5;
+    const size_type PAIR_LIST_LIMIT = 1000; // (its lookups are linear)
+
+    // the baseline: entries kept in a list and found by walking it
+    template<typename Key,typename Value>
+    class pair_list
+    {
+    public:
+        bool insert(const Key& key,const Value& value)
+        {
+            if ( contains(key) )
+                return false;
+            _Entry e = { key, value };
+            _entries.push_back(e);
+            return true;
+        }
+        bool contains(const Key& key) const
+        {
+            for (typename list<_Entry>::const_iterator iter = _entries.begin();iter!=_entries.end();++iter)
+                if (iter->key == key)
+                    return true;
+            return false;
+        }
+    private:
+        struct _Entry
+        {
+            Key key;
+            Value value;
+        };
+        list<_Entry> _entries;
+    };
+
+    inline uint64 scatter(uint64 x)
+    {
+        x = (x ^ (x>>30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x>>27)) * 0x94d049bb133111ebull;
+        return x ^ (x>>31);
+    }
+    // the keys of even numbers are inserted and those of odd numbers miss
+    inline uint64 present_key(size_type i)
+    { return scatter(2*uint64(i)); }
+    inline uint64 absent_key(size_type i)
+    { return scatter(2*uint64(i) + 1); }
+
+    template<class Map>
+    void add(Map& m,uint64 k,size_type v)
+    { m.insert(k,v); }
+    void add(std::unordered_map<uint64,size_type>& m,uint64 k,size_type v)
+    { m.insert(std::make_pair(k,v)); }
+    template<class Map>
+    bool has(const Map& m,uint64 k)
+    { return m.contains(k); }
+    bool has(const std::unordered_map<uint64,size_type>& m,uint64 k)
+    { return m.find(k) != m.end(); }
+
+    template<typename Fn>
+    double best_ns(Fn fn,size_type per)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            fn(r);
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double ns = elapsed.count() / per;
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+
+    // builds a map of 'elems' entries in each round (timing the inserts),
+    // then looks up present and absent keys in a pseudo-random order
+    template<class Map>
+    void run(const char* name,size_type elems,size_type lookups,size_type& found)
+    {
+        double insert = best_ns([&](int){
+            Map m;
+            for (size_type i = 0;i<elems;i++)
+                add(m,present_key(i),i);
+            found += has(m,present_key(0));
+        },elems);
+        Map m;
+        for (size_type i = 0;i<elems;i++)
+            add(m,present_key(i),i);
+        double hit = best_ns([&](int r){
+            for (size_type i = 0;i<lookups;i++)
+                found += has(m,present_key(scatter(r*lookups+i) % elems));
+        },lookups);
+        double miss = best_ns([&](int r){
+            for (size_type i = 0;i<lookups;i++)
+                found += has(m,absent_key(scatter(r*lookups+i) % elems));
+        },lookups);
+        std::printf("%8zu  %-14s insert %7.1f  hit %7.1f  miss %7.1f ns\n",size_t(elems),name,insert,hit,miss);
+    }
+}
+
+int main()
+{
+    size_type found = 0;
+    for (size_type elems = 10;elems<=1000000;elems*=10)
+    {
+        run< map<uint64,size_type> >("map",elems,LOOKUPS,found);
+        run< std::unordered_map<uint64,size_type> >("unordered_map",elems,LOOKUPS,found);
+        if (elems <= PAIR_LIST_LIMIT)
+            run< pair_list<uint64,size_type> >("pair list",elems,LOOKUPS/64,found);
+    }
+
+    // string keys, found by a str and by a C-string without making a key
+    const size_type WORDS = 100000;
+    map<str,size_type> words;
+    dynamic_array<str> names;
+    for (size_type i = 0;i<WORDS;i++)
+    {
+        char buf[32];
+        std::snprintf(buf,sizeof(buf),"identifier_%zu",size_t(present_key(i) % 1000000007u));
+        names.push_back(buf);
+        words.insert(names[i],i);
+    }
+    double byStr = best_ns([&](int r){
+        for (size_type i = 0;i<LOOKUPS;i++)
+            found += words.contains(names[scatter(r*LOOKUPS+i) % WORDS]);
+    },LOOKUPS);
+    double byChars = best_ns([&](int r){
+        for (size_type i = 0;i<LOOKUPS;i++)
+            found += words.contains(names[scatter(r*LOOKUPS+i) % WORDS].c_str());
+    },LOOKUPS);
+    std::unordered_map<std::string,size_type> stdWords;
+    for (size_type i = 0;i<WORDS;i++)
+        stdWords.insert(std::make_pair(std::string(names[i].c_str()),i));
+    double byStd = best_ns([&](int r){
+        for (size_type i = 0;i<LOOKUPS;i++)
+            found += stdWords.count(names[scatter(r*LOOKUPS+i) % WORDS].c_str());
+    },LOOKUPS);
+    std::printf("%8zu  map<str,...>   hit by str %7.1f  by const char* %7.1f ns\n",size_t(WORDS),byStr,byChars);
+    std::printf("%8zu  unordered_map<std::string,...>  by const char* %7.1f ns\n",size_t(WORDS),byStd);
+    return found==0 ? 1 : 0;
+}
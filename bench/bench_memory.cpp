@@ -0,0 +1,86 @@
+// bench_memory.cpp - times the block memory primitives (rutil_memcpy,
+// rutil_memmove, rutil_memcmp, rutil_memchr and rutil_memfill) against the
+// C library across block sizes, from the small-block path through the
+// non-temporal stores used for large copies and fills
+#include "rmemory.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+using namespace rtypes;
+
+namespace
+{
+    const size_type BYTES_PER_ROUND = size_type(256) << 20;
+    const int ROUNDS = 5;
+
+#if defined(__GNUC__)
+#define BENCH_CLOBBER() __asm__ __volatile__("" ::: "memory")
+#else
+#define BENCH_CLOBBER()
+#endif
+    // (the clobber after each pass keeps the compiler from reusing the
+    // result of a call that it can see has no side effects)
+
+    // returns the rate in GB/s of the best round
+    template<typename Fn>
+    double best_gbps(Fn fn,size_type n,size_type& sink)
+    {
+        size_type passes = BYTES_PER_ROUND/n > 0 ? BYTES_PER_ROUND/n : 1;
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_type p = 0;p<passes;p++)
+            {
+                sink += fn();
+                BENCH_CLOBBER();
+            }
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double gbps = double(n)*passes / elapsed.count();
+            if (gbps > best)
+                best = gbps;
+        }
+        return best;
+    }
+}
+
+int main(int argc,const char* argv[])
+{
+    size_type maxBytes = size_type(argc>1 ? std::atoi(argv[1]) : 16) << 20;
+    static const size_type SIZES[] = { 8, 64, 512, 4 << 10, 64 << 10, 1 << 20, 16 << 20 };
+    size_type sink = 0;
+    // (one extra byte lets memmove shift a block onto itself)
+    char* a = new char[maxBytes+1];
+    char* b = new char[maxBytes+1];
+    for (size_type i = 0;i<=maxBytes;i++)
+        a[i] = b[i] = char('a' + i%26);
+    std::printf("%9s  %-8s %8s %8s  (GB/s)\n","block","call","rutil","libc");
+    for (size_type k = 0;k<sizeof(SIZES)/sizeof(SIZES[0]) && SIZES[k]<=maxBytes;k++)
+    {
+        size_type n = SIZES[k];
+        double ours, libc;
+        ours = best_gbps([&](){ rutil_memcpy(b,a,n); return size_type(b[0]); },n,sink);
+        libc = best_gbps([&](){ std::memcpy(b,a,n); return size_type(b[0]); },n,sink);
+        std::printf("%9zu  %-8s %8.2f %8.2f\n",size_t(n),"memcpy",ours,libc);
+        // (alternating the direction keeps the contents from drifting)
+        size_type dir = 0;
+        ours = best_gbps([&](){ ++dir; rutil_memmove(a+(dir&1),a+1-(dir&1),n); return size_type(a[0]); },n,sink);
+        libc = best_gbps([&](){ ++dir; std::memmove(a+(dir&1),a+1-(dir&1),n); return size_type(a[0]); },n,sink);
+        std::printf("%9zu  %-8s %8.2f %8.2f\n",size_t(n),"memmove",ours,libc);
+        std::memcpy(b,a,maxBytes+1);
+        ours = best_gbps([&](){ return size_type(rutil_memcmp(a,b,n) == 0); },n,sink);
+        libc = best_gbps([&](){ return size_type(std::memcmp(a,b,n) == 0); },n,sink);
+        std::printf("%9zu  %-8s %8.2f %8.2f\n",size_t(n),"memcmp",ours,libc);
+        ours = best_gbps([&](){ return size_type(rutil_memchr(a,n,'#') == NULL); },n,sink);
+        libc = best_gbps([&](){ return size_type(std::memchr(a,'#',n) == NULL); },n,sink);
+        std::printf("%9zu  %-8s %8.2f %8.2f\n",size_t(n),"memchr",ours,libc);
+        ours = best_gbps([&](){ rutil_memfill(b,n,'z'); return size_type(b[0]); },n,sink);
+        libc = best_gbps([&](){ std::memset(b,'z',n); return size_type(b[0]); },n,sink);
+        std::printf("%9zu  %-8s %8.2f %8.2f\n",size_t(n),"memfill",ours,libc);
+        std::memcpy(b,a,maxBytes+1);
+    }
+    delete[] a;
+    delete[] b;
+    return sink==0 ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+// bench_moves.cpp - counts heap allocations and times the filename and
+// stream paths that hand strings to containers: names returned by
+// filename and rutil_to_lower, and lines read from a string stream; the
+// strings are longer than the inline capacity so that each one owns heap
+// storage that a move can take over
+#include "rfilename.h"
+#include "rstringstream.h"
+#include "rutility.h"
+#include "rdynarray.h"
+#include "rlist.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <utility>
+using namespace rtypes;
+
+// count every allocation that reaches the global heap
+static size_type allocations = 0;
+void* operator new(std::size_t bytes)
+{
+    ++allocations;
+    void* p = std::malloc(bytes>0 ? bytes : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept
+{ std::free(p); }
+
+namespace
+{
+    const size_type NAMES = 20000;
+    const size_type LINES = 50000;
+    const int ROUNDS = 7;
+
+    struct result
+    {
+        double ns; // per item, best round
+        double allocs; // per item
+    };
+
+    template<typename Fn>
+    result measure(Fn fn,size_type items)
+    {
+        result best = { 0, 0 };
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            size_type before = allocations;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            fn();
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double ns = elapsed.count() / items;
+            if (r==0 || ns<best.ns)
+                best.ns = ns;
+            best.allocs = double(allocations-before) / items;
+        }
+        return best;
+    }
+
+    void make_name(char* buf,size_type i)
+    {
+        std::sprintf(buf,"/home/Developer/Projects/RLibrary/Module%03u/SourceFile%05u.cpp",
+            unsigned(i%997),unsigned(i));
+    }
+
+    // the full name and the lower-case file name of each entry go into an
+    // array; the full name also goes into a list
+    size_type collect_names(dynamic_array<str>& names,list<str>& recent)
+    {
+        char buf[128];
+        size_type chars = 0;
+        for (size_type i = 0;i<NAMES;i++)
+        {
+            make_name(buf,i);
+            filename f(buf);
+            names.push_back( f.get_full_name() );
+            names.push_back( rutil_to_lower(f.get_name()) );
+            recent.push_back( f.get_full_name() );
+            chars += names[names.size()-1].length();
+        }
+        return chars;
+    }
+
+    // each line read from the stream is moved into the array
+    size_type collect_lines(const str& text,dynamic_array<str>& lines)
+    {
+        const_stringstream ss(text);
+        str line;
+        size_type chars = 0;
+        while (true)
+        {
+            ss.getline(line);
+            if ( !ss.get_input_success() )
+                break;
+            chars += line.length();
+            lines.push_back( std::move(line) );
+        }
+        return chars;
+    }
+}
+
+int main()
+{
+    str text;
+    char buf[128];
+    for (size_type i = 0;i<LINES;i++)
+    {
+        make_name(buf,i);
+        text += "include ";
+        text += buf;
+        text += '\n';
+    }
+
+    size_type sink = 0;
+    // (each round keeps its containers so that it fills fresh memory)
+    dynamic_array<str> names[ROUNDS], lines[ROUNDS];
+    list<str> recent[ROUNDS];
+    int r = 0;
+    result byName = measure([&](){ sink += collect_names(names[r],recent[r]); ++r; },NAMES);
+    r = 0;
+    result byLine = measure([&](){ sink += collect_lines(text,lines[r]); ++r; },LINES);
+    std::printf("filename -> array/list: %7.1f ns/name, %5.2f allocations/name\n",byName.ns,byName.allocs);
+    std::printf("stream getline -> array: %6.1f ns/line, %5.2f allocations/line\n",byLine.ns,byLine.allocs);
+    return sink==0 ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+// bench_mpmc_queue.cpp - times an mpmc_queue shared by 1 to N producer and
+// N consumer threads, against a mutex-guarded queue, to show how each
+// holds up as contention grows
+#include "rconqueue.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+using namespace rtypes;
+
+namespace
+{
+    const size_type CAPACITY = 1024;
+    const size_type ELEMENTS = 1 << 21; // per round, split among the producers
+    const int ROUNDS = 3;
+
+    // the baseline: a bounded queue behind one mutex
+    class locked_queue
+    {
+    public:
+        explicit locked_queue(size_type capacity)
+            : _capacity(capacity) {}
+        void push(uint64 elem)
+        {
+            _rcon_backoff backoff;
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_q.size() < _capacity)
+                    {
+                        _q.push(elem);
+                        return;
+                    }
+                }
+                backoff.wait();
+            }
+        }
+        uint64 pop()
+        {
+            _rcon_backoff backoff;
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if ( !_q.is_empty() )
+                        return _q.pop();
+                }
+                backoff.wait();
+            }
+        }
+    private:
+        std::mutex _mutex;
+        queue<uint64> _q;
+        size_type _capacity;
+    };
+
+    // each of 'pairs' producers pushes its share of the elements and each
+    // consumer pops as many; returns the best time per element
+    template<class Q>
+    double ns_per_element(int pairs,uint64& sink)
+    {
+        double best = 0;
+        size_type share = ELEMENTS / pairs;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            Q q(CAPACITY);
+            std::atomic<uint64> sum(0);
+            std::vector<std::thread> threads;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int t = 0;t<pairs;t++)
+            {
+                threads.push_back( std::thread([&q,share](){
+                    for (size_type i = 0;i<share;i++)
+                        q.push(i);
+                }) );
+                threads.push_back( std::thread([&q,&sum,share](){
+                    uint64 local = 0;
+                    for (size_type i = 0;i<share;i++)
+                        local += q.pop();
+                    sum += local;
+                }) );
+            }
+            for (size_t t = 0;t<threads.size();t++)
+                threads[t].join();
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double ns = elapsed.count() / (share*pairs);
+            sink += sum;
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+}
+
+int main(int argc,const char* argv[])
+{
+    int maxPairs = (argc>1 ? std::atoi(argv[1]) : int(std::thread::hardware_concurrency()));
+    uint64 sink = 0;
+    if (maxPairs < 1)
+        maxPairs = 1;
+    std::printf("(%u hardware threads)\n",std::thread::hardware_concurrency());
+    std::printf("producers+consumers  mpmc_queue ns/element  mutex+queue ns/element\n");
+    for (int pairs = 1;pairs<=maxPairs;pairs*=2)
+        std::printf("%9d+%-9d  %22.1f  %22.1f\n",pairs,pairs,ns_per_element< mpmc_queue<uint64> >(pairs,sink),
+            ns_per_element<locked_queue>(pairs,sink));
+    return sink==0 ? 1 : 0;
+}
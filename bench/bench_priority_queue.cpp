@@ -0,0 +1,108 @@
+// bench_priority_queue.cpp - times the heap priority_queue and the
+// bucket_priority_queue with many distinct priorities (like timestamps or
+// deadlines) and with a few coarse priorities, against std::priority_queue
+#include "rqueue.h"
+#include <queue>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+using namespace rtypes;
+
+namespace
+{
+    const int ROUNDS = 5;
+    const size_type BUCKET_DISTINCT_LIMIT = 10000; // (a new priority costs O(k))
+    const uint64 COARSE_LEVELS = 8;
+
+    inline uint64 scatter(uint64 x)
+    {
+        x = (x ^ (x>>30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x>>27)) * 0x94d049bb133111ebull;
+        return x ^ (x>>31);
+    }
+
+    // std::priority_queue, given the same push(elem,priority) and pop()
+    class std_queue
+    {
+    public:
+        void push(uint64 elem,uint64 priority)
+        { _q.push(std::make_pair(priority,elem)); }
+        uint64 pop()
+        {
+            uint64 elem = _q.top().second;
+            _q.pop();
+            return elem;
+        }
+    private:
+        std::priority_queue< std::pair<uint64,uint64> > _q;
+    };
+
+    // pushes 'n' elements with priorities from 'prio' and then pops them
+    // all; returns the best time per element for the pushes and the pops
+    template<class Q,typename Prio>
+    void run(const char* name,size_type n,Prio prio,uint64& sink)
+    {
+        double bestPush = 0, bestPop = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            Q q;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_type i = 0;i<n;i++)
+                q.push(i,prio(i));
+            std::chrono::steady_clock::time_point mid = std::chrono::steady_clock::now();
+            for (size_type i = 0;i<n;i++)
+                sink += q.pop();
+            std::chrono::duration<double,std::nano> push = mid-start, pop = std::chrono::steady_clock::now()-mid;
+            if (r==0 || push.count()<bestPush*n)
+                bestPush = push.count() / n;
+            if (r==0 || pop.count()<bestPop*n)
+                bestPop = pop.count() / n;
+        }
+        std::printf("%8zu  %-22s push %7.1f  pop %7.1f ns\n",size_t(n),name,bestPush,bestPop);
+    }
+
+    uint64 distinct(size_type i)
+    { return scatter(i); }
+    uint64 coarse(size_type i)
+    { return scatter(i) % COARSE_LEVELS; }
+}
+
+int main()
+{
+    uint64 sink = 0;
+    std::printf("distinct priorities:\n");
+    for (size_type n = 1000;n<=1000000;n*=10)
+    {
+        run< priority_queue<uint64,uint64> >("priority_queue (heap)",n,&distinct,sink);
+        if (n <= BUCKET_DISTINCT_LIMIT)
+            run< bucket_priority_queue<uint64,uint64> >("bucket_priority_queue",n,&distinct,sink);
+        run<std_queue>("std::priority_queue",n,&distinct,sink);
+    }
+    std::printf("%u coarse priorities:\n",unsigned(COARSE_LEVELS));
+    for (size_type n = 1000;n<=1000000;n*=10)
+    {
+        run< priority_queue<uint64,uint64> >("priority_queue (heap)",n,&coarse,sink);
+        run< bucket_priority_queue<uint64,uint64> >("bucket_priority_queue",n,&coarse,sink);
+        run<std_queue>("std::priority_queue",n,&coarse,sink);
+    }
+
+    // decrease-key: change the priority of random elements through their handles
+    const size_type HELD = 100000, UPDATES = 1000000;
+    priority_queue<uint64,uint64> q;
+    std::vector<priority_queue<uint64,uint64>::handle> handles;
+    for (size_type i = 0;i<HELD;i++)
+        handles.push_back( q.push(i,distinct(i)) );
+    double bestUpdate = 0;
+    for (int r = 0;r<ROUNDS;r++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_type i = 0;i<UPDATES;i++)
+            q.update(handles[scatter(r*UPDATES+i) % HELD],distinct(HELD+r*UPDATES+i));
+        std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+        if (r==0 || elapsed.count()<bestUpdate*UPDATES)
+            bestUpdate = elapsed.count() / UPDATES;
+    }
+    std::printf("%8zu  priority_queue update   %7.1f ns\n",size_t(HELD),bestUpdate);
+    sink += q.top();
+    return sink==0 ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+// bench_spsc_queue.cpp - times an spsc_queue between two threads pinned to
+// different CPUs (when there are two): throughput for single and bulk
+// operations, and the latency of a round trip through a pair of queues;
+// a mutex-guarded queue gives the baseline
+#include "rconqueue.h"
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <pthread.h>
+#include <sched.h>
+using namespace rtypes;
+
+namespace
+{
+    const size_type CAPACITY = 1024;
+    const size_type ELEMENTS = 1 << 22; // per round
+    const size_type BATCH = 64;
+    const size_type ROUND_TRIPS = 1 << 16;
+    const int ROUNDS = 5;
+
+    // the CPUs that this process may run on, in order
+    int cpus[2];
+    int cpuCount = 0;
+
+    void find_cpus()
+    {
+        cpu_set_t set;
+        if (sched_getaffinity(0,sizeof(set),&set) != 0)
+            return;
+        for (int c = 0;c<CPU_SETSIZE && cpuCount<2;c++)
+            if ( CPU_ISSET(c,&set) )
+                cpus[cpuCount++] = c;
+    }
+    void pin(std::thread& t,int which)
+    {
+        if (cpuCount == 0)
+            return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[which % cpuCount],&set);
+        pthread_setaffinity_np(t.native_handle(),sizeof(set),&set);
+    }
+
+    // the baseline: a queue behind a mutex (the consumer spins on it)
+    class locked_queue
+    {
+    public:
+        explicit locked_queue(size_type)
+        {}
+        void push(uint64 elem)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _q.push(elem);
+        }
+        uint64 pop()
+        {
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if ( !_q.is_empty() )
+                        return _q.pop();
+                }
+                std::this_thread::yield();
+            }
+        }
+    private:
+        std::mutex _mutex;
+        queue<uint64> _q;
+    };
+
+    // runs 'produce' and 'consume' on two pinned threads; returns the time
+    // in nanoseconds until both finish
+    template<typename P,typename C>
+    double time_pair(P produce,C consume)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::thread producer(produce), consumer(consume);
+        pin(producer,0);
+        pin(consumer,1);
+        producer.join();
+        consumer.join();
+        std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+        return elapsed.count();
+    }
+
+    template<class Q>
+    double single_ns(uint64& sink)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            Q q(CAPACITY);
+            uint64 sum = 0;
+            double ns = time_pair([&q](){
+                for (size_type i = 0;i<ELEMENTS;i++)
+                    q.push(i);
+            },[&q,&sum](){
+                for (size_type i = 0;i<ELEMENTS;i++)
+                    sum += q.pop();
+            }) / ELEMENTS;
+            sink += sum;
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+
+    double batch_ns(uint64& sink)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            spsc_queue<uint64> q(CAPACITY);
+            uint64 sum = 0;
+            double ns = time_pair([&q](){
+                uint64 elems[BATCH];
+                for (size_type i = 0;i<ELEMENTS;)
+                {
+                    size_type cnt = (ELEMENTS-i<BATCH ? ELEMENTS-i : BATCH);
+                    for (size_type k = 0;k<cnt;k++)
+                        elems[k] = i+k;
+                    size_type done = 0;
+                    _rcon_backoff backoff;
+                    while ((done += q.push_range(elems+done,cnt-done)) < cnt)
+                        backoff.wait();
+                    i += cnt;
+                }
+            },[&q,&sum](){
+                uint64 elems[BATCH];
+                _rcon_backoff backoff;
+                for (size_type i = 0;i<ELEMENTS;)
+                {
+                    size_type got = q.pop_range(elems,BATCH);
+                    if (got == 0)
+                        backoff.wait();
+                    for (size_type k = 0;k<got;k++)
+                        sum += elems[k];
+                    i += got;
+                }
+            }) / ELEMENTS;
+            sink += sum;
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+
+    // one thread sends a value through one queue and waits for it to come
+    // back through the other
+    double round_trip_ns()
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            spsc_queue<uint64> there(CAPACITY), back(CAPACITY);
+            double ns = time_pair([&](){
+                for (size_type i = 0;i<ROUND_TRIPS;i++)
+                {
+                    there.push(i);
+                    back.pop();
+                }
+            },[&](){
+                for (size_type i = 0;i<ROUND_TRIPS;i++)
+                    back.push(there.pop());
+            }) / ROUND_TRIPS;
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    uint64 sink = 0;
+    find_cpus();
+    if (cpuCount < 2)
+        std::printf("(only one CPU is available: both threads share it)\n");
+    else
+        std::printf("(producer on CPU %d, consumer on CPU %d)\n",cpus[0],cpus[1]);
+    std::printf("spsc_queue push/pop:             %7.1f ns/element\n",single_ns< spsc_queue<uint64> >(sink));
+    std::printf("spsc_queue push_range/pop_range: %7.1f ns/element (batches of %zu)\n",batch_ns(sink),size_t(BATCH));
+    std::printf("mutex + queue push/pop:          %7.1f ns/element\n",single_ns<locked_queue>(sink));
+    std::printf("spsc_queue round trip:           %7.1f ns\n",round_trip_ns());
+    return sink==0 ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+// bench_string_append.cpp - times per-character string writes through the
+// generic_string interface (the path that the string core's exclusive flag
+// makes direct) and through a string stream
+#include "rstring.h"
+#include "rstringstream.h"
+#include <chrono>
+#include <cstdio>
+using namespace rtypes;
+
+namespace
+{
+    // the string stays small enough for the cache so that the time is
+    // that of the calls rather than of memory
+    const size_type CHARS = 1 << 16;
+    const int PASSES = 256; // per round
+    const int ROUNDS = 15;
+
+    // (the string is passed by its base, and the calls are kept out of
+    // line, so that the compiler cannot see the string's type and the
+    // writes go through the generic interface as they do in library code)
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+    BENCH_NOINLINE void push_chars(generic_string& s)
+    {
+        for (size_type i = 0;i<CHARS;i++)
+            s.push_back(char('a' + i%26));
+    }
+    BENCH_NOINLINE void overwrite_chars(generic_string& s)
+    {
+        for (size_type i = 0;i<s.length();i++)
+            s[i] = char('A' + i%26);
+    }
+    void stream_chars(stringstream& ss)
+    {
+        for (size_type i = 0;i<CHARS/64;i++)
+            ss << char('a' + i%26);
+    }
+
+    template<typename Fn>
+    double best_ns_per_char(Fn fn,size_type chars)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int p = 0;p<PASSES;p++)
+                fn();
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double ns = elapsed.count() / (double(chars)*PASSES);
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    str target;
+    double push = best_ns_per_char([&](){ target.clear(); push_chars(target); },CHARS);
+    double overwrite = best_ns_per_char([&](){ overwrite_chars(target); },CHARS);
+    double stream = best_ns_per_char([](){ stringstream ss; stream_chars(ss); },CHARS/64);
+    std::printf("push_back via generic_string&:  %6.2f ns/char\n",push);
+    std::printf("operator[] via generic_string&: %6.2f ns/char\n",overwrite);
+    std::printf("stringstream << char:           %6.2f ns/char\n",stream);
+    return target[0]=='A' ? 0 : 1;
+}
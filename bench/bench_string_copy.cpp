@@ -0,0 +1,56 @@
+// bench_string_copy.cpp - times copies of a shared 1MB string made by several
+// threads at once, for deep_string (which copies the characters) and
+// shallow_string (which shares the buffer through its atomic reference count)
+#include "rstring.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+using namespace rtypes;
+
+namespace
+{
+    const size_type BLOB_SIZE = 1 << 20;
+    // copies per thread (a deep copy moves the whole megabyte)
+    const int DEEP_COPIES = 500;
+    const int SHALLOW_COPIES = 1000000;
+
+    template<typename String>
+    double copies_per_second(const String& blob,int threads,int copies)
+    {
+        std::vector<std::thread> workers;
+        std::vector<size_type> sums(threads);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int t = 0;t<threads;t++)
+            workers.push_back( std::thread([&blob,&sums,t,copies](){
+                size_type sum = 0;
+                for (int i = 0;i<copies;i++)
+                {
+                    String copy(blob);
+                    sum += size_type(copy.c_str()[i % BLOB_SIZE]); // read the copy
+                }
+                sums[t] = sum;
+            }) );
+        for (int t = 0;t<threads;t++)
+            workers[t].join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now()-start;
+        return copies*threads / elapsed.count();
+    }
+}
+
+int main(int argc,const char* argv[])
+{
+    int maxThreads = (argc>1 ? std::atoi(argv[1]) : 8);
+    deep_string<char> deep;
+    deep.resize(BLOB_SIZE);
+    for (size_type i = 0;i<BLOB_SIZE;i++)
+        deep[i] = char('a' + i%26);
+    shallow_string<char> shallow(deep);
+    copies_per_second(shallow,1,SHALLOW_COPIES); // (warm up)
+    std::printf("threads  deep_string copies/s  shallow_string copies/s\n");
+    for (int threads = 1;threads<=maxThreads;threads*=2)
+        std::printf("%7d  %20.0f  %23.0f\n",threads,copies_per_second(deep,threads,DEEP_COPIES),
+            copies_per_second(shallow,threads,SHALLOW_COPIES));
+    return 0;
+}
@@ -0,0 +1,103 @@
+// bench_string_kernels.cpp - times the rutility string kernels (rutil_strlen,
+// rutil_strcmp, rutil_strncpy, case conversion and whitespace stripping)
+// next to the C library's counterparts; build it against an older tree to
+// compare the kernels with the versions they replaced
+#include "rutility.h"
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+using namespace rtypes;
+
+namespace
+{
+    const size_type BYTES_PER_ROUND = size_type(64) << 20;
+    const int ROUNDS = 5;
+
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#define BENCH_CLOBBER() __asm__ __volatile__("" ::: "memory")
+#else
+#define BENCH_NOINLINE
+#define BENCH_CLOBBER()
+#endif
+    // (the clobber after each pass keeps the compiler from reusing the
+    // result of a call that it can see has no side effects)
+
+    // the C library has no string case conversion, so its column uses
+    // the per-character loop that callers would write
+    BENCH_NOINLINE void libc_to_lower(char* s,size_type n)
+    {
+        for (size_type i = 0;i<n;i++)
+            s[i] = char(std::tolower((unsigned char)s[i]));
+    }
+
+    // returns the rate in GB/s (of the string's length) of the best round
+    template<typename Fn>
+    double best_gbps(Fn fn,size_type n,size_type& sink)
+    {
+        size_type passes = BYTES_PER_ROUND/n > 0 ? BYTES_PER_ROUND/n : 1;
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_type p = 0;p<passes;p++)
+            {
+                sink += fn();
+                BENCH_CLOBBER();
+            }
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double gbps = double(n)*passes / elapsed.count();
+            if (gbps > best)
+                best = gbps;
+        }
+        return best;
+    }
+
+    void report(const char* name,size_type n,double ours,double libc)
+    {
+        if (libc > 0)
+            std::printf("%8zuB  %-22s %8.2f %8.2f\n",size_t(n),name,ours,libc);
+        else
+            std::printf("%8zuB  %-22s %8.2f %8s\n",size_t(n),name,ours,"-");
+    }
+}
+
+int main()
+{
+    static const size_type SIZES[] = { 16, 256, 4 << 10, 1 << 20 };
+    size_type sink = 0;
+    std::printf("%9s  %-22s %8s %8s  (GB/s)\n","string","kernel","rutil","libc");
+    for (size_type k = 0;k<sizeof(SIZES)/sizeof(SIZES[0]);k++)
+    {
+        size_type n = SIZES[k];
+        // mixed-case text (a copy of it for comparisons) and a destination
+        char* a = new char[n+1];
+        char* b = new char[n+1];
+        char* dst = new char[n+1];
+        for (size_type i = 0;i<n;i++)
+            a[i] = b[i] = (i%7 == 6) ? ' ' : char((i%2 ? 'a' : 'A') + i%26);
+        a[n] = b[n] = 0;
+        str text(a);
+        str padded("        ");
+        padded += text;
+        padded += "        ";
+
+        report("strlen",n,best_gbps([&](){ return rutil_strlen(a); },n,sink),
+            best_gbps([&](){ return std::strlen(a); },n,sink));
+        report("strcmp (equal)",n,best_gbps([&](){ return size_type(rutil_strcmp(a,b)); },n,sink),
+            best_gbps([&](){ return size_type(std::strcmp(a,b) == 0); },n,sink));
+        report("strncpy",n,best_gbps([&](){ return rutil_strncpy(dst,a,n+1); },n,sink),
+            best_gbps([&](){ std::strncpy(dst,a,n+1); return size_type(dst[0]); },n,sink));
+        report("to_lower_ref",n,best_gbps([&](){ rutil_to_lower_ref(text); return size_type(text[0]); },n,sink),
+            best_gbps([&](){ libc_to_lower(dst,n); return size_type(dst[0]); },n,sink));
+        report("to_lower (new string)",n,best_gbps([&](){ return rutil_to_lower(text).length(); },n,sink),0);
+        report("strip_whitespace",n,best_gbps([&](){ return rutil_strip_whitespace(padded).length(); },n,sink),0);
+
+        delete[] a;
+        delete[] b;
+        delete[] dst;
+    }
+    return sink==0 ? 1 : 0;
+}
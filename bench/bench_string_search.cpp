@@ -0,0 +1,126 @@
+// bench_string_search.cpp - times the string search members (find of a
+// character and of a substring, and find_first_of) against the per-character
+// loops that callers wrote before those members existed, and against glibc;
+// each search scans a whole haystack of random words for something absent
+#include "rstring.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+using namespace rtypes;
+
+namespace
+{
+    const size_type BYTES_PER_ROUND = size_type(32) << 20; // (at least one pass)
+    const int ROUNDS = 5;
+    const char NEEDLE_CHAR = '#';
+    const char* const NEEDLE = "needle";
+    const char* const SET = "#$%&";
+
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#define BENCH_CLOBBER() __asm__ __volatile__("" ::: "memory")
+#else
+#define BENCH_NOINLINE
+#define BENCH_CLOBBER()
+#endif
+    // (the clobber after each pass keeps the compiler from reusing the
+    // result of a search that it can see has no side effects)
+
+    // the loops take the string by its base as library callers did
+    BENCH_NOINLINE size_type naive_find(const generic_string& s,char c)
+    {
+        for (size_type i = 0;i<s.length();i++)
+            if (s[i] == c)
+                return i;
+        return generic_string::npos;
+    }
+    BENCH_NOINLINE size_type naive_find(const generic_string& s,const char* needle)
+    {
+        size_type m = std::strlen(needle);
+        for (size_type i = 0;i+m<=s.length();i++)
+        {
+            size_type j = 0;
+            while (j<m && s[i+j]==needle[j])
+                ++j;
+            if (j == m)
+                return i;
+        }
+        return generic_string::npos;
+    }
+    BENCH_NOINLINE size_type naive_find_first_of(const generic_string& s,const char* set)
+    {
+        for (size_type i = 0;i<s.length();i++)
+            for (const char* p = set;*p != 0;++p)
+                if (s[i] == *p)
+                    return i;
+        return generic_string::npos;
+    }
+
+    uint64 scatter(uint64 x) // splitmix64
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // returns the scan rate in GB/s of the best round
+    template<typename Fn>
+    double best_gbps(Fn fn,size_type n,size_type& sink)
+    {
+        size_type passes = BYTES_PER_ROUND/n > 0 ? BYTES_PER_ROUND/n : 1;
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_type p = 0;p<passes;p++)
+            {
+                sink += fn();
+                BENCH_CLOBBER();
+            }
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double gbps = double(n)*passes / elapsed.count();
+            if (gbps > best)
+                best = gbps;
+        }
+        return best;
+    }
+}
+
+int main(int argc,const char* argv[])
+{
+    size_type maxBytes = size_type(argc>1 ? std::atoi(argv[1]) : 100) << 20;
+    static const size_type SIZES[] = { 1 << 10, 64 << 10, 1 << 20, 100 << 20 };
+    size_type sink = 0;
+    std::printf("%10s  %-14s %8s %8s %8s  (GB/s)\n","haystack","search","naive","rlibrary","glibc");
+    for (size_type k = 0;k<sizeof(SIZES)/sizeof(SIZES[0]) && SIZES[k]<=maxBytes;k++)
+    {
+        size_type n = SIZES[k];
+        str hay;
+        hay.resize(n);
+        for (size_type i = 0;i<n;i++)
+        {
+            uint64 x = scatter(i) % 27;
+            hay[i] = x==26 ? ' ' : char('a'+x);
+        }
+        const char* h = hay.c_str();
+        size_type needleLen = std::strlen(NEEDLE);
+
+        double naive = best_gbps([&](){ return naive_find(hay,NEEDLE_CHAR); },n,sink);
+        double ours = best_gbps([&](){ return hay.find(NEEDLE_CHAR); },n,sink);
+        double libc = best_gbps([&](){ return size_type(std::memchr(h,NEEDLE_CHAR,n) != NULL); },n,sink);
+        std::printf("%8zuKB  %-14s %8.2f %8.2f %8.2f\n",size_t(n>>10),"find(char)",naive,ours,libc);
+
+        naive = best_gbps([&](){ return naive_find(hay,NEEDLE); },n,sink);
+        ours = best_gbps([&](){ return hay.find(NEEDLE); },n,sink);
+        libc = best_gbps([&](){ return size_type(memmem(h,n,NEEDLE,needleLen) != NULL); },n,sink);
+        std::printf("%8zuKB  %-14s %8.2f %8.2f %8.2f\n",size_t(n>>10),"find(string)",naive,ours,libc);
+
+        naive = best_gbps([&](){ return naive_find_first_of(hay,SET); },n,sink);
+        ours = best_gbps([&](){ return hay.find_first_of(SET); },n,sink);
+        libc = best_gbps([&](){ return std::strcspn(h,SET); },n,sink);
+        std::printf("%8zuKB  %-14s %8.2f %8.2f %8.2f\n",size_t(n>>10),"find_first_of",naive,ours,libc);
+    }
+    return sink==0 ? 1 : 0;
+}
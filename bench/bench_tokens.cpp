@@ -0,0 +1,99 @@
+// bench_tokens.cpp - counts heap allocations and times a tokenizer that
+// builds a str for each token of a text and keeps the tokens in an array;
+// most tokens are short enough to be stored inline in the string object
+#include "rstring.h"
+#include "rdynarray.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+using namespace rtypes;
+
+// count every allocation that reaches the global heap
+static size_type allocations = 0;
+void* operator new(std::size_t bytes)
+{
+    ++allocations;
+    void* p = std::malloc(bytes>0 ? bytes : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept
+{ std::free(p); }
+
+namespace
+{
+    const size_type TEXT_SIZE = 1 << 20;
+    const int ROUNDS = 7;
+
+    // a text of identifiers, numbers and operators; a few identifiers
+    // are longer than the inline capacity
+    void make_text(char* text,size_type n)
+    {
+        static const char* const WORDS[] = { "x", "i", "count", "=", "+", "(", ")", ";", "42", "3.14159",
+            "return", "index_of_first_element", "while", "{", "}", "buffer_length_in_characters_total" };
+        const size_type WORD_COUNT = sizeof(WORDS)/sizeof(WORDS[0]);
+        size_type i = 0, w = 0;
+        while (true)
+        {
+            const char* word = WORDS[(w*7 + w/3) % WORD_COUNT];
+            size_type len = 0;
+            while (word[len] != 0)
+                ++len;
+            if (i+len+1 >= n)
+                break;
+            for (size_type k = 0;k<len;k++)
+                text[i++] = word[k];
+            text[i++] = ' ';
+            ++w;
+        }
+        text[i] = 0;
+    }
+
+    size_type tokenize(const char* text,dynamic_array<str>& tokens)
+    {
+        size_type chars = 0;
+        for (const char* p = text;*p != 0;)
+        {
+            while (*p == ' ')
+                ++p;
+            if (*p == 0)
+                break;
+            str token;
+            while (*p!=' ' && *p!=0)
+                token.push_back(*p++);
+            chars += token.length();
+            tokens.push_back(token);
+        }
+        return chars;
+    }
+}
+
+int main()
+{
+    static char text[TEXT_SIZE];
+    make_text(text,TEXT_SIZE);
+    size_type chars = 0, tokenCount = 0, allocs = 0;
+    double best = 0;
+    // every round keeps its tokens so that each one fills fresh memory; a
+    // freed array would otherwise be reused or trimmed depending on what
+    // else the heap holds, which makes the rounds hard to compare
+    dynamic_array<str> kept[ROUNDS];
+    for (int r = 0;r<ROUNDS;r++)
+    {
+        dynamic_array<str>& tokens = kept[r];
+        size_type before = allocations;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        chars += tokenize(text,tokens);
+        std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+        allocs = allocations-before;
+        tokenCount = tokens.size();
+        double ns = elapsed.count() / tokenCount;
+        if (r==0 || ns<best)
+            best = ns;
+    }
+    std::printf("%zu tokens: %.1f ns/token, %.2f allocations/token (%zu in all)\n",
+        size_t(tokenCount),best,double(allocs)/tokenCount,size_t(allocs));
+    return chars==0 ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+// bench_tree_map.cpp - times ordered lookups and scans of a tree_map (the
+// B+tree) with millions of keys against std::map
+#include "rtree.h"
+#include <map>
+#include <chrono>
+#include <cstdio>
+using namespace rtypes;
+
+namespace
+{
+    const size_type LOOKUPS = 1 << 20; // per round
+    const size_type SCAN_LENGTH = 100;
+    const int ROUNDS = 5;
+
+    // the even numbers are the keys, so that odd numbers fall between them
+    inline uint64 key_at(size_type i)
+    { return 2*uint64(i); }
+
+    // a pseudo-random index below 'n' for the i-th lookup (the splitmix64
+    // finalizer, so that lookups do not visit the leaves in a pattern)
+    inline size_type pick(uint64 i,size_type n)
+    {
+        i = (i ^ (i>>30)) * 0xbf58476d1ce4e5b9ull;
+        i = (i ^ (i>>27)) * 0x94d049bb133111ebull;
+        return size_type( (i ^ (i>>31)) % n );
+    }
+
+    template<class Iter>
+    const uint64& key_of(Iter iter)
+    { return iter.key(); }
+    const uint64& key_of(std::map<uint64,uint64>::const_iterator iter)
+    { return iter->first; }
+    template<class Iter>
+    const uint64& value_of(Iter iter)
+    { return iter.value(); }
+    const uint64& value_of(std::map<uint64,uint64>::const_iterator iter)
+    { return iter->second; }
+
+    struct phase_times
+    {
+        double find, bound, range, scan;
+    };
+
+    template<typename Fn>
+    double best_ns(Fn fn,size_type per)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            fn(r);
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now()-start;
+            double ns = elapsed.count() / per;
+            if (r==0 || ns<best)
+                best = ns;
+        }
+        return best;
+    }
+
+    // random finds of present keys, lower_bound of absent keys, short
+    // range scans from a lower_bound, and a scan of the whole map
+    template<class Map>
+    phase_times run(const Map& m,size_type keys,uint64& sink)
+    {
+        typedef typename Map::const_iterator iter_t;
+        phase_times t;
+        t.find = best_ns([&](int r){
+            for (size_type i = 0;i<LOOKUPS;i++)
+                sink += value_of(m.find(key_at(pick(r*LOOKUPS+i,keys))));
+        },LOOKUPS);
+        t.bound = best_ns([&](int r){
+            for (size_type i = 0;i<LOOKUPS;i++)
+                sink += key_of(m.lower_bound(key_at(pick(r*LOOKUPS+i,keys-1))+1));
+        },LOOKUPS);
+        t.range = best_ns([&](int r){
+            for (size_type i = 0;i<LOOKUPS/SCAN_LENGTH;i++)
+            {
+                iter_t iter = m.lower_bound(key_at(pick(r*LOOKUPS+i,keys-SCAN_LENGTH)));
+                for (size_type k = 0;k<SCAN_LENGTH;k++,++iter)
+                    sink += value_of(iter);
+            }
+        },LOOKUPS);
+        t.scan = best_ns([&](int){
+            for (iter_t iter = m.begin();iter!=m.end();++iter)
+                sink += value_of(iter);
+        },keys);
+        return t;
+    }
+
+    void report(const char* name,size_type keys,const phase_times& t)
+    {
+        std::printf("%-9s %8zu keys: find %6.1f  lower_bound %6.1f  100-key range %5.1f  full scan %5.1f ns/key\n",
+            name,size_t(keys),t.find,t.bound,t.range,t.scan);
+    }
+}
+
+int main()
+{
+    uint64 sink = 0;
+    for (size_type keys = 1000000;keys<=8000000;keys*=2)
+    {
+        {
+            tree_map<uint64,uint64> tm;
+            for (size_type i = 0;i<keys;i++)
+                tm.insert(key_at(i),i);
+            const tree_map<uint64,uint64>& ctm = tm;
+            report("tree_map",keys,run(ctm,keys,sink));
+        }
+        {
+            std::map<uint64,uint64> sm;
+            for (size_type i = 0;i<keys;i++)
+                sm.insert(std::make_pair(key_at(i),uint64(i)));
+            const std::map<uint64,uint64>& csm = sm;
+            report("std::map",keys,run(csm,keys,sink));
+        }
+    }
+    return sink==0 ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+// bench_utf8.cpp - times UTF-8 validation and UTF-8 <-> wide string
+// transcoding on log-like text that is all ASCII or almost all ASCII, against
+// the per-character loops that user code wrote before and against the C
+// library's multibyte conversions; also times reading the text by lines from
+// a string stream with and without the UTF-8 filter
+#include "rutility.h"
+#include "rstringstream.h"
+#include <chrono>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+using namespace rtypes;
+
+namespace
+{
+    const size_type TEXT_SIZE = 1 << 20;
+    const int PASSES = 16; // per round
+    const int ROUNDS = 5;
+
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#define BENCH_CLOBBER() __asm__ __volatile__("" ::: "memory")
+#else
+#define BENCH_NOINLINE
+#define BENCH_CLOBBER()
+#endif
+    // (the clobber after each pass keeps the compiler from reusing the
+    // result of a call that it can see has no side effects)
+
+    // the per-character loops: decode a sequence at a time (rejecting
+    // overlong forms, surrogates and values past U+10FFFF) and encode a
+    // character at a time, appending to the result
+    size_type naive_decode(const char* s,size_type n,size_type i,uint32& cp)
+    {
+        static const uint32 MIN[] = { 0, 0x80, 0x800, 0x10000 };
+        byte b = byte(s[i]);
+        size_type len = b<0x80 ? 1 : b<0xc2 ? 0 : b<0xe0 ? 2 : b<0xf0 ? 3 : b<0xf5 ? 4 : 0;
+        if (len==0 || i+len>n)
+            return 0;
+        cp = len==1 ? b : b & (0x7f >> len);
+        for (size_type k = 1;k<len;k++)
+        {
+            byte c = byte(s[i+k]);
+            if ((c & 0xc0) != 0x80)
+                return 0;
+            cp = (cp << 6) | (c & 0x3f);
+        }
+        if (cp<MIN[len-1] || (cp>=0xd800 && cp<0xe000) || cp>0x10ffff)
+            return 0;
+        return len;
+    }
+    BENCH_NOINLINE bool naive_validate(const str& text)
+    {
+        const char* s = text.c_str();
+        size_type n = text.length();
+        uint32 cp;
+        for (size_type i = 0;i<n;)
+        {
+            size_type len = naive_decode(s,n,i,cp);
+            if (len == 0)
+                return false;
+            i += len;
+        }
+        return true;
+    }
+    BENCH_NOINLINE size_type naive_to_wstr(const str& text)
+    {
+        const char* s = text.c_str();
+        size_type n = text.length();
+        wstr result;
+        uint32 cp;
+        for (size_type i = 0;i<n;)
+        {
+            size_type len = naive_decode(s,n,i,cp);
+            result.push_back(wchar_t(len==0 ? 0xfffd : cp));
+            i += len==0 ? 1 : len;
+        }
+        return result.length();
+    }
+    BENCH_NOINLINE size_type naive_to_utf8(const wstr& text)
+    {
+        str result;
+        for (size_type i = 0;i<text.length();i++)
+        {
+            uint32 cp = uint32(text[i]);
+            if (cp < 0x80)
+                result.push_back(char(cp));
+            else if (cp < 0x800)
+            {
+                result.push_back(char(0xc0 | (cp >> 6)));
+                result.push_back(char(0x80 | (cp & 0x3f)));
+            }
+            else if (cp < 0x10000)
+            {
+                result.push_back(char(0xe0 | (cp >> 12)));
+                result.push_back(char(0x80 | ((cp >> 6) & 0x3f)));
+                result.push_back(char(0x80 | (cp & 0x3f)));
+            }
+            else
+            {
+                result.push_back(char(0xf0 | (cp >> 18)));
+                result.push_back(char(0x80 | ((cp >> 12) & 0x3f)));
+                result.push_back(char(0x80 | ((cp >> 6) & 0x3f)));
+                result.push_back(char(0x80 | (cp & 0x3f)));
+            }
+        }
+        return result.length();
+    }
+
+    BENCH_NOINLINE size_type stream_lines(const str& text,bool filter)
+    {
+        const_stringstream ss(text);
+        ss.filter_utf8(filter);
+        str line;
+        size_type chars = 0;
+        while (true)
+        {
+            ss.getline(line);
+            if ( !ss.get_input_success() )
+                break;
+            chars += line.length();
+        }
+        return chars;
+    }
+
+    // a log of lines like "2024-05-01 12:00:07 INFO worker 17: ..."; every
+    // 'oneIn'-th line (if any) carries a non-ASCII name or symbol
+    str make_log(size_type oneIn)
+    {
+        static const char* const NAMES[] = { "Zo\xc3\xab", "Bj\xc3\xb6rk", "\xe6\x97\xa5\xe6\x9c\xac",
+            "\xe2\x80\x94", "\xf0\x9f\x98\x80" };
+        str text;
+        char buf[160];
+        for (size_type i = 0;text.length()<TEXT_SIZE;i++)
+        {
+            std::sprintf(buf,"2024-05-01 12:%02u:%02u INFO worker %u: request %u served in %u ms from cache",
+                unsigned(i/60%60),unsigned(i%60),unsigned(i%32),unsigned(i),unsigned(i*7%500));
+            text += buf;
+            if (oneIn>0 && i%oneIn==0)
+            {
+                text += " for ";
+                text += NAMES[i/oneIn % 5];
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    // returns the rate in MB/s (of UTF-8 bytes) of the best round
+    template<typename Fn>
+    double best_mbps(Fn fn,size_type bytes,size_type& sink)
+    {
+        double best = 0;
+        for (int r = 0;r<ROUNDS;r++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int p = 0;p<PASSES;p++)
+            {
+                sink += fn();
+                BENCH_CLOBBER();
+            }
+            std::chrono::duration<double,std::micro> elapsed = std::chrono::steady_clock::now()-start;
+            double mbps = double(bytes)*PASSES / elapsed.count();
+            if (mbps > best)
+                best = mbps;
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    std::setlocale(LC_ALL,"C.UTF-8");
+    size_type sink = 0;
+    std::printf("%-22s %-16s %9s %9s %9s  (MB/s)\n","text","operation","naive","rutil","libc");
+    for (int k = 0;k<2;k++)
+    {
+        // all ASCII, then a non-ASCII name on one line in ten
+        const char* label = k==0 ? "ASCII" : "non-ASCII 1 line/10";
+        str text = make_log(k==0 ? 0 : 10);
+        wstr wide = rutil_utf8_to_wstr(text);
+        size_type n = text.length();
+        wchar_t* wbuf = new wchar_t[n+1];
+        char* mbuf = new char[n*4+1];
+
+        double naive = best_mbps([&](){ return size_type(naive_validate(text)); },n,sink);
+        double ours = best_mbps([&](){ return size_type(rutil_utf8_validate(text)); },n,sink);
+        double libc = best_mbps([&](){ return std::mbstowcs(NULL,text.c_str(),0); },n,sink);
+        std::printf("%-22s %-16s %9.1f %9.1f %9.1f\n",label,"validate",naive,ours,libc);
+
+        naive = best_mbps([&](){ return naive_to_wstr(text); },n,sink);
+        ours = best_mbps([&](){ return rutil_utf8_to_wstr(text).length(); },n,sink);
+        libc = best_mbps([&](){ return std::mbstowcs(wbuf,text.c_str(),n+1); },n,sink);
+        std::printf("%-22s %-16s %9.1f %9.1f %9.1f\n",label,"utf8 -> wstr",naive,ours,libc);
+
+        naive = best_mbps([&](){ return naive_to_utf8(wide); },n,sink);
+        ours = best_mbps([&](){ return rutil_wstr_to_utf8(wide).length(); },n,sink);
+        libc = best_mbps([&](){ return std::wcstombs(mbuf,wide.c_str(),n*4+1); },n,sink);
+        std::printf("%-22s %-16s %9.1f %9.1f %9.1f\n",label,"wstr -> utf8",naive,ours,libc);
+
+        double plain = best_mbps([&](){ return stream_lines(text,false); },n,sink);
+        double filtered = best_mbps([&](){ return stream_lines(text,true); },n,sink);
+        std::printf("%-22s %-16s %9s %9.1f %9s  (filter off: %.1f)\n",label,"stream getline","-",filtered,"-",plain);
+
+        delete[] wbuf;
+        delete[] mbuf;
+    }
+    return sink==0 ? 1 : 0;
+}
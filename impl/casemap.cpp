@@ -0,0 +1,108 @@
+// casemap.cpp
+#include "casemap.h"
+#include "rutility.h" // gets rutil_cpu_features
+#include "simd.h"
+#include <cstring>
+using namespace rtypes;
+using namespace rtypes::rimpl;
+
+namespace
+{
+    // each kernel flips the case of the letters from 'first' through
+    // 'first'+25 (that is 'A' through 'Z' or 'a' through 'z')
+    typedef void (*case_kernel)(char*,size_type,char);
+
+    void flip_case_bytes(char* p,size_type n,char first)
+    {
+        for (size_type i = 0;i<n;i++)
+            if (p[i]>=first && p[i]<=first+25)
+                p[i] ^= 0x20;
+    }
+
+#ifndef RLIB_SIMD_SSE2
+    void flip_case_words(char* p,size_type n,char first)
+    {
+        // handle eight bytes at a time: the high bit of each byte of
+        // 'atLeast' ('above') is set if its low seven bits are at least
+        // (above) the range; no byte's sum carries into the next byte
+        const uint64 ONES = 0x0101010101010101ull, HIGHS = ONES*0x80, LOWS = ONES*0x7f;
+        const uint64 toFirst = ONES*(0x80-byte(first)), toLast = ONES*(0x7f-byte(first+25));
+        size_type i = 0;
+        for (;i+8<=n;i+=8)
+        {
+            uint64 w;
+            std::memcpy(&w,p+i,8);
+            uint64 low = w & LOWS;
+            uint64 atLeast = low+toFirst, above = low+toLast;
+            // letters are the ASCII bytes that are at least the first letter but not above the last
+            uint64 letters = (atLeast ^ above) & ~w & HIGHS;
+            w ^= letters >> 2;
+            std::memcpy(p+i,&w,8);
+        }
+        flip_case_bytes(p+i,n-i,first);
+    }
+#endif
+
+#ifdef RLIB_SIMD_SSE2
+    void flip_case_sse2(char* p,size_type n,char first)
+    {
+        // shift the letters to the bottom of the signed range
+        // so that one signed comparison tests for the range
+        __m128i shift = _mm_set1_epi8(char(byte(0x80-byte(first))));
+        __m128i limit = _mm_set1_epi8(char(-128+26)), bit = _mm_set1_epi8(0x20);
+        size_type i = 0;
+        for (;i+16<=n;i+=16)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p+i));
+            __m128i letters = _mm_cmpgt_epi8(limit,_mm_add_epi8(x,shift));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p+i),_mm_xor_si128(x,_mm_and_si128(letters,bit)));
+        }
+        flip_case_bytes(p+i,n-i,first);
+    }
+#endif
+
+#ifdef RLIB_SIMD_AVX2
+    RLIB_AVX2_FUNCTION void flip_case_avx2(char* p,size_type n,char first)
+    {
+        avx2_scope scope;
+        __m256i shift = _mm256_set1_epi8(char(byte(0x80-byte(first))));
+        __m256i limit = _mm256_set1_epi8(char(-128+26)), bit = _mm256_set1_epi8(0x20);
+        size_type i = 0;
+        for (;i+32<=n;i+=32)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p+i));
+            __m256i letters = _mm256_cmpgt_epi8(limit,_mm256_add_epi8(x,shift));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p+i),_mm256_xor_si256(x,_mm256_and_si256(letters,bit)));
+        }
+        scope.leave();
+        flip_case_sse2(p+i,n-i,first);
+    }
+#endif
+
+    case_kernel select_flip_case()
+    {
+#ifdef RLIB_SIMD_AVX2
+        if (rutil_cpu_features().avx2)
+            return &flip_case_avx2;
+#endif
+#ifdef RLIB_SIMD_SSE2
+        return &flip_case_sse2;
+#else
+        return &flip_case_words;
+#endif
+    }
+    void flip_case(char* p,size_type n,char first)
+    {
+        static const case_kernel kernel = select_flip_case();
+        kernel(p,n,first);
+    }
+}
+
+void rimpl::ascii_to_lower(char* p,size_type n)
+{
+    flip_case(p,n,'A');
+}
+void rimpl::ascii_to_upper(char* p,size_type n)
+{
+    flip_case(p,n,'a');
+}
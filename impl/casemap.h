@@ -0,0 +1,17 @@
+// casemap.h - rlibrary ASCII case conversion kernels
+#ifndef RLIB_CASEMAP_H
+#define RLIB_CASEMAP_H
+#include "../rtypestypes.h"
+
+namespace rtypes
+{
+    namespace rimpl
+    {
+        // convert the 'n' characters at 'p' in place; only ASCII
+        // letters change and other bytes are left as they are
+        void ascii_to_lower(char* p,size_type n);
+        void ascii_to_upper(char* p,size_type n);
+    }
+}
+
+#endif
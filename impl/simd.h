@@ -0,0 +1,93 @@
+// simd.h - rlibrary vector instruction support for kernels in the implementation
+#ifndef RLIB_SIMD_H
+#define RLIB_SIMD_H
+#include "../rtypestypes.h"
+
+// SSE2 kernels are compiled where the target guarantees SSE2; AVX2 kernels are
+// compiled for AVX2 whatever the target and must only be called when
+// rutil_cpu_features() reports it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RLIB_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define RLIB_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define RLIB_AVX2_FUNCTION __attribute__((target("avx2")))
+// marks a kernel that reads a null-terminated string in whole aligned blocks;
+// such reads stay within the string's pages but may touch bytes outside of it
+#define RLIB_BLOCK_READS __attribute__((no_sanitize_address))
+#else
+#define RLIB_AVX2_FUNCTION
+#define RLIB_BLOCK_READS
+#endif
+
+namespace rtypes
+{
+    namespace rimpl
+    {
+        // the smallest page size of the supported targets
+        const size_type PAGE_SIZE = 4096;
+
+        // index of the lowest (or highest) set bit; 'mask' must be non-zero
+        inline size_type lowest_bit(uint32 mask)
+        {
+#if defined(__GNUC__)
+            return size_type( __builtin_ctz(mask) );
+#else
+            size_type i = 0;
+            while ((mask & 1) == 0)
+            {
+                mask >>= 1;
+                ++i;
+            }
+            return i;
+#endif
+        }
+        inline size_type highest_bit(uint32 mask)
+        {
+#if defined(__GNUC__)
+            return size_type( 31-__builtin_clz(mask) );
+#else
+            size_type i = 31;
+            while ((mask & 0x80000000) == 0)
+            {
+                mask <<= 1;
+                --i;
+            }
+            return i;
+#endif
+        }
+
+        // true if the 'cnt' bytes at 'p' lie on one page, so that reading
+        // them cannot fault if the first of them is readable
+        inline bool on_one_page(const void* p,size_type cnt)
+        { return (reinterpret_cast<size_type>(p) & (PAGE_SIZE-1)) <= PAGE_SIZE-cnt; }
+
+        // the offset of 'p' from the previous 'align'-byte boundary
+        inline size_type misalignment(const void* p,size_type align)
+        { return reinterpret_cast<size_type>(p) & (align-1); }
+
+#ifdef RLIB_SIMD_AVX2
+        /* avx2_scope
+         *  an AVX2 kernel declares one of these first so that the upper halves
+         * of the vector registers are cleared on every return; compilers do
+         * this themselves only when optimizing, and SSE code that runs while
+         * they are dirty pays for it on each instruction. A kernel that hands
+         * its tail to an SSE kernel calls leave() before doing so.
+         */
+        struct avx2_scope
+        {
+            RLIB_AVX2_FUNCTION ~avx2_scope()
+            { _mm256_zeroupper(); }
+            RLIB_AVX2_FUNCTION void leave()
+            { _mm256_zeroupper(); }
+        };
+#endif
+    }
+}
+
+#endif
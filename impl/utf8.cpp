@@ -0,0 +1,208 @@
+// utf8.cpp
+#include "utf8.h"
+#include "rutility.h" // gets rutil_cpu_features
+#include "simd.h"
+#include <cstring>
+using namespace rtypes;
+using namespace rtypes::rimpl;
+
+namespace
+{
+    // the kernels handle whole blocks of ASCII characters; the scalar
+    // versions finish what is left after the last whole block
+    typedef size_type (*ascii_length_kernel)(const char*,size_type);
+    typedef size_type (*widen_kernel)(wchar_t*,const char*,size_type);
+
+    size_type ascii_length_bytes(const char* p,size_type n)
+    {
+        size_type i = 0;
+        while (i<n && byte(p[i])<0x80)
+            ++i;
+        return i;
+    }
+    size_type widen_bytes(wchar_t* dest,const char* p,size_type n)
+    {
+        size_type i = 0;
+        for (;i<n && byte(p[i])<0x80;i++)
+            dest[i] = wchar_t(p[i]);
+        return i;
+    }
+    size_type narrow_chars(char* dest,const wchar_t* p,size_type n)
+    {
+        size_type i = 0;
+        for (;i<n && uint32(p[i])<0x80;i++)
+            dest[i] = char(p[i]);
+        return i;
+    }
+
+#ifndef RLIB_SIMD_SSE2
+    size_type ascii_length_words(const char* p,size_type n)
+    {
+        const uint64 HIGHS = 0x8080808080808080ull;
+        size_type i = 0;
+        for (;i+8<=n;i+=8)
+        {
+            uint64 w;
+            std::memcpy(&w,p+i,8);
+            if ((w & HIGHS) != 0)
+                break;
+        }
+        return i+ascii_length_bytes(p+i,n-i);
+    }
+#endif
+
+#ifdef RLIB_SIMD_SSE2
+    // (SSE2 kernels: a byte's high bit is what movemask collects)
+    size_type ascii_length_sse2(const char* p,size_type n)
+    {
+        size_type i = 0;
+        for (;i+16<=n;i+=16)
+        {
+            uint32 mask = uint32( _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p+i))) );
+            if (mask != 0)
+                return i+lowest_bit(mask);
+        }
+        return i+ascii_length_bytes(p+i,n-i);
+    }
+    size_type widen_sse2(wchar_t* dest,const char* p,size_type n)
+    {
+        __m128i zero = _mm_setzero_si128();
+        size_type i = 0;
+        for (;i+16<=n;i+=16)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p+i));
+            __m128i lo = _mm_unpacklo_epi8(x,zero), hi = _mm_unpackhi_epi8(x,zero);
+            __m128i* d = reinterpret_cast<__m128i*>(dest+i);
+            if (sizeof(wchar_t) == 4)
+            {
+                _mm_storeu_si128(d,_mm_unpacklo_epi16(lo,zero));
+                _mm_storeu_si128(d+1,_mm_unpackhi_epi16(lo,zero));
+                _mm_storeu_si128(d+2,_mm_unpacklo_epi16(hi,zero));
+                _mm_storeu_si128(d+3,_mm_unpackhi_epi16(hi,zero));
+            }
+            else
+            {
+                _mm_storeu_si128(d,lo);
+                _mm_storeu_si128(d+1,hi);
+            }
+            uint32 mask = uint32( _mm_movemask_epi8(x) );
+            if (mask != 0)
+                return i+lowest_bit(mask);
+        }
+        return i+widen_bytes(dest+i,p+i,n-i);
+    }
+    size_type narrow_sse2(char* dest,const wchar_t* p,size_type n)
+    {
+        // pack a block of 16 characters once none of them has a bit above
+        // the low seven set
+        const size_type PER_VECTOR = 16/sizeof(wchar_t);
+        __m128i zero = _mm_setzero_si128();
+        size_type i = 0;
+        for (;i+16<=n;i+=16)
+        {
+            const __m128i* s = reinterpret_cast<const __m128i*>(p+i);
+            __m128i packed;
+            if (PER_VECTOR == 4)
+            {
+                __m128i a = _mm_loadu_si128(s), b = _mm_loadu_si128(s+1);
+                __m128i c = _mm_loadu_si128(s+2), d = _mm_loadu_si128(s+3);
+                __m128i high = _mm_and_si128(_mm_or_si128(_mm_or_si128(a,b),_mm_or_si128(c,d)),_mm_set1_epi32(~0x7f));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(high,zero)) != 0xffff)
+                    break;
+                packed = _mm_packus_epi16(_mm_packs_epi32(a,b),_mm_packs_epi32(c,d));
+            }
+            else
+            {
+                __m128i a = _mm_loadu_si128(s), b = _mm_loadu_si128(s+1);
+                __m128i high = _mm_and_si128(_mm_or_si128(a,b),_mm_set1_epi16(short(~0x7f)));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(high,zero)) != 0xffff)
+                    break;
+                packed = _mm_packus_epi16(a,b);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest+i),packed);
+        }
+        return i+narrow_chars(dest+i,p+i,n-i);
+    }
+#endif
+
+#ifdef RLIB_SIMD_AVX2
+    // (AVX2 kernels)
+    RLIB_AVX2_FUNCTION size_type ascii_length_avx2(const char* p,size_type n)
+    {
+        avx2_scope scope;
+        size_type i = 0;
+        for (;i+32<=n;i+=32)
+        {
+            uint32 mask = uint32( _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p+i))) );
+            if (mask != 0)
+                return i+lowest_bit(mask);
+        }
+        scope.leave();
+        return i+ascii_length_sse2(p+i,n-i);
+    }
+    RLIB_AVX2_FUNCTION size_type widen_avx2(wchar_t* dest,const char* p,size_type n)
+    {
+        avx2_scope scope;
+        size_type i = 0;
+        for (;i+32<=n;i+=32)
+        {
+            __m256i* d = reinterpret_cast<__m256i*>(dest+i);
+            if (sizeof(wchar_t) == 4)
+                for (size_type k = 0;k<4;k++)
+                    _mm256_storeu_si256(d+k,_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p+i+k*8))));
+            else
+                for (size_type k = 0;k<2;k++)
+                    _mm256_storeu_si256(d+k,_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p+i+k*16))));
+            uint32 mask = uint32( _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p+i))) );
+            if (mask != 0)
+                return i+lowest_bit(mask);
+        }
+        scope.leave();
+        return i+widen_sse2(dest+i,p+i,n-i);
+    }
+#endif
+
+    ascii_length_kernel select_ascii_length()
+    {
+#ifdef RLIB_SIMD_AVX2
+        if (rutil_cpu_features().avx2)
+            return &ascii_length_avx2;
+#endif
+#ifdef RLIB_SIMD_SSE2
+        return &ascii_length_sse2;
+#else
+        return &ascii_length_words;
+#endif
+    }
+    widen_kernel select_widen()
+    {
+#ifdef RLIB_SIMD_AVX2
+        if (rutil_cpu_features().avx2)
+            return &widen_avx2;
+#endif
+#ifdef RLIB_SIMD_SSE2
+        return &widen_sse2;
+#else
+        return &widen_bytes;
+#endif
+    }
+}
+
+size_type rimpl::ascii_length(const char* p,size_type n)
+{
+    static const ascii_length_kernel kernel = select_ascii_length();
+    return kernel(p,n);
+}
+size_type rimpl::widen_ascii(wchar_t* dest,const char* p,size_type n)
+{
+    static const widen_kernel kernel = select_widen();
+    return kernel(dest,p,n);
+}
+size_type rimpl::narrow_ascii(char* dest,const wchar_t* p,size_type n)
+{
+#ifdef RLIB_SIMD_SSE2
+    return narrow_sse2(dest,p,n);
+#else
+    return narrow_chars(dest,p,n);
+#endif
+}
@@ -0,0 +1,153 @@
+// utf8.h - rlibrary UTF-8 transcoding kernels
+#ifndef RLIB_UTF8_H
+#define RLIB_UTF8_H
+#include "../rtypestypes.h"
+
+namespace rtypes
+{
+    namespace rimpl
+    {
+        // the code point that stands in for ill-formed input
+        const uint32 REPLACEMENT_CHARACTER = 0xfffd;
+
+        // the number of leading bytes at 'p' that are ASCII (below 0x80)
+        size_type ascii_length(const char* p,size_type n);
+
+        // widen (narrow) the leading ASCII characters at 'p' into 'dest' and
+        // return how many there were; 'dest' must have room for 'n' characters
+        // since whole blocks are written before they are checked
+        size_type widen_ascii(wchar_t* dest,const char* p,size_type n);
+        size_type narrow_ascii(char* dest,const wchar_t* p,size_type n);
+
+        /* utf8_decode
+         *  decodes the sequence at 'p' (with 'n' bytes left) into 'cp'; if the
+         * sequence is ill-formed this returns false and 'len' is the length of
+         * its maximal subpart (which is replaced by one U+FFFD); the bounds
+         * follow table 3-7 of the Unicode standard, so overlong forms,
+         * surrogates and values past U+10FFFF are all rejected
+         */
+        inline bool utf8_decode(const char* p,size_type n,uint32& cp,size_type& len)
+        {
+            byte b = byte(p[0]), lo = 0x80, hi = 0xbf;
+            size_type cnt;
+            len = 1;
+            if (b < 0x80)
+            {
+                cp = b;
+                return true;
+            }
+            if (b < 0xc2)
+                return false;
+            if (b < 0xe0)
+            {
+                cnt = 2;
+                cp = b & 0x1f;
+            }
+            else if (b < 0xf0)
+            {
+                cnt = 3;
+                cp = b & 0x0f;
+                if (b == 0xe0)
+                    lo = 0xa0;
+                else if (b == 0xed)
+                    hi = 0x9f;
+            }
+            else if (b < 0xf5)
+            {
+                cnt = 4;
+                cp = b & 0x07;
+                if (b == 0xf0)
+                    lo = 0x90;
+                else if (b == 0xf4)
+                    hi = 0x8f;
+            }
+            else
+                return false;
+            // (only the second byte has narrower bounds)
+            for (;len<cnt;len++)
+            {
+                if (len >= n)
+                    return false;
+                byte c = byte(p[len]);
+                if (c<lo || c>hi)
+                    return false;
+                cp = (cp<<6) | (c&0x3f);
+                lo = 0x80;
+                hi = 0xbf;
+            }
+            return true;
+        }
+
+        // encodes the scalar value 'cp' into 'dest' (which has room for four
+        // bytes); returns the number of bytes written
+        inline size_type utf8_encode(char* dest,uint32 cp)
+        {
+            if (cp < 0x80)
+            {
+                dest[0] = char(cp);
+                return 1;
+            }
+            if (cp < 0x800)
+            {
+                dest[0] = char(0xc0 | (cp>>6));
+                dest[1] = char(0x80 | (cp&0x3f));
+                return 2;
+            }
+            if (cp < 0x10000)
+            {
+                dest[0] = char(0xe0 | (cp>>12));
+                dest[1] = char(0x80 | ((cp>>6)&0x3f));
+                dest[2] = char(0x80 | (cp&0x3f));
+                return 3;
+            }
+            dest[0] = char(0xf0 | (cp>>18));
+            dest[1] = char(0x80 | ((cp>>12)&0x3f));
+            dest[2] = char(0x80 | ((cp>>6)&0x3f));
+            dest[3] = char(0x80 | (cp&0x3f));
+            return 4;
+        }
+
+        /* wide_decode and wide_encode
+         *  wide strings hold UTF-32 where wchar_t has 32 bits and UTF-16 where
+         * it has 16 bits (Windows); decoding reads one or two (a surrogate pair)
+         * characters into a scalar value, substituting U+FFFD for an unpaired
+         * surrogate or a value that is out of range; encoding writes one or two
+         * characters and returns how many
+         */
+        inline uint32 wide_decode(const wchar_t* p,size_type n,size_type& len)
+        {
+            uint32 cp = uint32(p[0]);
+            len = 1;
+            if (sizeof(wchar_t) == 2)
+            {
+                cp &= 0xffff;
+                if (cp>=0xd800 && cp<0xdc00 && n>1)
+                {
+                    uint32 low = uint32(p[1]) & 0xffff;
+                    if (low>=0xdc00 && low<0xe000)
+                    {
+                        len = 2;
+                        return 0x10000 + ((cp-0xd800)<<10) + (low-0xdc00);
+                    }
+                }
+            }
+            if ((cp>=0xd800 && cp<0xe000) || cp>0x10ffff)
+                return REPLACEMENT_CHARACTER;
+            return cp;
+        }
+        inline size_type wide_encode(wchar_t* dest,uint32 cp)
+        {
+            if (sizeof(wchar_t)==2 && cp>=0x10000)
+            {
+                cp -= 0x10000;
+                dest[0] = wchar_t(0xd800 + (cp>>10));
+                dest[1] = wchar_t(0xdc00 + (cp&0x3ff));
+                return 2;
+            }
+            dest[0] = wchar_t(cp);
+            return 1;
+        }
+    }
+}
+
+#endif
@@ -2,42 +2,178 @@
 #ifndef RALLOCATOR_H
 #define RALLOCATOR_H
 #include "rtypestypes.h"
+#include "rmemory.h" // get rutil_memcpy, rutil_memfill
+#include <type_traits>
+#include <utility> // get std::move
 
 namespace rtypes
 {
+    /* default_allocator
+     *  the allocator policy used by rlibrary containers unless another is
+     * specified; an allocator policy provides 'allocate(bytes)' and
+     * 'deallocate(ptr,bytes)' and is copied along with its container
+     */
+    struct default_allocator
+    {
+        void* allocate(size_type bytes)
+        { return ::operator new(bytes); }
+        void deallocate(void* p,size_type /*bytes*/)
+        { ::operator delete(p); }
+    };
+
+    /* _rallocator_raw
+     *  operations on uninitialized (raw) storage used by the rlibrary allocators;
+     * elements are placement-constructed into raw storage, moved on relocation and
+     * bulk copied when the element type is trivially copyable
+     */
     template<class T>
-    class rallocator
+    struct _rallocator_raw
     {
-    protected:
-        rallocator& operator =(const rallocator& obj)
+        static const bool trivial_copy = std::is_trivially_copyable<T>::value;
+        static const bool trivial_destroy = std::is_trivially_destructible<T>::value;
+
+        template<class Alloc>
+        static T* allocate(Alloc& allocator,size_type cnt)
         {
-            if (&obj==this)
-                return *this;
-            _alloc(obj._allocSize);
-            // copy as is
-            for (size_type i = 0;i<obj._allocSize;i++)
-                _data[i] = obj._data[i];
-            return *this;
+            if (cnt == 0)
+                return NULL;
+            return static_cast<T*>( allocator.allocate(cnt*sizeof(T)) );
+        }
+        template<class Alloc>
+        static void deallocate(Alloc& allocator,T* p,size_type cnt)
+        {
+            if (p != NULL)
+                allocator.deallocate(p,cnt*sizeof(T));
+        }
+
+        static void construct(T* p)
+        { new (p) T(); }
+        static void construct(T* p,const T& value)
+        { new (p) T(value); }
+        static void construct(T* p,T&& value)
+        { new (p) T( std::move(value) ); }
+        // constructs an element in place from any constructor arguments
+        template<class... Args>
+        static void emplace(T* p,Args&&... args)
+        { new (p) T( std::forward<Args>(args)... ); }
+        static void construct_range(T* p,size_type cnt)
+        {
+            for (size_type i = 0;i<cnt;i++)
+                new (p+i) T();
+        }
+        static void construct_range(T* p,size_type cnt,const T& value)
+        {
+            if (trivial_copy && sizeof(T)==1)
+            {
+                // (a byte-sized element is filled with its byte value)
+                rutil_memfill(static_cast<void*>(p),cnt,*reinterpret_cast<const byte*>(&value));
+            }
+            else
+                for (size_type i = 0;i<cnt;i++)
+                    new (p+i) T(value);
+        }
+
+        static void destroy(T* p)
+        { p->~T(); }
+        static void destroy_range(T* p,size_type cnt)
+        {
+            if (!trivial_destroy)
+                for (size_type i = 0;i<cnt;i++)
+                    p[i].~T();
         }
-        rallocator()
+
+        // copy-construct 'cnt' elements into raw storage
+        static void copy_range(T* copyTo,const T* copyFrom,size_type cnt)
+        {
+            if (trivial_copy)
+            {
+                if (cnt > 0)
+                    rutil_memcpy(static_cast<void*>(copyTo),static_cast<const void*>(copyFrom),cnt*sizeof(T));
+            }
+            else
+                for (size_type i = 0;i<cnt;i++)
+                    new (copyTo+i) T(copyFrom[i]);
+        }
+
+        // move-construct 'cnt' elements into raw storage and destroy the
+        // originals; the source storage is left uninitialized
+        static void relocate_range(T* moveTo,T* moveFrom,size_type cnt)
+        {
+            if (trivial_copy)
+            {
+                if (cnt > 0)
+                    rutil_memcpy(static_cast<void*>(moveTo),static_cast<const void*>(moveFrom),cnt*sizeof(T));
+            }
+            else
+                for (size_type i = 0;i<cnt;i++)
+                {
+                    new (moveTo+i) T( std::move(moveFrom[i]) );
+                    moveFrom[i].~T();
+                }
+        }
+    };
+
+    /* rallocator
+     *  manages a raw allocation whose element lifetimes are managed
+     * by the derived implementation; upon reallocation the derived class
+     * is asked to relocate its live elements into the new storage; the
+     * allocator policy is inherited privately so that stateless policies
+     * take up no space
+     */
+    template<class T,class Alloc = default_allocator>
+    class rallocator : private Alloc
+    {
+    public:
+        Alloc get_allocator() const
+        { return *this; }
+    protected:
+        typedef _rallocator_raw<T> _Raw;
+
+        explicit rallocator(const Alloc& allocator = Alloc())
+            : Alloc(allocator)
         {
             _data = 0;
             _allocSize = 0;
             _alloc();
         }
-        explicit rallocator(size_type AllocSize)
+        explicit rallocator(size_type AllocSize,const Alloc& allocator = Alloc())
+            : Alloc(allocator)
         {
             _data = 0;
+            _allocSize = 0;
             _alloc(AllocSize);
         }
         rallocator(const rallocator& obj)
+            : Alloc(obj)
         {
-            _data = 0;
-            _allocSize = 0;
-            _alloc(obj._allocSize);
-            // copy as is
-            for (size_type i = 0;i<obj._allocSize;i++)
-                _data[i] = obj._data[i];
+            // allocate the same amount of raw storage; the
+            // derived implementation copies its live elements
+            _data = _Raw::allocate(_allocator(),obj._allocSize);
+            _allocSize = obj._allocSize;
+        }
+        rallocator(rallocator&& obj)
+            : Alloc(obj)
+        {
+            // take the storage (and the live elements in it); 'obj'
+            // is left without storage and allocates on its next use
+            _data = obj._data;
+            _allocSize = obj._allocSize;
+            obj._data = 0;
+            obj._allocSize = 0;
+        }
+        rallocator& operator =(rallocator&& obj) // the derived implementation must destroy its live elements beforehand
+        {
+            if (&obj != this)
+            {
+                // the storage must be freed by the allocator that produced it
+                _dealloc();
+                _allocator() = obj._allocator();
+                _data = obj._data;
+                _allocSize = obj._allocSize;
+                obj._data = 0;
+                obj._allocSize = 0;
+            }
+            return *this;
         }
         ~rallocator()
         {
@@ -47,66 +183,112 @@ namespace rtypes
         size_type _allocationSize() const { return _allocSize; }
         T* _alloc() // return ptr to new data
         {
-            size_type newSize = (_allocSize==0 ? 4 : _allocSize*2);
-            T* newData = new T[newSize];
-            _copy(newData,_data);
-            _dealloc();
-            _data = newData;
-            _allocSize = newSize;
-            return newData;
+            return _alloc(_allocSize==0 ? 4 : _allocSize*2);
         }
         T* _alloc(size_type desiredSize) // return ptr to new data
         {
-            T* newData = new T[desiredSize];
-            _copy(newData,_data);
-            _dealloc();
+            T* newData = _Raw::allocate(_allocator(),desiredSize);
+            if (_data != 0)
+            {
+                _relocate(newData,_data); // let derived implementation move its elements
+                _Raw::deallocate(_allocator(),_data,_allocSize);
+            }
             _data = newData;
             _allocSize = desiredSize;
             return newData;
         }
-        virtual void _copy(T* copyTo,const T* copyFrom)
-        {// default copying
-            for (size_type i = 0;i<_allocSize;i++)
-                copyTo[i] = copyFrom[i];
+        template<class... Args>
+        T* _allocEmplace(size_type desiredSize,size_type index,Args&&... args) // like _alloc, but first constructs an element from 'args' at 'index' in the new data
+        {
+            // construct the new element before relocating the old elements
+            // in case an argument refers to an element in the old storage
+            T* newData = _Raw::allocate(_allocator(),desiredSize);
+            _Raw::emplace(newData+index,std::forward<Args>(args)...);
+            if (_data != 0)
+            {
+                _relocate(newData,_data);
+                _Raw::deallocate(_allocator(),_data,_allocSize);
+            }
+            _data = newData;
+            _allocSize = desiredSize;
+            return newData;
         }
-        void _dealloc()
+        /* _relocate( moveTo, moveFrom )
+         *  called on reallocation; the derived implementation must move
+         * its live elements from 'moveFrom' into the raw storage 'moveTo'
+         * (which holds the new allocation size); _allocationSize() still
+         * reports the old allocation size during the call
+         */
+        virtual void _relocate(T* moveTo,T* moveFrom) = 0;
+        void _dealloc() // the derived implementation must destroy its live elements beforehand
         {
-            delete[] _data;
+            _Raw::deallocate(_allocator(),_data,_allocSize);
             _data = 0;
             _allocSize = 0;
         }
     private:
         T* _data;
         size_type _allocSize;
+
+        Alloc& _allocator()
+        { return *this; }
+
+        // disallow assignment (derived classes assign their live elements)
+        rallocator& operator =(const rallocator&);
     };
 
-    template<class T>
-    class rallocatorEx // makes a virtual distinction between used and extra data
+    template<class T,class Alloc = default_allocator>
+    class rallocatorEx : private Alloc // makes a virtual distinction between used and extra data
     {
+        typedef _rallocator_raw<T> _Raw;
     public:
         rallocatorEx& operator =(const rallocatorEx& obj)
         {
             if (&obj==this)
                 return *this;
-            delete[] _data;
+            _Raw::destroy_range(_data,_sz);
+            if (_allocationSize() < obj._sz)
+            {
+                _Raw::deallocate(_allocator(),_data,_allocationSize());
+                _data = _Raw::allocate(_allocator(),obj._allocationSize());
+                _extr = obj._extr;
+            }
+            else
+                _extr = _allocationSize()-obj._sz;
             _sz = obj._sz;
-            _extr = obj._extr;
-            _data = new T[_allocationSize()];
-            // copy as is
-            for (size_type i = 0;i<_sz;i++)
-                _data[i] = obj._data[i];
+            _Raw::copy_range(_data,obj._data,_sz);
+            return *this;
+        }
+        rallocatorEx& operator =(rallocatorEx&& obj)
+        {
+            if (&obj != this)
+            {
+                // the storage must be freed by the allocator that produced it
+                _dealloc();
+                _allocator() = obj._allocator();
+                _data = obj._data;
+                _sz = obj._sz;
+                _extr = obj._extr;
+                obj._data = 0;
+                obj._sz = 0;
+                obj._extr = 0;
+            }
             return *this;
         }
+
+        Alloc get_allocator() const
+        { return *this; }
     protected:
-        rallocatorEx()
+        explicit rallocatorEx(const Alloc& allocator = Alloc())
+            : Alloc(allocator)
         {
+            // nothing is allocated until the first element is added
             _data = 0;
             _sz = 0;
             _extr = 0;
-            _virtAlloc(1); // _sz 1, _extr 3
-            _virtAlloc(0); // _sz 0, _extr 4
         }
-        explicit rallocatorEx(size_type AllocSize)
+        explicit rallocatorEx(size_type AllocSize,const Alloc& allocator = Alloc())
+            : Alloc(allocator)
         {
             _data = 0;
             _sz = 0;
@@ -114,13 +296,23 @@ namespace rtypes
             _virtAlloc(AllocSize); // will allocate more, but provides good buffering
         }
         rallocatorEx(const rallocatorEx& obj)
+            : Alloc(obj)
+        {
+            _sz = obj._sz;
+            _extr = obj._extr;
+            _data = _Raw::allocate(_allocator(),_allocationSize());
+            _Raw::copy_range(_data,obj._data,_sz);
+        }
+        rallocatorEx(rallocatorEx&& obj)
+            : Alloc(obj)
         {
+            // take the storage and its elements; 'obj' is left empty
+            _data = obj._data;
             _sz = obj._sz;
             _extr = obj._extr;
-            _data = new T[_allocationSize()];
-            // copy as is
-            for (size_type i = 0;i<_sz;i++)
-                _data[i] = obj._data[i];
+            obj._data = 0;
+            obj._sz = 0;
+            obj._extr = 0;
         }
         ~rallocatorEx()
         {
@@ -134,62 +326,84 @@ namespace rtypes
         {
             if (desiredSize>0)
             {
-                T* newData = new T[desiredSize];
-                _copy(newData,_data);
-                delete[] _data;
-                _data = newData;
-                _sz = desiredSize;
-                _extr = 0;
+                size_type keep = _exactRealloc(desiredSize);
+                _Raw::construct_range(_data+keep,desiredSize-keep);
+            }
+            else
+                _dealloc();
+        }
+        void _exactAlloc(size_type desiredSize,const T& value) // new elements are copies of 'value'
+        {
+            if (desiredSize>0)
+            {
+                size_type keep = _exactRealloc(desiredSize);
+                _Raw::construct_range(_data+keep,desiredSize-keep,value);
             }
             else
                 _dealloc();
         }
         bool _virtAlloc(size_type desiredSize) // returns a boolean indicating if the (de)allocation was virtual; all deallocations are virtual
         {
+            bool isVirtual = true;
             if (desiredSize>_sz)
             {
                 // an allocation is needed
-                if (_allocationSize()>=desiredSize)
-                {
-                    // virtual allocation
-                    size_type dif = desiredSize-_sz;
-                    _extr -= dif;
-                    _sz += dif;
-                    return true;
-                }
-                else
+                if (_allocationSize()<desiredSize)
                 {
-                    // reallocate to twice old allocation
-                    size_type allocSize = _allocationSize();
-                    size_type newSize = (allocSize==0 ? 4 : allocSize*2);
-                    T* newData = new T[newSize];
-                    _copy(newData,_data); // perform default or custom copy action
-                    delete[] _data;
-                    _data = newData;
-                    _extr = newSize-_sz;
-                    _virtAlloc(desiredSize);
-                    return false;
+                    // reallocate to a power-of-two multiple of the old allocation
+                    _reallocate( _growSize(desiredSize) );
+                    isVirtual = false;
                 }
+                // default construct the newly used elements
+                size_type dif = desiredSize-_sz;
+                _Raw::construct_range(_data+_sz,dif);
+                _extr -= dif;
+                _sz += dif;
             }
             else if (desiredSize<_sz)
             {
-                // virtual deallocation
+                // virtual deallocation; the unused elements are destroyed
                 size_type dif = _sz-desiredSize;
+                _Raw::destroy_range(_data+desiredSize,dif);
                 _extr += dif;
                 _sz -= dif;
-                //return true below
             }
             // else equal, no action
-            return true; 
+            return isVirtual;
         }
-        virtual void _copy(T* copyTo,const T* copyFrom)
-        {// default copying
-            for (size_type i = 0;i<_sz;i++)
-                copyTo[i] = copyFrom[i];
+        void _virtPush(const T& elem) // copy-constructs a new element at the end of the used data
+        { _virtEmplace(elem); }
+        void _virtPush(T&& elem) // move-constructs a new element at the end of the used data
+        { _virtEmplace( std::move(elem) ); }
+        template<class... Args>
+        void _virtEmplace(Args&&... args) // constructs a new element at the end of the used data from 'args'
+        {
+            if (_extr == 0)
+            {
+                // construct the new element before relocating the old elements
+                // in case an argument refers to an element in the old storage
+                size_type newSize = _growSize(_sz+1);
+                T* newData = _Raw::allocate(_allocator(),newSize);
+                _Raw::emplace(newData+_sz,std::forward<Args>(args)...);
+                _Raw::relocate_range(newData,_data,_sz);
+                _Raw::deallocate(_allocator(),_data,_sz);
+                _data = newData;
+                _extr = newSize-_sz;
+            }
+            else
+                _Raw::emplace(_data+_sz,std::forward<Args>(args)...);
+            ++_sz;
+            --_extr;
+        }
+        void _reserve(size_type desiredCapacity) // grows the allocation; no elements are constructed
+        {
+            if (_allocationSize() < desiredCapacity)
+                _reallocate(desiredCapacity);
         }
         void _dealloc()
         {
-            delete[] _data;
+            _Raw::destroy_range(_data,_sz);
+            _Raw::deallocate(_allocator(),_data,_allocationSize());
             _data = 0;
             _sz = 0;
             _extr = 0;
@@ -197,6 +411,37 @@ namespace rtypes
     private:
         T* _data;
         size_type _sz, _extr;
+
+        Alloc& _allocator()
+        { return *this; }
+        size_type _growSize(size_type desiredSize) const
+        {
+            size_type allocSize = _allocationSize();
+            size_type newSize = (allocSize==0 ? 4 : allocSize*2);
+            while (newSize < desiredSize)
+                newSize *= 2;
+            return newSize;
+        }
+        void _reallocate(size_type newSize) // newSize must be large enough to hold the used elements
+        {
+            T* newData = _Raw::allocate(_allocator(),newSize);
+            _Raw::relocate_range(newData,_data,_sz);
+            _Raw::deallocate(_allocator(),_data,_allocationSize());
+            _data = newData;
+            _extr = newSize-_sz;
+        }
+        size_type _exactRealloc(size_type desiredSize) // returns the number of elements kept
+        {
+            T* newData = _Raw::allocate(_allocator(),desiredSize);
+            size_type keep = (desiredSize<_sz ? desiredSize : _sz);
+            _Raw::relocate_range(newData,_data,keep);
+            _Raw::destroy_range(_data+keep,_sz-keep);
+            _Raw::deallocate(_allocator(),_data,_allocationSize());
+            _data = newData;
+            _sz = desiredSize;
+            _extr = 0;
+            return keep;
+        }
     };
 }
 
@@ -0,0 +1,103 @@
+// rarena.cpp
+#include "rarena.h"
+using namespace rtypes;
+
+namespace
+{
+    // every allocation is aligned to the strictest fundamental alignment
+    const size_type ARENA_ALIGNMENT = alignof(std::max_align_t);
+
+    inline size_type arena_align(size_type n)
+    {
+        return (n + ARENA_ALIGNMENT-1) & ~(ARENA_ALIGNMENT-1);
+    }
+}
+
+memory_arena::memory_arena(size_type blockSize)
+{
+    _first = NULL;
+    _current = NULL;
+    _pos = NULL;
+    _end = NULL;
+    _blockSize = arena_align(blockSize>0 ? blockSize : 1);
+    _allocated = 0;
+    _reserved = 0;
+}
+memory_arena::~memory_arena()
+{
+    release();
+}
+void* memory_arena::allocate(size_type bytes)
+{
+    void* p;
+    bytes = arena_align(bytes>0 ? bytes : 1);
+    if (bytes > size_type(_end-_pos))
+        _nextBlock(bytes);
+    p = _pos;
+    _pos += bytes;
+    _allocated += bytes;
+    return p;
+}
+void memory_arena::reset()
+{
+    // rewind to the first block; the blocks are reused in order
+    // by subsequent allocations
+    _current = _first;
+    if (_current != NULL)
+    {
+        _pos = reinterpret_cast<byte*>(_current) + arena_align(sizeof(_Block));
+        _end = _pos + _current->size;
+    }
+    else
+    {
+        _pos = NULL;
+        _end = NULL;
+    }
+    _allocated = 0;
+}
+void memory_arena::release()
+{
+    _Block* b = _first;
+    while (b != NULL)
+    {
+        _Block* nxt = b->next;
+        ::operator delete(b);
+        b = nxt;
+    }
+    _first = NULL;
+    _current = NULL;
+    _pos = NULL;
+    _end = NULL;
+    _allocated = 0;
+    _reserved = 0;
+}
+void memory_arena::_nextBlock(size_type bytes)
+{
+    const size_type header = arena_align(sizeof(_Block));
+    // try blocks retained from before the last reset; a retained block
+    // that is too small is skipped until the next reset
+    while (_current!=NULL && _current->next!=NULL)
+    {
+        _current = _current->next;
+        if (_current->size >= bytes)
+        {
+            _pos = reinterpret_cast<byte*>(_current) + header;
+            _end = _pos + _current->size;
+            return;
+        }
+    }
+    // allocate a new block at the end of the chain; oversized
+    // requests get a block of their own size
+    size_type sz = (bytes>_blockSize ? bytes : _blockSize);
+    _Block* b = static_cast<_Block*>( ::operator new(header+sz) );
+    b->next = NULL;
+    b->size = sz;
+    if (_current != NULL)
+        _current->next = b;
+    else
+        _first = b;
+    _current = b;
+    _pos = reinterpret_cast<byte*>(b) + header;
+    _end = _pos + sz;
+    _reserved += sz;
+}
@@ -0,0 +1,91 @@
+/* rarena.h
+ *  rlibrary/rarena - provides an arena (monotonic) memory resource and an
+ * allocator policy that lets rlibrary containers draw their memory from it
+ */
+#ifndef RARENA_H
+#define RARENA_H
+#include "rtypestypes.h"
+
+namespace rtypes
+{
+    /* memory_arena
+     *  a monotonic memory resource: allocations are carved sequentially out of
+     * large blocks and individual deallocations are ignored; everything handed
+     * out is reclaimed at once by reset() in constant time (the blocks are kept
+     * and reused) or returned to the system by release(); objects whose memory
+     * comes from an arena must not be used after the arena is reset
+     */
+    class memory_arena
+    {
+    public:
+        explicit memory_arena(size_type blockSize = 4096);
+        ~memory_arena(); // releases all blocks
+
+        void* allocate(size_type bytes); // allocates memory suitably aligned for any type
+        void deallocate(void*,size_type) {} // no-op; memory is reclaimed by reset() or release()
+
+        void reset(); // reclaims all allocations; keeps the blocks for reuse
+        void release(); // reclaims all allocations and frees the blocks
+
+        size_type block_size() const
+        { return _blockSize; }
+        size_type bytes_allocated() const // number of bytes handed out since the last reset
+        { return _allocated; }
+        size_type bytes_reserved() const // number of bytes held in blocks
+        { return _reserved; }
+    private:
+        struct _Block
+        {
+            _Block* next;
+            size_type size;
+        };
+
+        _Block* _first;
+        _Block* _current;
+        byte* _pos;
+        byte* _end;
+        size_type _blockSize;
+        size_type _allocated;
+        size_type _reserved;
+
+        void _nextBlock(size_type bytes);
+
+        // disallow copying
+        memory_arena(const memory_arena&);
+        memory_arena& operator =(const memory_arena&);
+    };
+
+    /* arena_allocator
+     *  allocator policy for rlibrary containers and deep strings that draws its
+     * memory from a memory_arena; a default-constructed arena_allocator is not
+     * bound to an arena and uses the global heap instead
+     *  e.g. dynamic_array<int,arena_allocator> a(arena_allocator(requestArena));
+     */
+    class arena_allocator
+    {
+    public:
+        arena_allocator()
+            : _arena(NULL) {}
+        arena_allocator(memory_arena& arena)
+            : _arena(&arena) {}
+
+        void* allocate(size_type bytes)
+        {
+            if (_arena != NULL)
+                return _arena->allocate(bytes);
+            return ::operator new(bytes);
+        }
+        void deallocate(void* p,size_type /*bytes*/)
+        {
+            if (_arena == NULL)
+                ::operator delete(p);
+        }
+
+        memory_arena* get_arena() const
+        { return _arena; }
+    private:
+        memory_arena* _arena;
+    };
+}
+
+#endif
@@ -0,0 +1,196 @@
+/* rconqueue.h
+ *  rlibrary/rconqueue - provides bounded queues that may be shared between
+ * threads without locks; positions are free-running counters reduced by a
+ * mask, so capacities are rounded up to a power of two
+ */
+#ifndef RCONQUEUE_H
+#define RCONQUEUE_H
+#include "rallocator.h" // gets rtypestypes.h
+#include "rqueue.h" // gets queue_span
+#include <atomic>
+#include <thread>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h> // get _mm_pause
+#define RLIBRARY_HAS_PAUSE
+#endif
+
+namespace rtypes
+{
+    // indexes written by different threads are kept this many bytes apart
+    // so that they never share a cache line
+    const size_type CACHE_LINE_SIZE = 64;
+
+    /* _rcon_backoff
+     *  waits between attempts on a contended or unavailable queue: it spins
+     * briefly (which is cheapest when the other thread is about to make
+     * progress) and then yields the processor; with a single processor the
+     * other thread cannot make progress while this one spins, so it yields
+     * at once
+     */
+    class _rcon_backoff
+    {
+    public:
+        _rcon_backoff()
+            : _spins(0) {}
+
+        void wait()
+        {
+            static const bool spin = std::thread::hardware_concurrency() != 1; // (zero if unknown)
+            if (spin && _spins<64)
+            {
+                for (uint32 i = 0;i<=_spins;i++)
+                {
+#ifdef RLIBRARY_HAS_PAUSE
+                    _mm_pause();
+#endif
+                }
+                ++_spins;
+            }
+            else
+                std::this_thread::yield();
+        }
+    private:
+        uint32 _spins;
+    };
+
+    /* spsc_queue
+     *  a bounded FIFO queue for exactly one producer thread and one consumer
+     * thread; the producer owns the tail index and the consumer the head index,
+     * each on its own cache line and published with release stores; each side
+     * also caches the other's index so that it touches the other's cache line
+     * only when the queue appears full (or empty); try_push/try_pop never block
+     * while push/pop wait for room (or an element); the range operations move
+     * blocks of elements with at most two bulk copies
+     */
+    template<class T,class Alloc = default_allocator>
+    class spsc_queue : private Alloc
+    {
+        typedef _rallocator_raw<T> _Raw;
+    public:
+        explicit spsc_queue(size_type capacity,const Alloc& allocator = Alloc());
+        ~spsc_queue();
+
+        // (producer operations)
+        bool try_push(const T& elem); // returns false if the queue is full
+        void push(const T& elem); // waits while the queue is full
+        size_type push_range(const T* elems,size_type cnt); // pushes as many elements as fit; returns the number pushed
+
+        // (consumer operations)
+        bool try_pop(T& elem); // returns false if the queue is empty
+        T pop(); // waits while the queue is empty
+        size_type pop_range(T* dest,size_type cnt); // moves up to 'cnt' elements into 'dest'; returns the number popped
+        size_type pop_range(size_type cnt); // discards up to 'cnt' elements
+        /* peek_range( first, second )
+         *  describes the elements available to the consumer as at most
+         *  two contiguous spans; returns the number of elements; they remain
+         *  in the queue until they are popped
+         */
+        size_type peek_range(queue_span<T>& first,queue_span<T>& second);
+
+        // (either thread) these are exact only when the other thread is idle
+        size_type size() const
+        { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire); }
+        bool is_empty() const
+        { return size()==0; }
+        size_type capacity() const
+        { return _mask+1; }
+
+        Alloc get_allocator() const
+        { return *this; }
+    private:
+        // (shared, read-only)
+        T* _data;
+        size_type _mask;
+        byte _pad0[CACHE_LINE_SIZE];
+        // (consumer)
+        std::atomic<size_type> _head;
+        size_type _tailCache;
+        byte _pad1[CACHE_LINE_SIZE];
+        // (producer)
+        std::atomic<size_type> _tail;
+        size_type _headCache;
+        byte _pad2[CACHE_LINE_SIZE];
+
+        Alloc& _allocator()
+        { return *this; }
+        size_type _available(size_type head,size_type cnt); // consumer: elements ready, up to 'cnt'
+        size_type _room(size_type tail,size_type cnt); // producer: free slots, up to 'cnt'
+        void _spans(queue_span<T>* spans,size_type pos,size_type cnt) const;
+
+        // disallow copying
+        spsc_queue(const spsc_queue&);
+        spsc_queue& operator =(const spsc_queue&);
+    };
+
+    /* mpmc_queue
+     *  a bounded FIFO queue that any number of producer and consumer threads
+     * may share (after Dmitry Vyukov's design); each slot carries a sequence
+     * number telling whether it is ready for the producer or the consumer of a
+     * given position, so a thread claims a position with a single compare-and-
+     * swap on the shared index and then works on its slot without further
+     * synchronization; try_push/try_pop never block while push/pop wait; the
+     * range operations claim a run of adjacent positions with one compare-and-
+     * swap and may move fewer elements than requested
+     */
+    template<class T,class Alloc = default_allocator>
+    class mpmc_queue : private Alloc
+    {
+        typedef _rallocator_raw<T> _Raw;
+    public:
+        explicit mpmc_queue(size_type capacity,const Alloc& allocator = Alloc());
+        ~mpmc_queue();
+
+        bool try_push(const T& elem); // returns false if the queue is full
+        void push(const T& elem); // waits while the queue is full
+        size_type push_range(const T* elems,size_type cnt); // pushes as many elements as fit; returns the number pushed
+
+        bool try_pop(T& elem); // returns false if the queue is empty
+        T pop(); // waits while the queue is empty
+        size_type pop_range(T* dest,size_type cnt); // moves up to 'cnt' elements into 'dest'; returns the number popped
+
+        // (approximate while other threads are active)
+        size_type size() const;
+        bool is_empty() const
+        { return size()==0; }
+        size_type capacity() const
+        { return _mask+1; }
+
+        Alloc get_allocator() const
+        { return *this; }
+    private:
+        struct _Cell
+        {
+            // equals the position for a slot ready to be pushed at that position
+            // and the position plus one for a slot ready to be popped
+            std::atomic<size_type> seq;
+            typename std::aligned_storage<sizeof(T),alignof(T)>::type storage;
+
+            T* elem()
+            { return reinterpret_cast<T*>(&storage); }
+        };
+
+        // (shared, read-only)
+        _Cell* _cells;
+        size_type _mask;
+        byte _pad0[CACHE_LINE_SIZE];
+        std::atomic<size_type> _enqueuePos;
+        byte _pad1[CACHE_LINE_SIZE];
+        std::atomic<size_type> _dequeuePos;
+        byte _pad2[CACHE_LINE_SIZE];
+
+        Alloc& _allocator()
+        { return *this; }
+        // claim up to 'cnt' adjacent positions; returns the number claimed
+        size_type _claimPush(size_type& pos,size_type cnt);
+        size_type _claimPop(size_type& pos,size_type cnt);
+
+        // disallow copying
+        mpmc_queue(const mpmc_queue&);
+        mpmc_queue& operator =(const mpmc_queue&);
+    };
+}
+
+// include out-of-line implementation
+#include "rconqueue.tcc"
+
+#endif
@@ -0,0 +1,314 @@
+// rconqueue.tcc - out-of-line implementation for rconqueue
+
+// rtypes::spsc_queue<>
+template<class T,class Alloc>
+rtypes::spsc_queue<T,Alloc>::spsc_queue(size_type capacity,const Alloc& allocator)
+    : Alloc(allocator), _head(0), _tail(0)
+{
+    size_type cap = 2;
+    while (cap < capacity)
+        cap <<= 1;
+    _data = _Raw::allocate(_allocator(),cap);
+    _mask = cap-1;
+    _tailCache = 0;
+    _headCache = 0;
+}
+template<class T,class Alloc>
+rtypes::spsc_queue<T,Alloc>::~spsc_queue()
+{
+    pop_range(size());
+    _Raw::deallocate(_allocator(),_data,_mask+1);
+}
+template<class T,class Alloc>
+bool rtypes::spsc_queue<T,Alloc>::try_push(const T& elem)
+{
+    size_type tail = _tail.load(std::memory_order_relaxed);
+    if (_room(tail,1) == 0)
+        return false;
+    _Raw::construct(_data+(tail&_mask),elem);
+    _tail.store(tail+1,std::memory_order_release);
+    return true;
+}
+template<class T,class Alloc>
+void rtypes::spsc_queue<T,Alloc>::push(const T& elem)
+{
+    _rcon_backoff backoff;
+    while ( !try_push(elem) )
+        backoff.wait();
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::spsc_queue<T,Alloc>::push_range(const T* elems,size_type cnt)
+{
+    queue_span<T> spans[2];
+    size_type tail = _tail.load(std::memory_order_relaxed);
+    cnt = _room(tail,cnt);
+    _spans(spans,tail,cnt);
+    _Raw::copy_range(spans[0].data,elems,spans[0].length);
+    _Raw::copy_range(spans[1].data,elems+spans[0].length,spans[1].length);
+    _tail.store(tail+cnt,std::memory_order_release);
+    return cnt;
+}
+template<class T,class Alloc>
+bool rtypes::spsc_queue<T,Alloc>::try_pop(T& elem)
+{
+    size_type head = _head.load(std::memory_order_relaxed);
+    if (_available(head,1) == 0)
+        return false;
+    T* p = _data+(head&_mask);
+    elem = std::move(*p);
+    _Raw::destroy(p);
+    _head.store(head+1,std::memory_order_release);
+    return true;
+}
+template<class T,class Alloc>
+T rtypes::spsc_queue<T,Alloc>::pop()
+{
+    _rcon_backoff backoff;
+    size_type head = _head.load(std::memory_order_relaxed);
+    while (_available(head,1) == 0)
+        backoff.wait();
+    // move the element out before it is destroyed
+    T* p = _data+(head&_mask);
+    T r( std::move(*p) );
+    _Raw::destroy(p);
+    _head.store(head+1,std::memory_order_release);
+    return r;
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::spsc_queue<T,Alloc>::pop_range(T* dest,size_type cnt)
+{
+    queue_span<T> spans[2];
+    size_type head = _head.load(std::memory_order_relaxed);
+    cnt = _available(head,cnt);
+    _spans(spans,head,cnt);
+    for (size_type s = 0;s<2;s++)
+    {
+        if (_Raw::trivial_copy)
+        {
+            if (spans[s].length > 0)
+                rutil_memcpy(dest,spans[s].data,spans[s].length*sizeof(T));
+        }
+        else
+            for (size_type i = 0;i<spans[s].length;i++)
+                dest[i] = std::move(spans[s].data[i]);
+        _Raw::destroy_range(spans[s].data,spans[s].length);
+        dest += spans[s].length;
+    }
+    _head.store(head+cnt,std::memory_order_release);
+    return cnt;
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::spsc_queue<T,Alloc>::pop_range(size_type cnt)
+{
+    queue_span<T> spans[2];
+    size_type head = _head.load(std::memory_order_relaxed);
+    cnt = _available(head,cnt);
+    _spans(spans,head,cnt);
+    _Raw::destroy_range(spans[0].data,spans[0].length);
+    _Raw::destroy_range(spans[1].data,spans[1].length);
+    _head.store(head+cnt,std::memory_order_release);
+    return cnt;
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::spsc_queue<T,Alloc>::peek_range(queue_span<T>& first,queue_span<T>& second)
+{
+    queue_span<T> spans[2];
+    size_type head = _head.load(std::memory_order_relaxed);
+    size_type cnt = _available(head,_mask+1);
+    _spans(spans,head,cnt);
+    first = spans[0];
+    second = spans[1];
+    return cnt;
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::spsc_queue<T,Alloc>::_available(size_type head,size_type cnt)
+{
+    // reload the producer's index only if the cached copy falls short
+    if (_tailCache-head < cnt)
+        _tailCache = _tail.load(std::memory_order_acquire);
+    size_type avail = _tailCache-head;
+    return (avail<cnt ? avail : cnt);
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::spsc_queue<T,Alloc>::_room(size_type tail,size_type cnt)
+{
+    size_type cap = _mask+1;
+    if (cap-(tail-_headCache) < cnt)
+        _headCache = _head.load(std::memory_order_acquire);
+    size_type room = cap-(tail-_headCache);
+    return (room<cnt ? room : cnt);
+}
+template<class T,class Alloc>
+void rtypes::spsc_queue<T,Alloc>::_spans(queue_span<T>* spans,size_type pos,size_type cnt) const
+{
+    // splits 'cnt' slots starting at 'pos' at the end of the buffer
+    size_type i = pos&_mask, first = _mask+1-i;
+    if (first > cnt)
+        first = cnt;
+    spans[0].data = _data+i;
+    spans[0].length = first;
+    spans[1].data = _data;
+    spans[1].length = cnt-first;
+}
+
+// rtypes::mpmc_queue<>
+template<class T,class Alloc>
+rtypes::mpmc_queue<T,Alloc>::mpmc_queue(size_type capacity,const Alloc& allocator)
+    : Alloc(allocator), _enqueuePos(0), _dequeuePos(0)
+{
+    size_type cap = 2;
+    while (cap < capacity)
+        cap <<= 1;
+    _cells = static_cast<_Cell*>( _allocator().allocate(cap*sizeof(_Cell)) );
+    for (size_type i = 0;i<cap;i++)
+        new (&_cells[i].seq) std::atomic<size_type>(i);
+    _mask = cap-1;
+}
+template<class T,class Alloc>
+rtypes::mpmc_queue<T,Alloc>::~mpmc_queue()
+{
+    // no other thread may use the queue now
+    size_type pos = _dequeuePos.load(std::memory_order_relaxed), end = _enqueuePos.load(std::memory_order_relaxed);
+    for (;pos!=end;pos++)
+        _Raw::destroy(_cells[pos&_mask].elem());
+    for (size_type i = 0;i<=_mask;i++)
+        _cells[i].seq.~atomic();
+    _allocator().deallocate(_cells,(_mask+1)*sizeof(_Cell));
+}
+template<class T,class Alloc>
+bool rtypes::mpmc_queue<T,Alloc>::try_push(const T& elem)
+{
+    size_type pos;
+    if (_claimPush(pos,1) == 0)
+        return false;
+    _Cell* cell = _cells+(pos&_mask);
+    _Raw::construct(cell->elem(),elem);
+    cell->seq.store(pos+1,std::memory_order_release);
+    return true;
+}
+template<class T,class Alloc>
+void rtypes::mpmc_queue<T,Alloc>::push(const T& elem)
+{
+    _rcon_backoff backoff;
+    while ( !try_push(elem) )
+        backoff.wait();
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::mpmc_queue<T,Alloc>::push_range(const T* elems,size_type cnt)
+{
+    size_type pos;
+    cnt = _claimPush(pos,cnt);
+    for (size_type i = 0;i<cnt;i++)
+    {
+        _Cell* cell = _cells+((pos+i)&_mask);
+        _Raw::construct(cell->elem(),elems[i]);
+        cell->seq.store(pos+i+1,std::memory_order_release);
+    }
+    return cnt;
+}
+template<class T,class Alloc>
+bool rtypes::mpmc_queue<T,Alloc>::try_pop(T& elem)
+{
+    size_type pos;
+    if (_claimPop(pos,1) == 0)
+        return false;
+    _Cell* cell = _cells+(pos&_mask);
+    elem = std::move(*cell->elem());
+    _Raw::destroy(cell->elem());
+    // the slot is next pushed one lap later
+    cell->seq.store(pos+_mask+1,std::memory_order_release);
+    return true;
+}
+template<class T,class Alloc>
+T rtypes::mpmc_queue<T,Alloc>::pop()
+{
+    _rcon_backoff backoff;
+    size_type pos;
+    while (_claimPop(pos,1) == 0)
+        backoff.wait();
+    // move the element out before it is destroyed
+    _Cell* cell = _cells+(pos&_mask);
+    T r( std::move(*cell->elem()) );
+    _Raw::destroy(cell->elem());
+    cell->seq.store(pos+_mask+1,std::memory_order_release);
+    return r;
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::mpmc_queue<T,Alloc>::pop_range(T* dest,size_type cnt)
+{
+    size_type pos;
+    cnt = _claimPop(pos,cnt);
+    for (size_type i = 0;i<cnt;i++)
+    {
+        _Cell* cell = _cells+((pos+i)&_mask);
+        dest[i] = std::move(*cell->elem());
+        _Raw::destroy(cell->elem());
+        cell->seq.store(pos+i+_mask+1,std::memory_order_release);
+    }
+    return cnt;
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::mpmc_queue<T,Alloc>::size() const
+{
+    size_type head = _dequeuePos.load(std::memory_order_acquire);
+    size_type tail = _enqueuePos.load(std::memory_order_acquire);
+    // the indexes are read at different times
+    if (ssize_type(tail-head) <= 0)
+        return 0;
+    return (tail-head>_mask+1 ? _mask+1 : tail-head);
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::mpmc_queue<T,Alloc>::_claimPush(size_type& pos,size_type cnt)
+{
+    pos = _enqueuePos.load(std::memory_order_relaxed);
+    if (cnt > _mask+1)
+        cnt = _mask+1;
+    while (cnt > 0)
+    {
+        // count the adjacent slots that are free for their positions; a free
+        // slot stays free until its position is claimed, so the run is safe
+        // to take if the index has not moved in the meantime
+        size_type n = 0;
+        while (n<cnt && _cells[(pos+n)&_mask].seq.load(std::memory_order_acquire)==pos+n)
+            ++n;
+        if (n > 0)
+        {
+            if ( _enqueuePos.compare_exchange_weak(pos,pos+n,std::memory_order_relaxed) )
+                return n;
+        }
+        else
+        {
+            ssize_type dif = ssize_type(_cells[pos&_mask].seq.load(std::memory_order_acquire) - pos);
+            if (dif < 0)
+                return 0; // the slot has not been popped from the last lap: full
+            pos = _enqueuePos.load(std::memory_order_relaxed); // another producer took the position
+        }
+    }
+    return 0;
+}
+template<class T,class Alloc>
+rtypes::size_type rtypes::mpmc_queue<T,Alloc>::_claimPop(size_type& pos,size_type cnt)
+{
+    pos = _dequeuePos.load(std::memory_order_relaxed);
+    if (cnt > _mask+1)
+        cnt = _mask+1;
+    while (cnt > 0)
+    {
+        size_type n = 0;
+        while (n<cnt && _cells[(pos+n)&_mask].seq.load(std::memory_order_acquire)==pos+n+1)
+            ++n;
+        if (n > 0)
+        {
+            if ( _dequeuePos.compare_exchange_weak(pos,pos+n,std::memory_order_relaxed) )
+                return n;
+        }
+        else
+        {
+            ssize_type dif = ssize_type(_cells[pos&_mask].seq.load(std::memory_order_acquire) - (pos+1));
+            if (dif < 0)
+                return 0; // the slot has not been pushed yet: empty
+            pos = _dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    return 0;
+}
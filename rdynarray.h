@@ -6,13 +6,14 @@
 
 namespace rtypes
 {
-    template<typename T>
-    class dynamic_array : protected rallocatorEx<T>
+    template<typename T,class Alloc = default_allocator>
+    class dynamic_array : protected rallocatorEx<T,Alloc>
     {
     public:
         dynamic_array();
-        explicit dynamic_array(size_type iniSize);
-        dynamic_array(size_type iniSize,const T& defaultValue);
+        explicit dynamic_array(const Alloc& allocator);
+        explicit dynamic_array(size_type iniSize,const Alloc& allocator = Alloc());
+        dynamic_array(size_type iniSize,const T& defaultValue,const Alloc& allocator = Alloc());
 
         T& operator [](size_type index);
         const T& operator [](size_type index) const;
@@ -25,7 +26,11 @@ namespace rtypes
         const T& back() const;
 
         void push_back(const T& element);
-        T& pop_back();
+        void push_back(T&& element);
+        template<class... Args>
+        T& emplace_back(Args&&... args) // constructs a new last element in place from 'args'
+        { _virtEmplace(std::forward<Args>(args)...); return _getData()[_size()-1]; }
+        T pop_back();
 
         T& operator ++();
         T& operator ++(int);
@@ -40,13 +45,96 @@ namespace rtypes
         { return _size(); }
         size_type capacity() const
         { return _allocationSize(); }
+
+        using rallocatorEx<T,Alloc>::get_allocator;
     protected:
-        using rallocatorEx<T>::_exactAlloc;
-        using rallocatorEx<T>::_virtAlloc;
-        using rallocatorEx<T>::_allocationSize;
-        using rallocatorEx<T>::_size;
-        using rallocatorEx<T>::_getData;
-        using rallocatorEx<T>::_dealloc;
+        using rallocatorEx<T,Alloc>::_exactAlloc;
+        using rallocatorEx<T,Alloc>::_virtAlloc;
+        using rallocatorEx<T,Alloc>::_virtPush;
+        using rallocatorEx<T,Alloc>::_virtEmplace;
+        using rallocatorEx<T,Alloc>::_allocationSize;
+        using rallocatorEx<T,Alloc>::_size;
+        using rallocatorEx<T,Alloc>::_getData;
+        using rallocatorEx<T,Alloc>::_dealloc;
+    };
+
+    /* small_array
+     *  a dynamic array with the interface of dynamic_array that stores up to N
+     * elements inside the object itself and moves them to heap storage only
+     * when it grows beyond that; an array that has spilled to the heap returns
+     * to inline storage when it is reset or resized exactly to N or fewer
+     * elements; capacity() is never less than N; moving between inline and
+     * heap storage invalidates references to the elements
+     */
+    template<typename T,size_type N,class Alloc = default_allocator>
+    class small_array : private Alloc
+    {
+        static_assert(N > 0,"small_array must have inline capacity");
+        typedef _rallocator_raw<T> _Raw;
+        typedef typename std::aligned_storage<sizeof(T)*N,alignof(T)>::type _Storage;
+    public:
+        small_array();
+        explicit small_array(const Alloc& allocator);
+        explicit small_array(size_type iniSize,const Alloc& allocator = Alloc());
+        small_array(size_type iniSize,const T& defaultValue,const Alloc& allocator = Alloc());
+        small_array(const small_array& obj);
+        small_array(small_array&& obj); // takes heap storage; inline elements are moved one by one
+        ~small_array();
+
+        small_array& operator =(const small_array& obj);
+        small_array& operator =(small_array&& obj);
+
+        T& operator [](size_type index)
+        { return _data[index]; }
+        const T& operator [](size_type index) const
+        { return _data[index]; }
+        T& at(size_type index);
+        const T& at(size_type index) const;
+
+        T& front();
+        const T& front() const;
+        T& back();
+        const T& back() const;
+
+        void push_back(const T& element)
+        { emplace_back(element); }
+        void push_back(T&& element)
+        { emplace_back( std::move(element) ); }
+        template<class... Args>
+        T& emplace_back(Args&&... args); // constructs a new last element in place from 'args'
+        T pop_back();
+
+        T& operator ++();
+        T& operator ++(int);
+
+        void resize(size_type allocSize,bool exact = false);
+        void clear();
+        void reset();
+
+        bool is_empty() const
+        { return _sz==0; }
+        size_type size() const
+        { return _sz; }
+        size_type capacity() const
+        { return _cap; }
+        bool is_inline() const // determines if the elements are stored inside the object
+        { return _data==_inlineData(); }
+
+        Alloc get_allocator() const
+        { return *this; }
+    private:
+        T* _data; // points at the inline storage or at a heap allocation of _cap elements
+        size_type _sz, _cap;
+        _Storage _inline;
+
+        Alloc& _allocator()
+        { return *this; }
+        T* _inlineData() const
+        { return reinterpret_cast<T*>( const_cast<_Storage*>(&_inline) ); }
+        size_type _growSize(size_type desiredSize) const;
+        void _reallocate(size_type newCap); // newCap must hold the elements; N selects the inline storage
+        void _freeHeap();
+        void _take(small_array& obj); // moves the elements and any heap storage of 'obj' into this (empty, inline) array
     };
 }
 
@@ -1,122 +1,395 @@
 // rdynarray.tcc - out-of-line implementation for rdynarray
 
-template<typename T>
-rtypes::dynamic_array<T>::dynamic_array()
+template<typename T,class Alloc>
+rtypes::dynamic_array<T,Alloc>::dynamic_array()
 {
 }
-template<typename T>
-rtypes::dynamic_array<T>::dynamic_array(size_type iniSize)
+template<typename T,class Alloc>
+rtypes::dynamic_array<T,Alloc>::dynamic_array(const Alloc& allocator)
+    : rallocatorEx<T,Alloc>(allocator)
 {
-    _exactAlloc(iniSize);
 }
-template<typename T>
-rtypes::dynamic_array<T>::dynamic_array(size_type iniSize,const T& defaultValue)
+template<typename T,class Alloc>
+rtypes::dynamic_array<T,Alloc>::dynamic_array(size_type iniSize,const Alloc& allocator)
+    : rallocatorEx<T,Alloc>(allocator)
 {
-    T* data;
     _exactAlloc(iniSize);
-    data = _getData();
-    for (size_type i = 0;i<iniSize;i++)
-        data[i] = defaultValue;
 }
-template<typename T>
-T& rtypes::dynamic_array<T>::operator [](size_type i)
+template<typename T,class Alloc>
+rtypes::dynamic_array<T,Alloc>::dynamic_array(size_type iniSize,const T& defaultValue,const Alloc& allocator)
+    : rallocatorEx<T,Alloc>(allocator)
+{
+    _exactAlloc(iniSize,defaultValue);
+}
+template<typename T,class Alloc>
+T& rtypes::dynamic_array<T,Alloc>::operator [](size_type i)
 {
     return _getData()[i];
 }
-template<typename T>
-const T& rtypes::dynamic_array<T>::operator [](size_type i) const
+template<typename T,class Alloc>
+const T& rtypes::dynamic_array<T,Alloc>::operator [](size_type i) const
 {
     return _getData()[i];
 }
-template<typename T>
-T& rtypes::dynamic_array<T>::at(size_type i)
+template<typename T,class Alloc>
+T& rtypes::dynamic_array<T,Alloc>::at(size_type i)
 {
     if (i < _size())
         return _getData()[i];
     throw out_of_bounds_error();
 }
-template<typename T>
-const T& rtypes::dynamic_array<T>::at(size_type i) const
+template<typename T,class Alloc>
+const T& rtypes::dynamic_array<T,Alloc>::at(size_type i) const
 {
     if (i < _size())
         return _getData()[i];
     throw out_of_bounds_error();
 }
-template<typename T>
-T& rtypes::dynamic_array<T>::front()
+template<typename T,class Alloc>
+T& rtypes::dynamic_array<T,Alloc>::front()
 {
     if (0 < _size())
         return _getData()[0];
     throw element_not_found_error();
 }
-template<typename T>
-const T& rtypes::dynamic_array<T>::front() const
+template<typename T,class Alloc>
+const T& rtypes::dynamic_array<T,Alloc>::front() const
 {
     if (0 < _size())
         return _getData()[0];
     throw element_not_found_error();
 }
-template<typename T>
-T& rtypes::dynamic_array<T>::back()
+template<typename T,class Alloc>
+T& rtypes::dynamic_array<T,Alloc>::back()
 {
     size_type sz = _size();
-    if (0 == --sz)
-        return _getData()[sz];
+    if (sz > 0)
+        return _getData()[sz-1];
     throw element_not_found_error();
 }
-template<typename T>
-const T& rtypes::dynamic_array<T>::back() const
+template<typename T,class Alloc>
+const T& rtypes::dynamic_array<T,Alloc>::back() const
 {
     size_type sz = _size();
-    if (0 == --sz)
-        return _getData()[sz];
+    if (sz > 0)
+        return _getData()[sz-1];
     throw element_not_found_error();
 }
-template<typename T>
-void rtypes::dynamic_array<T>::push_back(const T& elem)
+template<typename T,class Alloc>
+void rtypes::dynamic_array<T,Alloc>::push_back(const T& elem)
 {
-    size_type sz = _size();
-    _virtAlloc(sz+1);
-    _getData()[sz] = elem;
+    _virtPush(elem);
 }
-template<typename T>
-T& rtypes::dynamic_array<T>::pop_back()
+template<typename T,class Alloc>
+void rtypes::dynamic_array<T,Alloc>::push_back(T&& elem)
+{
+    _virtPush( std::move(elem) );
+}
+template<typename T,class Alloc>
+T rtypes::dynamic_array<T,Alloc>::pop_back()
 {
     size_type sz = _size();
-    _virtAlloc(--sz);
-    return _getData()[sz];
+    if (sz == 0)
+        throw empty_container_error();
+    // move the element out before it is destroyed
+    T elem( std::move(_getData()[--sz]) );
+    _virtAlloc(sz);
+    return elem;
 }
-template<typename T>
-T& rtypes::dynamic_array<T>::operator ++()
+template<typename T,class Alloc>
+T& rtypes::dynamic_array<T,Alloc>::operator ++()
 {
     // add new default element and return reference
     size_type sz = _size();
     _virtAlloc(sz+1);
     return _getData()[sz];
 }
-template<typename T>
-T& rtypes::dynamic_array<T>::operator ++(int)
+template<typename T,class Alloc>
+T& rtypes::dynamic_array<T,Alloc>::operator ++(int)
 {
     // same as prefix
     size_type sz = _size();
     _virtAlloc(sz+1);
     return _getData()[sz];
 }
-template<typename T>
-void rtypes::dynamic_array<T>::resize(size_type allocSize,bool exact)
+template<typename T,class Alloc>
+void rtypes::dynamic_array<T,Alloc>::resize(size_type allocSize,bool exact)
 {
     if (exact)
         _exactAlloc(allocSize);
     else
         _virtAlloc(allocSize);
 }
-template<typename T>
-void rtypes::dynamic_array<T>::clear()
+template<typename T,class Alloc>
+void rtypes::dynamic_array<T,Alloc>::clear()
 {
     _virtAlloc(0);
 }
-template<typename T>
-void rtypes::dynamic_array<T>::reset()
+template<typename T,class Alloc>
+void rtypes::dynamic_array<T,Alloc>::reset()
 {
     _dealloc();
 }
+
+// rtypes::small_array<>
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::small_array<T,N,Alloc>::small_array()
+{
+    _data = _inlineData();
+    _sz = 0;
+    _cap = N;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::small_array<T,N,Alloc>::small_array(const Alloc& allocator)
+    : Alloc(allocator)
+{
+    _data = _inlineData();
+    _sz = 0;
+    _cap = N;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::small_array<T,N,Alloc>::small_array(size_type iniSize,const Alloc& allocator)
+    : Alloc(allocator)
+{
+    _data = _inlineData();
+    _sz = 0;
+    _cap = N;
+    if (iniSize > N)
+        _reallocate(iniSize);
+    _Raw::construct_range(_data,iniSize);
+    _sz = iniSize;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::small_array<T,N,Alloc>::small_array(size_type iniSize,const T& defaultValue,const Alloc& allocator)
+    : Alloc(allocator)
+{
+    _data = _inlineData();
+    _sz = 0;
+    _cap = N;
+    if (iniSize > N)
+        _reallocate(iniSize);
+    _Raw::construct_range(_data,iniSize,defaultValue);
+    _sz = iniSize;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::small_array<T,N,Alloc>::small_array(const small_array& obj)
+    : Alloc(obj)
+{
+    _data = _inlineData();
+    _sz = 0;
+    _cap = N;
+    if (obj._sz > N)
+        _reallocate(obj._sz);
+    _Raw::copy_range(_data,obj._data,obj._sz);
+    _sz = obj._sz;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::small_array<T,N,Alloc>::small_array(small_array&& obj)
+    : Alloc(obj)
+{
+    _data = _inlineData();
+    _sz = 0;
+    _cap = N;
+    _take(obj);
+}
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::small_array<T,N,Alloc>::~small_array()
+{
+    _Raw::destroy_range(_data,_sz);
+    _freeHeap();
+}
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::small_array<T,N,Alloc>& rtypes::small_array<T,N,Alloc>::operator =(const small_array& obj)
+{
+    if (this != &obj)
+    {
+        _Raw::destroy_range(_data,_sz);
+        _sz = 0;
+        if (_cap < obj._sz)
+        {
+            _freeHeap();
+            _reallocate(obj._sz);
+        }
+        _Raw::copy_range(_data,obj._data,obj._sz);
+        _sz = obj._sz;
+    }
+    return *this;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::small_array<T,N,Alloc>& rtypes::small_array<T,N,Alloc>::operator =(small_array&& obj)
+{
+    if (this != &obj)
+    {
+        reset();
+        // heap storage must be freed by the allocator that produced it
+        _allocator() = obj._allocator();
+        _take(obj);
+    }
+    return *this;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+T& rtypes::small_array<T,N,Alloc>::at(size_type i)
+{
+    if (i < _sz)
+        return _data[i];
+    throw out_of_bounds_error();
+}
+template<typename T,rtypes::size_type N,class Alloc>
+const T& rtypes::small_array<T,N,Alloc>::at(size_type i) const
+{
+    if (i < _sz)
+        return _data[i];
+    throw out_of_bounds_error();
+}
+template<typename T,rtypes::size_type N,class Alloc>
+T& rtypes::small_array<T,N,Alloc>::front()
+{
+    if (_sz > 0)
+        return _data[0];
+    throw element_not_found_error();
+}
+template<typename T,rtypes::size_type N,class Alloc>
+const T& rtypes::small_array<T,N,Alloc>::front() const
+{
+    if (_sz > 0)
+        return _data[0];
+    throw element_not_found_error();
+}
+template<typename T,rtypes::size_type N,class Alloc>
+T& rtypes::small_array<T,N,Alloc>::back()
+{
+    if (_sz > 0)
+        return _data[_sz-1];
+    throw element_not_found_error();
+}
+template<typename T,rtypes::size_type N,class Alloc>
+const T& rtypes::small_array<T,N,Alloc>::back() const
+{
+    if (_sz > 0)
+        return _data[_sz-1];
+    throw element_not_found_error();
+}
+template<typename T,rtypes::size_type N,class Alloc>
+template<class... Args>
+T& rtypes::small_array<T,N,Alloc>::emplace_back(Args&&... args)
+{
+    if (_sz == _cap)
+    {
+        // construct the new element before relocating the old elements
+        // in case an argument refers to an element in the old storage
+        size_type newCap = _growSize(_sz+1);
+        T* newData = _Raw::allocate(_allocator(),newCap);
+        _Raw::emplace(newData+_sz,std::forward<Args>(args)...);
+        _Raw::relocate_range(newData,_data,_sz);
+        _freeHeap();
+        _data = newData;
+        _cap = newCap;
+    }
+    else
+        _Raw::emplace(_data+_sz,std::forward<Args>(args)...);
+    return _data[_sz++];
+}
+template<typename T,rtypes::size_type N,class Alloc>
+T rtypes::small_array<T,N,Alloc>::pop_back()
+{
+    if (_sz == 0)
+        throw empty_container_error();
+    // move the element out before it is destroyed
+    T elem( std::move(_data[--_sz]) );
+    _Raw::destroy(_data+_sz);
+    return elem;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+T& rtypes::small_array<T,N,Alloc>::operator ++()
+{
+    // add new default element and return reference
+    resize(_sz+1);
+    return _data[_sz-1];
+}
+template<typename T,rtypes::size_type N,class Alloc>
+T& rtypes::small_array<T,N,Alloc>::operator ++(int)
+{
+    // same as prefix
+    resize(_sz+1);
+    return _data[_sz-1];
+}
+template<typename T,rtypes::size_type N,class Alloc>
+void rtypes::small_array<T,N,Alloc>::resize(size_type allocSize,bool exact)
+{
+    if (allocSize < _sz)
+    {
+        _Raw::destroy_range(_data+allocSize,_sz-allocSize);
+        _sz = allocSize;
+    }
+    if (exact)
+    {
+        // the storage is made to fit unless the elements fit inline
+        size_type newCap = (allocSize>N ? allocSize : N);
+        if (newCap != _cap)
+            _reallocate(newCap);
+    }
+    else if (allocSize > _cap)
+        _reallocate( _growSize(allocSize) );
+    if (allocSize > _sz)
+    {
+        _Raw::construct_range(_data+_sz,allocSize-_sz);
+        _sz = allocSize;
+    }
+}
+template<typename T,rtypes::size_type N,class Alloc>
+void rtypes::small_array<T,N,Alloc>::clear()
+{
+    _Raw::destroy_range(_data,_sz);
+    _sz = 0;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+void rtypes::small_array<T,N,Alloc>::reset()
+{
+    _Raw::destroy_range(_data,_sz);
+    _sz = 0;
+    _freeHeap();
+}
+template<typename T,rtypes::size_type N,class Alloc>
+rtypes::size_type rtypes::small_array<T,N,Alloc>::_growSize(size_type desiredSize) const
+{
+    size_type newCap = _cap*2;
+    while (newCap < desiredSize)
+        newCap *= 2;
+    return newCap;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+void rtypes::small_array<T,N,Alloc>::_reallocate(size_type newCap)
+{
+    T* newData = (newCap==N ? _inlineData() : _Raw::allocate(_allocator(),newCap));
+    if (newData != _data)
+    {
+        _Raw::relocate_range(newData,_data,_sz);
+        _freeHeap();
+        _data = newData;
+        _cap = newCap;
+    }
+}
+template<typename T,rtypes::size_type N,class Alloc>
+void rtypes::small_array<T,N,Alloc>::_freeHeap()
+{
+    // the elements must have been destroyed or relocated
+    if ( !is_inline() )
+        _Raw::deallocate(_allocator(),_data,_cap);
+    _data = _inlineData();
+    _cap = N;
+}
+template<typename T,rtypes::size_type N,class Alloc>
+void rtypes::small_array<T,N,Alloc>::_take(small_array& obj)
+{
+    if ( obj.is_inline() )
+        _Raw::relocate_range(_data,obj._data,obj._sz);
+    else
+    {
+        _data = obj._data;
+        _cap = obj._cap;
+        obj._data = obj._inlineData();
+        obj._cap = N;
+    }
+    _sz = obj._sz;
+    obj._sz = 0;
+}
@@ -67,6 +67,11 @@ path::path(const generic_string& pathName,const generic_string& relativeTo)
     _parts[1] = relativeTo;
     _checkParts();
 }
+path::path(const string_ref& pathName)
+{
+    _parts[0] = pathName;
+    _checkParts();
+}
 path& path::operator =(const char* pathName)
 {
     _parts[0] = pathName;
@@ -81,28 +86,32 @@ path& path::operator =(const generic_string& pathName)
     _checkParts();
     return *this;
 }
-path& path::operator +=(const char* component)
+path& path::operator =(const string_ref& pathName)
 {
-    if (component[0])
-    {
-        if (component[0] != PATH_SEP)
-        {
-            if (_parts[0].length()>0 && _parts[0][_parts[0].length()-1]!=PATH_SEP)
-                _parts[0] += PATH_SEP;
-            _parts[0] += component;
-            _checkParts();
-        }
-        else
-            throw undefined_operation_error();
-    }
+    _parts[0] = pathName;
+    _parts[1].clear();
+    _checkParts();
     return *this;
 }
+path& path::operator +=(const char* component)
+{
+    return this->operator +=( string_ref(component) );
+}
 path& path::operator +=(const generic_string& component)
+{
+    return this->operator +=( string_ref(component) );
+}
+path& path::operator +=(const string_ref& component)
 {
     if (component.size() > 0)
     {
         if (component[0] != PATH_SEP)
         {
+            // the component may refer into our own buffer, which appending
+            // the separator can reallocate; append a copy of it instead
+            const char* own = _parts[0].c_str();
+            if (component.data()>=own && component.data()<=own+_parts[0].length())
+                return this->operator +=( str(component) );
             if (_parts[0].length()>0 && _parts[0][_parts[0].length()-1]!=PATH_SEP)
                 _parts[0] += PATH_SEP;
             _parts[0] += component;
@@ -333,6 +342,12 @@ filename::filename(const path& pathLocation,const generic_string& name)
     // should be a relative path string, else an error will be thrown
     _path.append_name(source);
 }
+filename::filename(const string_ref& name)
+{
+    str source(name);
+    _trunLeader(source);
+    _path = source;
+}
 filename& filename::operator =(const char* ps)
 {
     str source(ps);
@@ -347,6 +362,13 @@ filename& filename::operator =(const generic_string& s)
     _path = source;
     return *this;
 }
+filename& filename::operator =(const string_ref& s)
+{
+    str source(s);
+    _trunLeader(source);
+    _path = source;
+    return *this;
+}
 bool filename::has_extension() const
 {
     return get_extension(false).length() > 0;
@@ -582,6 +604,12 @@ path rtypes::operator +(const path& p,const generic_string& s)
     cpy += s;
     return cpy;
 }
+path rtypes::operator +(const path& p,const string_ref& s)
+{
+    path cpy(p);
+    cpy += s;
+    return cpy;
+}
 filename rtypes::operator +(const path& p,const filename& fn)
 {
     filename r;
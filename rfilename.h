@@ -49,11 +49,14 @@ namespace rtypes
         path(const generic_string& pathName); // construct path from the specified string name (relative paths will be relative to the current working directory)
         path(const char* pathName,const char* relativeTo); // construct path from the specified string name, using the specified relative directory
         path(const generic_string& pathName,const generic_string& relativeTo); // construct path from the specified string name, using the specified relative directory
+        path(const string_ref& pathName); // construct path from the referenced name
 
         path& operator =(const char*); // set the path name [terr]
         path& operator =(const generic_string&); // set the path name [terr]
         path& operator +=(const char*); // append the specified name to the full path [terr]
         path& operator +=(const generic_string&); // append the specified name to the full path [terr]
+        path& operator =(const string_ref&); // [terr]
+        path& operator +=(const string_ref&); // [terr]
         path& operator +=(const path&); // append differences to the full path [terr]
 
         bool exists() const; // returns true if the path exists [sys] [terr]
@@ -128,9 +131,11 @@ namespace rtypes
         filename(const generic_string& pathLocation,const generic_string& name);
         filename(const path& pathLocation,const char* name);
         filename(const path& pathLocation,const generic_string& name);
+        filename(const string_ref& name);
 
         filename& operator =(const char*);
         filename& operator =(const generic_string&);
+        filename& operator =(const string_ref&);
 
         bool exists() const; // indicates whether or not the file name exists in the filesystem [sys] [terr]
         bool has_extension() const; // indicates whether or not the file name object contains an extension
@@ -181,6 +186,7 @@ namespace rtypes
     // path/file name concatenation
     path operator +(const path&,const char*);
     path operator +(const path&,const generic_string&);
+    path operator +(const path&,const string_ref&);
     filename operator +(const path&,const filename&);
 }
 
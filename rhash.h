@@ -0,0 +1,89 @@
+// rhash.h - provides hashing traits for rlibrary hashed containers
+#ifndef RHASH_H
+#define RHASH_H
+#include "rtypestypes.h"
+#include "rstring.h"
+
+namespace rtypes
+{
+    /* hash<T>
+     *  hashing trait used by the hashed containers; a specialization provides
+     * 'uint64 operator ()(const T&) const'; specializations exist for the built-in
+     * integer types and the rlibrary string types; the hashed containers scramble
+     * every hash value (Fibonacci hashing) before using it, so the integer hashes
+     * are simply the value itself
+     */
+    template<typename T>
+    struct hash;
+
+    template<typename Integer>
+    struct _hash_integer
+    {
+        uint64 operator ()(Integer value) const
+        { return uint64(value); }
+    };
+
+    template<> struct hash<bool> : _hash_integer<bool> {};
+    template<> struct hash<char> : _hash_integer<char> {};
+    template<> struct hash<signed char> : _hash_integer<signed char> {};
+    template<> struct hash<unsigned char> : _hash_integer<unsigned char> {};
+    template<> struct hash<wchar_t> : _hash_integer<wchar_t> {};
+    template<> struct hash<short> : _hash_integer<short> {};
+    template<> struct hash<unsigned short> : _hash_integer<unsigned short> {};
+    template<> struct hash<int> : _hash_integer<int> {};
+    template<> struct hash<unsigned int> : _hash_integer<unsigned int> {};
+    template<> struct hash<long> : _hash_integer<long> {};
+    template<> struct hash<unsigned long> : _hash_integer<unsigned long> {};
+    template<> struct hash<long long> : _hash_integer<long long> {};
+    template<> struct hash<unsigned long long> : _hash_integer<unsigned long long> {};
+
+    /* _hash_chars
+     *  64-bit FNV-1a over a character sequence; each character is hashed by
+     * value so that narrow and wide strings with the same contents agree
+     */
+    template<typename CharType>
+    inline uint64 _hash_chars(const CharType* pchars,size_type len)
+    {
+        uint64 h = 14695981039346656037ull;
+        for (size_type i = 0;i<len;i++)
+        {
+            h ^= uint64(pchars[i]);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // the same hash over a null-terminated sequence, in one pass
+    template<typename CharType>
+    inline uint64 _hash_cstring(const CharType* pchars)
+    {
+        uint64 h = 14695981039346656037ull;
+        while (*pchars)
+        {
+            h ^= uint64(*pchars++);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    template<typename CharType>
+    struct hash< rtype_string<CharType> >
+    {
+        uint64 operator ()(const rtype_string<CharType>& s) const
+        { return _hash_chars(s.c_str(),s.size()); }
+        // agrees with the string overload so that containers
+        // may be searched without constructing a string
+        uint64 operator ()(const CharType* s) const
+        { return _hash_cstring(s); }
+        uint64 operator ()(const basic_string_ref<CharType>& s) const
+        { return _hash_chars(s.data(),s.size()); }
+    };
+    template<typename CharType,class Alloc>
+    struct hash< deep_string<CharType,Alloc> > : hash< rtype_string<CharType> > {};
+    template<typename CharType>
+    struct hash< shallow_string<CharType> > : hash< rtype_string<CharType> > {};
+    template<typename CharType>
+    struct hash< basic_string_ref<CharType> > : hash< rtype_string<CharType> > {};
+}
+
+#endif
@@ -39,6 +39,15 @@ namespace rtypes
         all_access = 0x0003
     };
 
+    /* io_vector
+     *  describes one buffer of a vectored (gather) write
+     */
+    struct io_vector
+    {
+        const void* base;
+        size_type length;
+    };
+
     /* io_resource
      *  describes a system IO resource in a cross-platform way;
      * 8 bytes are allocated for the resource identifier (handle,
@@ -76,8 +85,12 @@ namespace rtypes
         void write(const generic_string& buffer) // writes the size of the specified string buffer to the device
         { _writeBuffer(buffer.c_str(),buffer.size()); }
         void write(const char* stringBuffer); // writes null-terminated string buffer to the device
+        void write(const string_ref& chars) // writes the referenced characters to the device
+        { _writeBuffer(chars.data(),chars.size()); }
         void write(const void* buffer,size_type length) // writes the specified buffer to the device
         { _writeBuffer(buffer,length); }
+        void write(const io_vector* buffers,size_type count) // writes the specified buffers in order with as few system calls as possible; the last byte count is the total written, which may stop short after any buffer
+        { _writeVector(buffers,count); }
 
         io_operation_flag get_last_operation_status() const // returns the last operation status flag
         { return _lastOp; }
@@ -134,6 +147,7 @@ namespace rtypes
         void _readBuffer(const io_resource* context,void* buffer,size_type bytesToRead) const; // (from specified device context)
         void _writeBuffer(const void* buffer,size_type length); // writes a buffer to the output device [sys]
         void _writeBuffer(const io_resource* context,const void* buffer,size_type length); // (to specified device context)
+        void _writeVector(const io_vector* buffers,size_type count); // writes a sequence of buffers to the output device [sys]
 
         static int& _ResourceRef(io_resource*);
     private:
@@ -4,6 +4,7 @@
 
 // include POSIX and other system headers
 #include <unistd.h>
+#include <sys/uio.h>
 
 // rtypes::io_resource
 io_resource::io_resource(bool closable)
@@ -136,6 +137,46 @@ void io_device::_writeBuffer(const io_resource* context,const void* buffer,size_
         _byteCount = 0;
     }
 }
+void io_device::_writeVector(const io_vector* buffers,size_type count)
+{
+    if (_output != NULL)
+    {
+        // gather the buffers in batches; a short write ends the operation
+        const size_type BATCH = 64;
+        struct iovec vecs[BATCH];
+        size_type total = 0;
+        _lastOp = no_output;
+        while (count > 0)
+        {
+            size_type n = (count<BATCH ? count : BATCH), expected = 0;
+            for (size_type i = 0;i<n;i++)
+            {
+                vecs[i].iov_base = const_cast<void*>(buffers[i].base);
+                vecs[i].iov_len = buffers[i].length;
+                expected += buffers[i].length;
+            }
+            ssize_t bytesWrote = ::writev(_output->interpret_as<int>(),vecs,int(n));
+            if (bytesWrote <= -1)
+            {
+                _lastOp = bad_write;
+                break;
+            }
+            if (bytesWrote > 0)
+                _lastOp = success_write;
+            total += size_type(bytesWrote);
+            if (size_type(bytesWrote) < expected)
+                break;
+            buffers += n;
+            count -= n;
+        }
+        _byteCount = total;
+    }
+    else
+    {
+        _lastOp = no_device;
+        _byteCount = 0;
+    }
+}
 
 // rtypes::io_stream
 bool io_stream::_inDevice() const
@@ -134,6 +134,36 @@ void io_device::_writeBuffer(const io_resource* context,const void* buffer,uint3
         _byteCount = 0;
     }
 }
+void io_device::_writeVector(const io_vector* buffers,size_type count)
+{
+    if (_output != NULL)
+    {
+        // Windows has no gather write for ordinary handles:
+        // write the buffers in turn until one is cut short
+        size_type total = 0;
+        _lastOp = no_output;
+        for (size_type i = 0;i<count;i++)
+        {
+            DWORD bytesWrote;
+            if ( !::WriteFile(_output->interpret_as<HANDLE>(),buffers[i].base,DWORD(buffers[i].length),&bytesWrote,NULL) )
+            {
+                _lastOp = bad_write;
+                break;
+            }
+            if (bytesWrote > 0)
+                _lastOp = success_write;
+            total += bytesWrote;
+            if (bytesWrote < buffers[i].length)
+                break;
+        }
+        _byteCount = total;
+    }
+    else
+    {
+        _lastOp = no_device;
+        _byteCount = 0;
+    }
+}
 
 // rtypes::io_stream
 bool io_stream::_inDevice() const
@@ -9,8 +9,8 @@ LOCINCDIR = /usr/local/include/rlibrary
 LOCLIBDIR = /usr/local/lib
 
 # compiler options
-BUILD = g++ -Wall -Werror -Wextra -Wshadow -Wfatal-errors -Wno-unused-variable -pedantic-errors --std=gnu++0x
-BUILD_OBJ = g++ -c -Wall -Werror -Wextra -Wshadow -Wfatal-errors -Wno-unused-variable -pedantic-errors --std=gnu++0x
+BUILD = g++ -Wall -Werror -Wextra -Wshadow -Wfatal-errors -Wno-unused-variable -pedantic-errors --std=gnu++0x -pthread
+BUILD_OBJ = g++ -c -Wall -Werror -Wextra -Wshadow -Wfatal-errors -Wno-unused-variable -pedantic-errors --std=gnu++0x -pthread
 BUILD_LIB = ar cr
 OBJ_OUT = -o $(OBJDIR)/
 
@@ -19,20 +19,29 @@ OBJ_OUT = -o $(OBJDIR)/
 RTYPESTYPES_H = rtypestypes.h
 RNODE_H = rnode.h
 RFILEMODE_H = rfilemode.h
+RARENA_H = rarena.h $(RTYPESTYPES_H)
+RPOOL_H = rpool.h $(RTYPESTYPES_H)
+RMEMORY_H = rmemory.h $(RTYPESTYPES_H)
 #  (header files with dependencies)
-RALLOCATOR_H = rallocator.h $(RTYPESTYPES_H)
-RSTRING_H = rstring.h rstring.tcc $(RTYPESTYPES_H)
+RALLOCATOR_H = rallocator.h $(RTYPESTYPES_H) $(RMEMORY_H)
+RSTRING_H = rstring.h rstring.tcc $(RTYPESTYPES_H) $(RALLOCATOR_H)
 RERROR_H = rerror.h $(RSTRING_H)
 RLASTERR_H = rlasterr.h $(RERROR_H)
-RQUEUE_H = rqueue.h $(RERROR_H) $(RALLOCATOR_H)
+RQUEUE_H = rqueue.h $(RERROR_H) $(RALLOCATOR_H) $(RDYNARRAY_H)
 RSTACK_H = rstack.h $(RERROR_H) $(RALLOCATOR_H)
 RDYNARRAY_H = rdynarray.h rdynarray.tcc $(RALLOCATOR_H) $(RERROR_H)
-RLIST_H = rlist.h rlist.tcc $(RERROR_H) $(RTYPESTYPES_H) $(RNODE_H)
-RSET_H = rset.h $(RLIST_H)
+RLIST_H = rlist.h rlist.tcc $(RERROR_H) $(RTYPESTYPES_H) $(RALLOCATOR_H) $(RNODE_H)
+RHASH_H = rhash.h $(RTYPESTYPES_H) $(RSTRING_H)
+RSET_H = rset.h rset.tcc $(RLIST_H) $(RALLOCATOR_H) $(RHASH_H)
+RTREE_H = rtree.h rtree.tcc $(RERROR_H) $(RTYPESTYPES_H) $(RALLOCATOR_H)
+RMAP_H = rmap.h rmap.tcc $(RERROR_H) $(RTYPESTYPES_H) $(RALLOCATOR_H) $(RHASH_H)
+RCONQUEUE_H = rconqueue.h rconqueue.tcc $(RALLOCATOR_H) $(RQUEUE_H)
+RTHREAD_H = rthread.h $(RTYPESTYPES_H) $(RCONQUEUE_H)
+RSTRINGBUILDER_H = rstringbuilder.h $(RSTRING_H)
 RSTREAM_H = rstream.h $(RSTRING_H) $(RQUEUE_H) $(RSET_H)
 RSTREAMMANIP_H = rstreammanip.h $(RSTREAM_H)
 RSTRINGSTREAM_H = rstringstream.h $(RSTREAM_H)
-RUTILITY_H = rutility.h $(RTYPESTYPES_H)
+RUTILITY_H = rutility.h $(RTYPESTYPES_H) $(RSTRING_H) $(RMEMORY_H)
 RINTEGRATION_H = rintegration.h $(RSTRING_H)
 RFILENAME_H = rfilename.h $(RSTRING_H) $(RDYNARRAY_H) $(RFILEMODE_H)
 RRESOURCE_H = rresource.h rresource.tcc $(RTYPESTYPES_H) $(RERROR_H)
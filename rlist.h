@@ -3,6 +3,7 @@
 #define RLIST_H
 #include "rerror.h"
 #include "rtypestypes.h"
+#include "rallocator.h"
 #include "rnode.h"
 
 namespace rtypes
@@ -122,8 +123,16 @@ namespace rtypes
         const _list_const_iterator<T>& right)
     { return left._node()!=right._node(); }
 
+    // default ordering for list operations that compare elements
     template<typename T>
-    class list
+    struct _list_less
+    {
+        bool operator ()(const T& left,const T& right) const
+        { return left < right; }
+    };
+
+    template<typename T,class Alloc = default_allocator>
+    class list : private Alloc
     {
         typedef _rnode_double<T> _Node;
         typedef _rnode_double_link<_Node> _Dummy; // yes, I'll shoot myself in the foot here
@@ -138,13 +147,30 @@ namespace rtypes
             _root >> _root;
             _sz = 0;
         }
+        explicit list(const Alloc& allocator)
+            : Alloc(allocator)
+        {
+            _root << _root;
+            _root >> _root;
+            _sz = 0;
+        }
         list(const _Self& obj)
+            : Alloc(obj)
         {
             _root << _root;
             _root >> _root;
             _sz = 0;
             _copy(obj);
         }
+        list(_Self&& obj)
+            : Alloc(obj)
+        {
+            // take the nodes of 'obj' (which is left empty)
+            _root << _root;
+            _root >> _root;
+            _sz = 0;
+            swap(obj);
+        }
         ~list()
         { _deleteElements(); }
 
@@ -154,6 +180,15 @@ namespace rtypes
                 _copy(obj);
             return *this;
         }
+        _Self& operator =(_Self&& obj)
+        {
+            if (this != &obj)
+            {
+                _deleteElements();
+                swap(obj);
+            }
+            return *this;
+        }
 
         /* ++ prefix
          *  grow front by one default element
@@ -176,10 +211,39 @@ namespace rtypes
         }
 
         /* swap( list& obj )
-         *  exchange contents of lists
+         *  exchange contents (and allocators) of lists in
+         *  constant time; no elements are copied
          */
         void swap(_Self& obj);
 
+        /* splice( position, obj )
+         *  moves all of the elements of 'obj' before 'position'
+         * splice( position, obj, element )
+         *  moves the element at 'element' in 'obj' before 'position'
+         * splice( position, obj, first, last )
+         *  moves the elements of 'obj' in [first, last) before 'position'
+         *
+         *  'obj' may be this list, but then 'position' must not lie in the
+         * moved range; nodes are relinked, not copied, so the lists' allocators
+         * must be able to free each other's nodes; iterators to moved elements
+         * remain valid and refer into this list; all forms run in constant time
+         * except a range moved from another list, which is linear in its length
+         */
+        void splice(iterator position,_Self& obj);
+        void splice(iterator position,_Self& obj,iterator element);
+        void splice(iterator position,_Self& obj,iterator first,iterator last);
+
+        /* merge( obj ), merge( obj, compare )
+         *  moves the elements of 'obj' into this list; both lists must be
+         *  sorted (by operator< or 'compare') and the result is sorted; the
+         *  merge is stable, placing elements of this list before equivalent
+         *  elements of 'obj'; it is linear and relinks nodes like splice
+         */
+        void merge(_Self& obj)
+        { merge(obj,_list_less<T>()); }
+        template<class Compare>
+        void merge(_Self& obj,Compare compare);
+
         /* grow_front( cnt )
          *  add n number of default elements to the front
          *  of the list
@@ -195,12 +259,29 @@ namespace rtypes
         /* push_front( value )
          *  insert element at beginning of list
          */
-        void push_front(const T& value);
+        void push_front(const T& value)
+        { emplace(begin(),value); }
+        void push_front(T&& value)
+        { emplace( begin(),std::move(value) ); }
 
         /* push_back( value )
          *  insert element at end of list
          */
-        void push_back(const T& value);
+        void push_back(const T& value)
+        { emplace(end(),value); }
+        void push_back(T&& value)
+        { emplace( end(),std::move(value) ); }
+
+        /* emplace_front( args ), emplace_back( args )
+         *  constructs a new first (or last) element in
+         *  place from 'args' and returns a reference to it
+         */
+        template<class... Args>
+        T& emplace_front(Args&&... args)
+        { return emplace( begin(),std::forward<Args>(args)... ); }
+        template<class... Args>
+        T& emplace_back(Args&&... args)
+        { return emplace( end(),std::forward<Args>(args)... ); }
 
         /* remove( value )
          *  remove all elements of value
@@ -218,10 +299,16 @@ namespace rtypes
         void clear()
         { _deleteElements(); }
 
-        /* sort( )
-         *  sorts the elements from least to greatest
+        /* sort( ), sort( compare )
+         *  sorts the elements from least to greatest (by operator<
+         *  or 'compare'); the sort is a stable merge sort that relinks
+         *  the nodes without recursion in O(n log n) time; input that
+         *  is already sorted (or reverse sorted) takes a linear pass
          */
-        void sort();
+        void sort()
+        { sort(_list_less<T>()); }
+        template<class Compare>
+        void sort(Compare compare);
 
         /* find( value )
          *  returns an iterator to the first occurance of
@@ -243,9 +330,19 @@ namespace rtypes
          *  inserts a copy of value a specified number of
          *  times at the specified location
          */
-        void insert(iterator position,const T& value);
+        void insert(iterator position,const T& value)
+        { emplace(position,value); }
+        void insert(iterator position,T&& value)
+        { emplace( position,std::move(value) ); }
         void insert(iterator position,size_type times,const T& value);
 
+        /* emplace( position,args )
+         *  constructs a new element in place from 'args' before
+         *  the specified location and returns a reference to it
+         */
+        template<class... Args>
+        T& emplace(iterator position,Args&&... args);
+
         T& insert_emplace(iterator position);
 
         /* front( )
@@ -301,20 +398,202 @@ namespace rtypes
         { return iterator(static_cast<_Node*>(&_root)); }
         const_iterator end() const
         { return const_iterator(static_cast<const _Node*>(&_root)); }
+
+        /* get_allocator( )
+         *  gets a copy of the allocator used for list nodes
+         */
+        Alloc get_allocator() const
+        { return *this; }
     private:
         _Dummy _root;
         size_type _sz;
 
+        _Node* _newNode();
+        template<class... Args>
+        _Node* _newNode(Args&&... args);
+        void _deleteNode(_Node*);
         void _deleteElements();
         void _copy(const _Self&);
-        static void _qsortRec(_Node**,size_type);
+        static void _transfer(_Node* position,_Node* first,_Node* last);
+        template<class Compare>
+        static _Node* _mergeRuns(_Node* left,_Node* right,Compare& compare);
     };
 
-    // operator overloads for list<T>
     template<typename T>
-    bool operator ==(const list<T>&,const list<T>&);
+    class _intrusive_list_iterator
+    {
+        typedef _intrusive_list_iterator _Self;
+        template<typename> friend class _intrusive_list_iterator;
+    public:
+        _intrusive_list_iterator()
+            : _n(NULL) {}
+        explicit _intrusive_list_iterator(T* n)
+            : _n(n) {}
+        template<typename U> // (allows iterator to const_iterator conversion)
+        _intrusive_list_iterator(const _intrusive_list_iterator<U>& iter)
+            : _n(iter._n) {}
+
+        _Self& operator ++()
+        {
+            _n = _n->next;
+            return *this;
+        }
+        _Self operator ++(int)
+        {
+            _Self tmp = *this;
+            _n = _n->next;
+            return tmp;
+        }
+
+        _Self& operator --()
+        {
+            _n = _n->prev;
+            return *this;
+        }
+        _Self operator --(int)
+        {
+            _Self tmp = *this;
+            _n = _n->prev;
+            return tmp;
+        }
+
+        T& operator *() const
+        { return *_n; }
+        T* operator ->() const
+        { return _n; }
+
+        bool operator ==(const _Self& obj) const
+        { return _n==obj._n; }
+        bool operator !=(const _Self& obj) const
+        { return _n!=obj._n; }
+
+        T* _node() const
+        { return _n; }
+    private:
+        T* _n;
+    };
+
+    /* intrusive_list
+     *  a doubly-linked list of objects that embed their own links: T must
+     * derive (publicly) from intrusive_list<T>::hook, which is
+     * _rnode_double_link<T>; the list never allocates, copies or destroys
+     * elements, so inserting and unlinking (from anywhere, given only the
+     * element) take constant time and cannot fail; an element may be in at
+     * most one list at a time and must be unlinked before it is destroyed;
+     * clearing or destroying the list unlinks its elements
+     */
     template<typename T>
-    bool operator !=(const list<T>&,const list<T>&);
+    class intrusive_list
+    {
+    public:
+        typedef _rnode_double_link<T> hook;
+        typedef _intrusive_list_iterator<T> iterator;
+        typedef _intrusive_list_iterator<const T> const_iterator;
+
+        intrusive_list()
+        {
+            _root << _root;
+            _root >> _root;
+            _sz = 0;
+        }
+        ~intrusive_list()
+        { clear(); }
+
+        /* push_front( elem ), push_back( elem )
+         *  links an element at the beginning (or end) of the list;
+         *  throws invalid_operation_error if it is already linked
+         */
+        void push_front(T& elem)
+        { _link(_root.next,elem); }
+        void push_back(T& elem)
+        { _link(_rootNode(),elem); }
+
+        /* insert( position, elem )
+         *  links an element before 'position'; throws
+         *  invalid_operation_error if it is already linked
+         */
+        void insert(iterator position,T& elem)
+        { _link(position._node(),elem); }
+
+        /* remove( elem )
+         *  unlinks an element that is linked in this list
+         * remove_at( iterator )
+         *  unlinks the element pointed to by iterator
+         */
+        void remove(T& elem);
+        void remove_at(iterator iter)
+        {
+            if (iter._node() == _rootNode())
+                throw bad_iterator_error();
+            remove(*iter);
+        }
+
+        /* pop_front( ), pop_back( )
+         *  unlinks the first (or last) element and returns it;
+         *  throws empty_container_error if the list is empty
+         */
+        T& pop_front();
+        T& pop_back();
+
+        /* clear( )
+         *  unlinks all elements; linear in the size of the list
+         */
+        void clear();
+
+        /* is_linked( elem )
+         *  determines if an element is linked in any list
+         */
+        static bool is_linked(const T& elem)
+        { return static_cast<const hook&>(elem).next != NULL; }
+
+        /* iterator_to( elem )
+         *  gets an iterator to an element linked in this list
+         */
+        iterator iterator_to(T& elem)
+        { return iterator(&elem); }
+        const_iterator iterator_to(const T& elem) const
+        { return const_iterator(&elem); }
+
+        T& front()
+        { return *_root.next; }
+        const T& front() const
+        { return *_root.next; }
+        T& back()
+        { return *_root.prev; }
+        const T& back() const
+        { return *_root.prev; }
+
+        bool is_empty() const
+        { return _sz == 0; }
+        size_type size() const
+        { return _sz; }
+
+        iterator begin()
+        { return iterator(_root.next); }
+        const_iterator begin() const
+        { return const_iterator(_root.next); }
+        iterator end()
+        { return iterator(_rootNode()); }
+        const_iterator end() const
+        { return const_iterator(const_cast<intrusive_list*>(this)->_rootNode()); }
+    private:
+        hook _root; // the root is addressed as a T but never dereferenced as one
+        size_type _sz;
+
+        T* _rootNode()
+        { return static_cast<T*>(&_root); }
+        void _link(T* position,T& elem);
+
+        // disallow copying
+        intrusive_list(const intrusive_list&);
+        intrusive_list& operator =(const intrusive_list&);
+    };
+
+    // operator overloads for list<T>
+    template<typename T,class Alloc>
+    bool operator ==(const list<T,Alloc>&,const list<T,Alloc>&);
+    template<typename T,class Alloc>
+    bool operator !=(const list<T,Alloc>&,const list<T,Alloc>&);
 }
 
 #include "rlist.tcc"
@@ -1,44 +1,121 @@
 // rlist.tcc - rlist out-of-line implementation
 
-template<typename T>
-void rtypes::list<T>::swap(_Self& obj)
-{
-    T tmp; // in case T has a lengthy constructor, I place it here so it runs once
-    iterator thisIter = begin(),
-        thatIter = obj.begin(),
-        thisEnd = end(),
-        thatEnd = obj.end();
-    while (thisIter!=thisEnd || thatIter!=thatEnd)
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::swap(_Self& obj)
+{
+    if (this != &obj)
     {
-        if (thisIter != thisEnd)
+        // the roots stay put: each chain is
+        // relinked to the other list's root
+        bool empty = is_empty(), objEmpty = obj.is_empty();
+        _Node *first = _root.next, *last = _root.prev;
+        _Node *objFirst = obj._root.next, *objLast = obj._root.prev;
+        _root << _root;
+        _root >> _root;
+        obj._root << obj._root;
+        obj._root >> obj._root;
+        if (!objEmpty)
         {
-            tmp = *thisIter;
-            if (thatIter != thatEnd)
-            {
-                *thisIter++ = *thatIter;
-                *thatIter++ = tmp;
-            }
-            else
-            {
-                obj.push_back(tmp);
-                this->remove_at(thisIter++);
-            }
+            _root >> *objFirst;
+            *objFirst << _root;
+            _root << *objLast;
+            *objLast >> _root;
         }
-        else if (thatIter != thatEnd)
+        if (!empty)
         {
-            tmp = *thatIter;
-            obj.remove_at(thatIter++);
-            this->push_back(tmp);
+            obj._root >> *first;
+            *first << obj._root;
+            obj._root << *last;
+            *last >> obj._root;
         }
+        size_type sz = _sz;
+        _sz = obj._sz;
+        obj._sz = sz;
+        // the nodes must be freed by the allocator that made them
+        Alloc alloc = *this;
+        static_cast<Alloc&>(*this) = obj;
+        static_cast<Alloc&>(obj) = alloc;
     }
 }
 
-template<typename T>
-void rtypes::list<T>::grow_front(size_type cnt)
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::splice(iterator position,_Self& obj)
+{
+    if (this!=&obj && !obj.is_empty())
+    {
+        _transfer(position._node(),obj._root.next,obj._root.prev);
+        _sz += obj._sz;
+        obj._sz = 0;
+    }
+}
+
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::splice(iterator position,_Self& obj,iterator element)
+{
+    _Node *n = element._node(), *pos = position._node();
+    if (n == obj.end()._node())
+        throw bad_iterator_error();
+    // the element may already be in place
+    if (pos!=n && pos!=n->next)
+    {
+        _transfer(pos,n,n);
+        ++_sz;
+        --obj._sz;
+    }
+}
+
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::splice(iterator position,_Self& obj,iterator first,iterator last)
+{
+    if (first != last)
+    {
+        _Node *f = first._node(), *l = last._node()->prev;
+        if (this != &obj)
+        {
+            size_type cnt = 1;
+            for (_Node* n = f;n!=l;n = n->next)
+                ++cnt;
+            _sz += cnt;
+            obj._sz -= cnt;
+        }
+        _transfer(position._node(),f,l);
+    }
+}
+
+template<typename T,class Alloc>
+template<class Compare>
+void rtypes::list<T,Alloc>::merge(_Self& obj,Compare compare)
+{
+    if (this == &obj)
+        return;
+    _Node *a = _root.next, *root = end()._node();
+    _Node *b = obj._root.next, *objRoot = obj.end()._node();
+    while (a!=root && b!=objRoot)
+    {
+        if ( compare(b->item,a->item) )
+        {
+            // move the whole run of 'obj' that precedes 'a' at once
+            _Node* run = b->next;
+            while (run!=objRoot && compare(run->item,a->item))
+                run = run->next;
+            _transfer(a,b,run->prev);
+            b = run;
+        }
+        else
+            a = a->next;
+    }
+    if (b != objRoot)
+        _transfer(root,b,obj._root.prev);
+    _sz += obj._sz;
+    obj._sz = 0;
+}
+
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::grow_front(size_type cnt)
 {
     for (size_type i = 0;i<cnt;i++)
     {
-        _Node *n = new _Node;
+        _Node *n = _newNode();
         *n >> *_root.next;
         *n << _root;
         *_root.next << *n;
@@ -47,12 +124,12 @@ void rtypes::list<T>::grow_front(size_type cnt)
     }
 }
 
-template<typename T>
-void rtypes::list<T>::grow_back(size_type cnt)
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::grow_back(size_type cnt)
 {
     for (size_type i = 0;i<cnt;i++)
     {
-        _Node *n = new _Node;
+        _Node *n = _newNode();
         *n >> _root;
         *n << *_root.prev;
         *_root.prev >> *n;
@@ -61,30 +138,8 @@ void rtypes::list<T>::grow_back(size_type cnt)
     }
 }
 
-template<typename T>
-void rtypes::list<T>::push_front(const T& value)
-{
-    _Node *n = new _Node(value);
-    *n >> *_root.next;
-    *n << _root;
-    *_root.next << *n;
-    _root >> *n;
-    ++_sz;
-}
-
-template<typename T>
-void rtypes::list<T>::push_back(const T& value)
-{
-    _Node *n = new _Node(value);
-    *n >> _root;
-    *n << *_root.prev;
-    *_root.prev >> *n;
-    _root << *n;
-    ++_sz;
-}
-
-template<typename T>
-void rtypes::list<T>::remove(const T& value)
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::remove(const T& value)
 {
     iterator iter = begin(), theEnd = end();
     while (iter != theEnd)
@@ -96,38 +151,86 @@ void rtypes::list<T>::remove(const T& value)
     }
 }
 
-template<typename T>
-void rtypes::list<T>::remove_at(iterator iter)
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::remove_at(iterator iter)
 {
     _Node* n = iter._node();
     if (n == &_root)
         throw bad_iterator_error();
     *n->prev >> *n->next;
     *n->next << *n->prev;
-    delete n;
+    _deleteNode(n);
     --_sz;
 }
 
-template<typename T>
-void rtypes::list<T>::sort()
+template<typename T,class Alloc>
+template<class Compare>
+void rtypes::list<T,Alloc>::sort(Compare compare)
 {
-    _Node *beg = _root.next, *walker;
-    // this recursive function expectes a non-circular
-    // doubly-linked list; therefore the links must be broken
+    if (_sz < 2)
+        return;
+    // the runs are singly-linked, NULL-terminated chains; bins[i] holds a
+    // merge of about 2^i runs (or nothing), like the digits of a binary
+    // counter, so no run is merged more than log2(n)+1 times; the runs in
+    // higher bins came earlier in the list, which keeps the sort stable
+    _Node* bins[64];
+    size_type fill = 0;
+    _Node* n = _root.next;
     _root.prev->next = NULL;
-    beg->prev = NULL;
-    _qsortRec(&beg,_sz);
-    _root >> *beg;
-    *beg << _root;
-    walker = beg;
-    while (walker->next != NULL)
-        walker = walker->next;
-    *walker >> _root;
-    _root << *walker;
+    while (n != NULL)
+    {
+        // take the next non-descending run as it stands or the next
+        // strictly descending run reversed (which cannot reorder
+        // equivalent elements)
+        _Node *run = n, *last = n;
+        if (last->next!=NULL && compare(last->next->item,last->item))
+        {
+            n = n->next;
+            run->next = NULL;
+            while (n!=NULL && compare(n->item,run->item))
+            {
+                _Node* nxt = n->next;
+                n->next = run;
+                run = n;
+                n = nxt;
+            }
+        }
+        else
+        {
+            while (last->next!=NULL && !compare(last->next->item,last->item))
+                last = last->next;
+            n = last->next;
+            last->next = NULL;
+        }
+        size_type i = 0;
+        for (;i<fill && bins[i]!=NULL;i++)
+        {
+            run = _mergeRuns(bins[i],run,compare);
+            bins[i] = NULL;
+        }
+        if (i == fill)
+            ++fill;
+        bins[i] = run;
+    }
+    n = NULL;
+    for (size_type i = 0;i<fill;i++)
+        if (bins[i] != NULL)
+            n = (n==NULL ? bins[i] : _mergeRuns(bins[i],n,compare));
+    // restore the back links and the circle through the root
+    _Node* prev = end()._node();
+    _root >> *n;
+    while (n != NULL)
+    {
+        *n << *prev;
+        prev = n;
+        n = n->next;
+    }
+    *prev >> _root;
+    _root << *prev;
 }
 
-template<typename T>
-typename rtypes::list<T>::iterator rtypes::list<T>::find(const T& value)
+template<typename T,class Alloc>
+typename rtypes::list<T,Alloc>::iterator rtypes::list<T,Alloc>::find(const T& value)
 {
     iterator e = end();
     for (iterator i = begin();i!=e;i++)
@@ -136,8 +239,8 @@ typename rtypes::list<T>::iterator rtypes::list<T>::find(const T& value)
     return e;
 }
 
-template<typename T>
-typename rtypes::list<T>::iterator rtypes::list<T>::find(const T& value,iterator start)
+template<typename T,class Alloc>
+typename rtypes::list<T,Alloc>::iterator rtypes::list<T,Alloc>::find(const T& value,iterator start)
 {
     iterator e = end();
     for (;start!=e;start++)
@@ -146,8 +249,8 @@ typename rtypes::list<T>::iterator rtypes::list<T>::find(const T& value,iterator
     return e;
 }
 
-template<typename T>
-typename rtypes::list<T>::const_iterator rtypes::list<T>::find(const T& value) const
+template<typename T,class Alloc>
+typename rtypes::list<T,Alloc>::const_iterator rtypes::list<T,Alloc>::find(const T& value) const
 {
     const_iterator e = end();
     for (const_iterator i = begin();i!=e;i++)
@@ -156,8 +259,8 @@ typename rtypes::list<T>::const_iterator rtypes::list<T>::find(const T& value) c
     return e;
 }
 
-template<typename T>
-typename rtypes::list<T>::const_iterator rtypes::list<T>::find(const T& value,const_iterator start) const
+template<typename T,class Alloc>
+typename rtypes::list<T,Alloc>::const_iterator rtypes::list<T,Alloc>::find(const T& value,const_iterator start) const
 {
     const_iterator e = end();
     for (;start!=e;start++)
@@ -166,29 +269,31 @@ typename rtypes::list<T>::const_iterator rtypes::list<T>::find(const T& value,co
     return e;
 }
 
-template<typename T>
-void rtypes::list<T>::insert(iterator position,const T& value)
+template<typename T,class Alloc>
+template<class... Args>
+T& rtypes::list<T,Alloc>::emplace(iterator position,Args&&... args)
 {
-    _Node *nw = new _Node(value);
+    _Node *nw = _newNode( std::forward<Args>(args)... );
     _Node *n = position._node();
     *n->prev >> *nw;
     *nw << *n->prev;
     *nw >> *n;
     *n << *nw;
     ++_sz;
+    return nw->item;
 }
 
-template<typename T>
-void rtypes::list<T>::insert(iterator position,size_type times,const T& value)
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::insert(iterator position,size_type times,const T& value)
 {
     for (size_type i = 0;i<times;i++)
         insert(position++,value);
 }
 
-template<typename T>
-T& rtypes::list<T>::insert_emplace(iterator position)
+template<typename T,class Alloc>
+T& rtypes::list<T,Alloc>::insert_emplace(iterator position)
 {
-    _Node* nw = new _Node;
+    _Node* nw = _newNode();
     _Node* n = position._node();
     *n->prev >> *nw;
     *nw << *n->prev;
@@ -198,24 +303,48 @@ T& rtypes::list<T>::insert_emplace(iterator position)
     return nw->item;
 }
 
-template<typename T>
-T rtypes::list<T>::pop_front()
+template<typename T,class Alloc>
+T rtypes::list<T,Alloc>::pop_front()
 {
-    T tmp = front();
+    // move the element out before it is destroyed
+    T tmp( std::move(front()) );
     remove_at( begin() );
     return tmp;
 }
 
-template<typename T>
-T rtypes::list<T>::pop_back()
+template<typename T,class Alloc>
+T rtypes::list<T,Alloc>::pop_back()
 {
-    T tmp = back();
+    T tmp( std::move(back()) );
     remove_at( --end() );
     return tmp;
 }
 
-template<typename T>
-void rtypes::list<T>::_deleteElements()
+template<typename T,class Alloc>
+typename rtypes::list<T,Alloc>::_Node* rtypes::list<T,Alloc>::_newNode()
+{
+    // nodes are placement-constructed in memory from the allocator
+    void* p = Alloc::allocate(sizeof(_Node));
+    return new (p) _Node;
+}
+
+template<typename T,class Alloc>
+template<class... Args>
+typename rtypes::list<T,Alloc>::_Node* rtypes::list<T,Alloc>::_newNode(Args&&... args)
+{
+    void* p = Alloc::allocate(sizeof(_Node));
+    return new (p) _Node( _rnode_emplace(),std::forward<Args>(args)... );
+}
+
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::_deleteNode(_Node* n)
+{
+    n->~_Node();
+    Alloc::deallocate(n,sizeof(_Node));
+}
+
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::_deleteElements()
 {
     if ( !is_empty() )
     {
@@ -223,7 +352,7 @@ void rtypes::list<T>::_deleteElements()
         while (n != &_root)
         {
             _Node* nxt = n->next;
-            delete n;
+            _deleteNode(n);
             n = nxt;
         }
         _root << _root;
@@ -232,8 +361,8 @@ void rtypes::list<T>::_deleteElements()
     }
 }
 
-template<typename T>
-void rtypes::list<T>::_copy(const _Self& obj)
+template<typename T,class Alloc>
+void rtypes::list<T,Alloc>::_copy(const _Self& obj)
 {
     iterator ownBeg = begin();
     const iterator ownEnd = end();
@@ -250,122 +379,124 @@ void rtypes::list<T>::_copy(const _Self& obj)
     }
 }
 
-template<typename T>
-/* static */void rtypes::list<T>::_qsortRec(_Node** ppHead,size_type sz)
+template<typename T,class Alloc>
+/* static */ void rtypes::list<T,Alloc>::_transfer(_Node* position,_Node* first,_Node* last)
 {
-    if (sz > 1)
+    // unlink the chain [first, last] and link it before 'position'
+    _Node *before = first->prev, *after = last->next;
+    *before >> *after;
+    *after << *before;
+    before = position->prev;
+    *before >> *first;
+    *first << *before;
+    *last >> *position;
+    *position << *last;
+}
+
+template<typename T,class Alloc>
+template<class Compare>
+/* static */ typename rtypes::list<T,Alloc>::_Node* rtypes::list<T,Alloc>::_mergeRuns(_Node* left,_Node* right,Compare& compare)
+{
+    // merge two NULL-terminated chains; on ties the
+    // element from 'left' (the earlier run) goes first
+    _Node* result;
+    _Node** tail = &result;
+    while (left!=NULL && right!=NULL)
     {
-        _Node   *cpy,
-            *piv = *ppHead,
-            *eq = NULL,
-            *less = NULL,
-            *grtr = NULL,
-            *eqPos = NULL,
-            *lessPos = NULL,
-            *grtrPos = NULL;
-        size_type   lessSz = 0,
-            grtrSz = 0;
-        for (size_type i = 0;i<sz/2;i++)
-            piv = piv->next;
-        if (piv->next != NULL)
-            piv->next->prev = piv->prev;
-        if (piv->prev != NULL)
+        if ( compare(right->item,left->item) )
         {
-            piv->prev->next = piv->next;
-            piv->prev = NULL;
+            *tail = right;
+            tail = &right->next;
+            right = right->next;
         }
-        piv->next = NULL;
-        cpy = *ppHead;
-        eq = piv;
-        eqPos = piv;
-        while (cpy != NULL)
-        {
-            _Node *nxt = cpy->next;
-            if (cpy->item < piv->item)
-            {
-                if (lessPos==NULL)
-                {
-                    less = cpy;
-                    lessPos = cpy;
-                    cpy->prev = NULL;
-                    cpy->next = NULL;
-                }
-                else
-                {
-                    lessPos->next = cpy;
-                    cpy->prev = lessPos;
-                    cpy->next = NULL;
-                    lessPos = cpy;
-                }
-                ++lessSz;
-            }
-            else if (cpy->item > piv->item)
-            {
-                if (grtrPos==NULL)
-                {
-                    grtr = cpy;
-                    grtrPos = cpy;
-                    cpy->prev = NULL;
-                    cpy->next = NULL;
-                }
-                else
-                {
-                    grtrPos->next = cpy;
-                    cpy->prev = grtrPos;
-                    cpy->next = NULL;
-                    grtrPos = cpy;
-                }
-                ++grtrSz;
-            }
-            else
-            {
-                eqPos->next = cpy;
-                cpy->prev = eqPos;
-                cpy->next = NULL;
-                eqPos = cpy;
-            }
-            cpy = nxt;
-        }
-        _qsortRec(&less,lessSz);
-        _qsortRec(&grtr,grtrSz);
-        lessPos = less;
-        grtrPos = grtr;
-        if (lessPos != NULL)
-            while (lessPos->next)
-                lessPos = lessPos->next;
-        if (grtrPos != NULL)
-            while (grtrPos->next)
-                grtrPos = grtrPos->next;
-        if (less)
+        else
         {
-            *ppHead = less;
-            lessPos->next = eq;
+            *tail = left;
+            tail = &left->next;
+            left = left->next;
         }
-        else
-            *ppHead = eq;
-        eq->prev = lessPos;
-        eqPos->next = grtr;
-        if (grtr)
-            grtr->prev = eqPos;
     }
+    *tail = (left!=NULL ? left : right);
+    return result;
 }
 
-/* RList operator overloads */
+// rtypes::intrusive_list<>
+template<typename T>
+void rtypes::intrusive_list<T>::remove(T& elem)
+{
+    hook& h = elem;
+    if (h.next == NULL)
+        throw invalid_operation_error();
+    *h.prev >> *h.next;
+    *h.next << *h.prev;
+    h.reset();
+    --_sz;
+}
+
+template<typename T>
+T& rtypes::intrusive_list<T>::pop_front()
+{
+    if (_sz == 0)
+        throw empty_container_error();
+    T& elem = *_root.next;
+    remove(elem);
+    return elem;
+}
 
 template<typename T>
-bool rtypes::operator ==(const rtypes::list<T>& left,const rtypes::list<T>& right)
+T& rtypes::intrusive_list<T>::pop_back()
+{
+    if (_sz == 0)
+        throw empty_container_error();
+    T& elem = *_root.prev;
+    remove(elem);
+    return elem;
+}
+
+template<typename T>
+void rtypes::intrusive_list<T>::clear()
+{
+    T *n = _root.next, *root = _rootNode();
+    while (n != root)
+    {
+        T* nxt = n->next;
+        static_cast<hook*>(n)->reset();
+        n = nxt;
+    }
+    _root << _root;
+    _root >> _root;
+    _sz = 0;
+}
+
+template<typename T>
+void rtypes::intrusive_list<T>::_link(T* position,T& elem)
+{
+    hook& h = elem;
+    if (h.next != NULL)
+        throw invalid_operation_error();
+    *position->prev >> elem;
+    h << *position->prev;
+    h >> *position;
+    *position << elem;
+    ++_sz;
+}
+
+/* RList operator overloads */
+
+template<typename T,class Alloc>
+bool rtypes::operator ==(const rtypes::list<T,Alloc>& left,const rtypes::list<T,Alloc>& right)
 {
     if (left.size() == right.size())
     {
-        for (typename list<T>::const_iterator l = left.begin(), r = right.begin(), e = left.end();l!=e;l++,r++)
+        for (typename list<T,Alloc>::const_iterator l = left.begin(), r = right.begin(), e = left.end();l!=e;l++,r++)
             if (*l != *r)
                 return false;   
         return true;
     }
     return false;
 }
-template<typename T>
-bool rtypes::operator !=(const rtypes::list<T>& left,const rtypes::list<T>& right)
+template<typename T,class Alloc>
+bool rtypes::operator !=(const rtypes::list<T,Alloc>& left,const rtypes::list<T,Alloc>& right)
 {
     return !operator==(left,right);
 }
@@ -0,0 +1,407 @@
+// rmap.h - provides associative containers for rlibrary
+#ifndef RMAP_H
+#define RMAP_H
+#include "rerror.h"
+#include "rtypestypes.h"
+#include "rallocator.h"
+#include "rhash.h"
+#include <type_traits>
+
+// probe control bytes with SSE2 where the target guarantees it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RLIBRARY_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace rtypes
+{
+    /* _map_group
+     *  operations on a group of 16 control bytes; a control byte is EMPTY,
+     * DELETED or, for an occupied slot, the low 7 bits of the element's hash
+     * (so the high bit distinguishes free from occupied slots); each operation
+     * returns a bit mask with bit i set when control byte i matches
+     */
+    struct _map_group
+    {
+        static const size_type WIDTH = 16;
+        static const byte EMPTY = 0x80;
+        static const byte DELETED = 0xfe;
+
+#ifdef RLIBRARY_MAP_SSE2
+        static uint32 match(const byte* ctrl,byte h2)
+        {
+            __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+            return uint32( _mm_movemask_epi8(_mm_cmpeq_epi8(g,_mm_set1_epi8(char(h2)))) );
+        }
+        static uint32 match_empty(const byte* ctrl)
+        {
+            return match(ctrl,EMPTY);
+        }
+        static uint32 match_free(const byte* ctrl) // empty or deleted
+        {
+            __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+            return uint32( _mm_movemask_epi8(g) );
+        }
+#else
+        static uint32 match(const byte* ctrl,byte h2)
+        {
+            uint32 mask = 0;
+            for (size_type i = 0;i<WIDTH;i++)
+                if (ctrl[i] == h2)
+                    mask |= uint32(1) << i;
+            return mask;
+        }
+        static uint32 match_empty(const byte* ctrl)
+        {
+            return match(ctrl,EMPTY);
+        }
+        static uint32 match_free(const byte* ctrl)
+        {
+            uint32 mask = 0;
+            for (size_type i = 0;i<WIDTH;i++)
+                if (ctrl[i] & 0x80)
+                    mask |= uint32(1) << i;
+            return mask;
+        }
+#endif
+
+        // index of the lowest set bit; 'mask' must be non-zero
+        static size_type lowest_bit(uint32 mask)
+        {
+#if defined(__GNUC__)
+            return size_type( __builtin_ctz(mask) );
+#else
+            size_type i = 0;
+            while ((mask & 1) == 0)
+            {
+                mask >>= 1;
+                ++i;
+            }
+            return i;
+#endif
+        }
+    };
+
+    /* map
+     *  an unordered associative container implemented as a Swiss table: slots
+     * are organized into groups of 16 with one control byte per slot holding 7
+     * bits of the key's hash, so a probe tests a whole group with a few vector
+     * instructions and compares keys only on a control byte match; groups are
+     * probed triangularly and the table is kept at most 7/8 full; keys must be
+     * equality comparable and have a hashing trait (see rhash.h); maps with
+     * string keys may also be searched with a null-terminated character string
+     * without constructing a key; inserting may invalidate iterators
+     */
+    template<typename Key,typename Value,class Hash = hash<Key>,class Alloc = default_allocator>
+    class map : private Alloc
+    {
+        struct _Slot
+        {
+            _Slot(const Key& k,const Value& v)
+                : key(k), value(v) {}
+            explicit _Slot(const Key& k)
+                : key(k), value() {}
+
+            Key key;
+            Value value;
+        };
+
+        // enables the overloads for C-strings and string references when the key type is a string type
+        template<typename CharType,typename Result>
+        struct _CharQuery : std::enable_if<std::is_base_of<rtype_string<CharType>,Key>::value,Result> {};
+    public:
+        class const_iterator;
+
+        /* iterator
+         *  refers to an entry of the map; dereferencing yields
+         * the entry's key and value() yields its mapped value
+         */
+        class iterator
+        {
+            friend class map;
+            friend class const_iterator;
+        public:
+            iterator()
+                : _ctrl(NULL), _slot(NULL), _end(NULL) {}
+
+            const Key& key() const
+            { return _slot->key; }
+            Value& value() const
+            { return _slot->value; }
+
+            const Key& operator *() const
+            { return _slot->key; }
+            const Key* operator ->() const
+            { return &_slot->key; }
+
+            iterator& operator ++()
+            {
+                ++_ctrl;
+                ++_slot;
+                _skip();
+                return *this;
+            }
+            iterator operator ++(int)
+            {
+                iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            bool operator ==(const iterator& obj) const
+            { return _ctrl==obj._ctrl; }
+            bool operator !=(const iterator& obj) const
+            { return _ctrl!=obj._ctrl; }
+        private:
+            const byte* _ctrl;
+            _Slot* _slot;
+            const byte* _end;
+
+            iterator(const byte* ctrl,_Slot* slot,const byte* end)
+                : _ctrl(ctrl), _slot(slot), _end(end) {}
+
+            void _skip()
+            {
+                while (_ctrl!=_end && (*_ctrl & 0x80))
+                {
+                    ++_ctrl;
+                    ++_slot;
+                }
+            }
+        };
+
+        class const_iterator
+        {
+            friend class map;
+        public:
+            const_iterator()
+                : _ctrl(NULL), _slot(NULL), _end(NULL) {}
+            const_iterator(const iterator& iter)
+                : _ctrl(iter._ctrl), _slot(iter._slot), _end(iter._end) {}
+
+            const Key& key() const
+            { return _slot->key; }
+            const Value& value() const
+            { return _slot->value; }
+
+            const Key& operator *() const
+            { return _slot->key; }
+            const Key* operator ->() const
+            { return &_slot->key; }
+
+            const_iterator& operator ++()
+            {
+                ++_ctrl;
+                ++_slot;
+                _skip();
+                return *this;
+            }
+            const_iterator operator ++(int)
+            {
+                const_iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            bool operator ==(const const_iterator& obj) const
+            { return _ctrl==obj._ctrl; }
+            bool operator !=(const const_iterator& obj) const
+            { return _ctrl!=obj._ctrl; }
+        private:
+            const byte* _ctrl;
+            const _Slot* _slot;
+            const byte* _end;
+
+            const_iterator(const byte* ctrl,const _Slot* slot,const byte* end)
+                : _ctrl(ctrl), _slot(slot), _end(end) {}
+
+            void _skip()
+            {
+                while (_ctrl!=_end && (*_ctrl & 0x80))
+                {
+                    ++_ctrl;
+                    ++_slot;
+                }
+            }
+        };
+
+        map();
+        explicit map(const Alloc& allocator);
+        map(const map&);
+        ~map();
+
+        map& operator =(const map&);
+
+        iterator begin()
+        { return _iter(0,true); }
+        iterator end()
+        { return _iter(_cap,false); }
+        const_iterator begin() const
+        { return const_cast<map*>(this)->begin(); }
+        const_iterator end() const
+        { return const_cast<map*>(this)->end(); }
+
+        /* insert( key, value )
+         *  adds an entry if the key does not exist already;
+         *  returns false (leaving the existing entry alone)
+         *  if it does
+         */
+        bool insert(const Key& key,const Value& value);
+
+        /* remove( key ), remove_at( iterator )
+         *  removes the entry with the key if it exists; remove_at
+         *  removes the entry at a valid iterator position
+         */
+        void remove(const Key& key)
+        { _removeIndex(_findIndex(key,_mix(Hash()(key)))); }
+        template<typename CharType>
+        typename _CharQuery<CharType,void>::type remove(const CharType* key)
+        { _removeIndex(_findIndex(key,_mix(Hash()(key)))); }
+        template<typename CharType>
+        typename _CharQuery<CharType,void>::type remove(const basic_string_ref<CharType>& key)
+        { _removeIndex(_findIndex(key,_mix(Hash()(key)))); }
+        void remove_at(iterator iter)
+        { _removeIndex(size_type(iter._ctrl-_ctrl)); }
+
+        /* find( key )
+         *  returns an iterator to the entry with the
+         *  specified key or end() if it does not exist
+         */
+        iterator find(const Key& key)
+        { return _iter(_findIndex(key,_mix(Hash()(key))),false); }
+        const_iterator find(const Key& key) const
+        { return const_cast<map*>(this)->find(key); }
+        template<typename CharType>
+        typename _CharQuery<CharType,iterator>::type find(const CharType* key)
+        { return _iter(_findIndex(key,_mix(Hash()(key))),false); }
+        template<typename CharType>
+        typename _CharQuery<CharType,const_iterator>::type find(const CharType* key) const
+        { return const_cast<map*>(this)->find(key); }
+        template<typename CharType>
+        typename _CharQuery<CharType,iterator>::type find(const basic_string_ref<CharType>& key)
+        { return _iter(_findIndex(key,_mix(Hash()(key))),false); }
+        template<typename CharType>
+        typename _CharQuery<CharType,const_iterator>::type find(const basic_string_ref<CharType>& key) const
+        { return const_cast<map*>(this)->find(key); }
+
+        /* contains( key )
+         *  determines if an entry with the key exists
+         */
+        bool contains(const Key& key) const
+        { return _findIndex(key,_mix(Hash()(key))) < _cap; }
+        template<typename CharType>
+        typename _CharQuery<CharType,bool>::type contains(const CharType* key) const
+        { return _findIndex(key,_mix(Hash()(key))) < _cap; }
+        template<typename CharType>
+        typename _CharQuery<CharType,bool>::type contains(const basic_string_ref<CharType>& key) const
+        { return _findIndex(key,_mix(Hash()(key))) < _cap; }
+
+        /* get( key )
+         *  returns the value mapped to the key; throws
+         *  element_not_found_error if there is no such entry
+         */
+        Value& get(const Key& key)
+        { return _get(_findIndex(key,_mix(Hash()(key)))); }
+        const Value& get(const Key& key) const
+        { return const_cast<map*>(this)->get(key); }
+        template<typename CharType>
+        typename _CharQuery<CharType,Value&>::type get(const CharType* key)
+        { return _get(_findIndex(key,_mix(Hash()(key)))); }
+        template<typename CharType>
+        typename _CharQuery<CharType,const Value&>::type get(const CharType* key) const
+        { return const_cast<map*>(this)->get(key); }
+        template<typename CharType>
+        typename _CharQuery<CharType,Value&>::type get(const basic_string_ref<CharType>& key)
+        { return _get(_findIndex(key,_mix(Hash()(key)))); }
+        template<typename CharType>
+        typename _CharQuery<CharType,const Value&>::type get(const basic_string_ref<CharType>& key) const
+        { return const_cast<map*>(this)->get(key); }
+
+        /* reserve( count )
+         *  grows the table so that 'count' entries fit
+         *  without rehashing
+         */
+        void reserve(size_type cnt);
+
+        /* empty( )
+         *  removes all entries; the table capacity is kept
+         */
+        void empty();
+
+        /* is_empty( )
+         *  determines if there are any entries
+         */
+        bool is_empty() const
+        { return _sz==0; }
+
+        /* size( )
+         *  returns the number of entries
+         */
+        size_type size() const
+        { return _sz; }
+
+        /* capacity( )
+         *  returns the number of slots in the table
+         */
+        size_type capacity() const
+        { return _cap; }
+
+        // returns the value mapped to the key, inserting
+        // a default-constructed value if necessary
+        Value& operator [](const Key& key);
+
+        Alloc get_allocator() const
+        { return *this; }
+    private:
+        typedef _rallocator_raw<_Slot> _Raw;
+
+        byte* _ctrl; // one control byte per slot
+        _Slot* _slots; // raw storage; only occupied slots are constructed
+        size_type _cap; // zero or a power of two no less than _map_group::WIDTH
+        size_type _sz;
+        size_type _growthLeft; // free slots that may be used before the table grows
+
+        Alloc& _allocator()
+        { return *this; }
+
+        // scramble the hash trait's value; the low 7 bits become
+        // the control byte and the rest select the first group
+        static uint64 _mix(uint64 h)
+        {
+            h *= 11400714819323198485ull;
+            return h ^ (h >> 32);
+        }
+        static byte _h2(uint64 h)
+        { return byte(h & 0x7f); }
+
+        iterator _iter(size_type index,bool skip)
+        {
+            iterator iter(_ctrl+index,_slots+index,_ctrl+_cap);
+            if (skip)
+                iter._skip();
+            return iter;
+        }
+        Value& _get(size_type index)
+        {
+            if (index >= _cap)
+                throw element_not_found_error();
+            return _slots[index].value;
+        }
+
+        template<typename Query>
+        size_type _findIndex(const Query& key,uint64 h) const; // returns _cap if not found
+        bool _prepareInsert(const Key& key,size_type& index,byte& tag); // returns false if the key exists
+        void _commitInsert(size_type index,byte tag); // marks the slot used once its element is constructed
+        size_type _findFree(uint64 h) const;
+        void _removeIndex(size_type index);
+        void _rehash(size_type newCap);
+        void _allocTable(size_type newCap);
+        void _freeTable();
+        static size_type _slotOffset(size_type cap);
+    };
+}
+
+// include out-of-line implementation
+#include "rmap.tcc"
+
+#endif
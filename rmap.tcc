@@ -0,0 +1,271 @@
+// rmap.tcc - out-of-line implementation for rmap
+
+// rtypes::map<>
+template<typename Key,typename Value,class Hash,class Alloc>
+rtypes::map<Key,Value,Hash,Alloc>::map()
+{
+    _ctrl = NULL;
+    _slots = NULL;
+    _cap = 0;
+    _sz = 0;
+    _growthLeft = 0;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+rtypes::map<Key,Value,Hash,Alloc>::map(const Alloc& allocator)
+    : Alloc(allocator)
+{
+    _ctrl = NULL;
+    _slots = NULL;
+    _cap = 0;
+    _sz = 0;
+    _growthLeft = 0;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+rtypes::map<Key,Value,Hash,Alloc>::map(const map& obj)
+    : Alloc(obj)
+{
+    _ctrl = NULL;
+    _slots = NULL;
+    _cap = 0;
+    _sz = 0;
+    _growthLeft = 0;
+    *this = obj;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+rtypes::map<Key,Value,Hash,Alloc>::~map()
+{
+    empty();
+    _freeTable();
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+rtypes::map<Key,Value,Hash,Alloc>& rtypes::map<Key,Value,Hash,Alloc>::operator =(const map& obj)
+{
+    if (this != &obj)
+    {
+        empty();
+        if (_cap != obj._cap)
+        {
+            _freeTable();
+            if (obj._cap > 0)
+                _allocTable(obj._cap);
+        }
+        // copy the table layout as is; the hash functions agree
+        for (size_type i = 0;i<_cap;i++)
+        {
+            if ((obj._ctrl[i] & 0x80) == 0)
+                _Raw::construct(_slots+i,obj._slots[i]);
+            _ctrl[i] = obj._ctrl[i];
+        }
+        _sz = obj._sz;
+        _growthLeft = obj._growthLeft;
+    }
+    return *this;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+bool rtypes::map<Key,Value,Hash,Alloc>::insert(const Key& key,const Value& value)
+{
+    size_type index;
+    byte tag;
+    if (_growthLeft == 0)
+    {
+        // growing frees the old table, into which 'key' or 'value' may
+        // refer, so the element is made before the table can grow
+        _Slot slot(key,value);
+        if ( !_prepareInsert(slot.key,index,tag) )
+            return false;
+        new (_slots+index) _Slot( std::move(slot) );
+    }
+    else
+    {
+        if ( !_prepareInsert(key,index,tag) )
+            return false;
+        new (_slots+index) _Slot(key,value);
+    }
+    _commitInsert(index,tag);
+    return true;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+void rtypes::map<Key,Value,Hash,Alloc>::reserve(size_type cnt)
+{
+    size_type newCap = (_cap==0 ? _map_group::WIDTH : _cap);
+    while (cnt*8 > newCap*7)
+        newCap *= 2;
+    if (newCap > _cap)
+        _rehash(newCap);
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+void rtypes::map<Key,Value,Hash,Alloc>::empty()
+{
+    for (size_type i = 0;i<_cap;i++)
+    {
+        if ((_ctrl[i] & 0x80) == 0)
+            _Raw::destroy(_slots+i);
+        _ctrl[i] = _map_group::EMPTY;
+    }
+    _sz = 0;
+    _growthLeft = _cap/8*7;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+Value& rtypes::map<Key,Value,Hash,Alloc>::operator [](const Key& key)
+{
+    size_type index;
+    byte tag;
+    if (_growthLeft == 0)
+    {
+        // (see insert)
+        index = _findIndex(key,_mix(Hash()(key)));
+        if (index == _cap)
+        {
+            _Slot slot(key);
+            _prepareInsert(slot.key,index,tag);
+            new (_slots+index) _Slot( std::move(slot) );
+            _commitInsert(index,tag);
+        }
+    }
+    else if ( _prepareInsert(key,index,tag) )
+    {
+        new (_slots+index) _Slot(key);
+        _commitInsert(index,tag);
+    }
+    return _slots[index].value;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+template<typename Query>
+rtypes::size_type rtypes::map<Key,Value,Hash,Alloc>::_findIndex(const Query& key,uint64 h) const
+{
+    if (_sz > 0)
+    {
+        // probe the groups triangularly (g, g+1, g+3, g+6, ...), which
+        // visits every group when their number is a power of two
+        size_type mask = _cap/_map_group::WIDTH - 1, g = size_type(h>>7) & mask;
+        byte h2 = _h2(h);
+        for (size_type step = 1;step<=mask+1;step++)
+        {
+            const byte* group = _ctrl + g*_map_group::WIDTH;
+            uint32 m = _map_group::match(group,h2);
+            while (m != 0)
+            {
+                size_type i = g*_map_group::WIDTH + _map_group::lowest_bit(m);
+                if (_slots[i].key == key)
+                    return i;
+                m &= m-1;
+            }
+            // an element would have been placed in this group's empty slot
+            if (_map_group::match_empty(group) != 0)
+                break;
+            g = (g+step) & mask;
+        }
+    }
+    return _cap;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+bool rtypes::map<Key,Value,Hash,Alloc>::_prepareInsert(const Key& key,size_type& index,byte& tag)
+{
+    // the slot is only claimed by _commitInsert so that a constructor
+    // that throws leaves the map as it was
+    uint64 h = _mix(Hash()(key));
+    index = _findIndex(key,h);
+    if (index < _cap)
+        return false;
+    if (_growthLeft == 0)
+    {
+        // reclaim deleted slots in place if they make up much of
+        // the table; otherwise double the capacity
+        if (_cap>0 && _sz*2<_cap/8*7)
+            _rehash(_cap);
+        else
+            _rehash(_cap==0 ? _map_group::WIDTH : _cap*2);
+    }
+    index = _findFree(h);
+    tag = _h2(h);
+    return true;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+void rtypes::map<Key,Value,Hash,Alloc>::_commitInsert(size_type index,byte tag)
+{
+    if (_ctrl[index] == _map_group::EMPTY)
+        --_growthLeft;
+    _ctrl[index] = tag;
+    ++_sz;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+rtypes::size_type rtypes::map<Key,Value,Hash,Alloc>::_findFree(uint64 h) const
+{
+    // the table always has a free slot when this is called
+    size_type mask = _cap/_map_group::WIDTH - 1, g = size_type(h>>7) & mask;
+    for (size_type step = 1;;step++)
+    {
+        uint32 m = _map_group::match_free(_ctrl + g*_map_group::WIDTH);
+        if (m != 0)
+            return g*_map_group::WIDTH + _map_group::lowest_bit(m);
+        g = (g+step) & mask;
+    }
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+void rtypes::map<Key,Value,Hash,Alloc>::_removeIndex(size_type index)
+{
+    if (index < _cap)
+    {
+        _Raw::destroy(_slots+index);
+        // once a group has been without an empty slot a probe may have passed
+        // over it, and it must not end probes early; such groups never regain an
+        // empty slot, so a group with one can safely be given another
+        if (_map_group::match_empty(_ctrl + index/_map_group::WIDTH*_map_group::WIDTH) != 0)
+        {
+            _ctrl[index] = _map_group::EMPTY;
+            ++_growthLeft;
+        }
+        else
+            _ctrl[index] = _map_group::DELETED;
+        --_sz;
+    }
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+void rtypes::map<Key,Value,Hash,Alloc>::_rehash(size_type newCap)
+{
+    byte* oldCtrl = _ctrl;
+    _Slot* oldSlots = _slots;
+    size_type oldCap = _cap;
+    _allocTable(newCap);
+    for (size_type i = 0;i<oldCap;i++)
+    {
+        if ((oldCtrl[i] & 0x80) == 0)
+        {
+            uint64 h = _mix(Hash()(oldSlots[i].key));
+            size_type index = _findFree(h);
+            _ctrl[index] = _h2(h);
+            _Raw::relocate_range(_slots+index,oldSlots+i,1);
+        }
+    }
+    _growthLeft = newCap/8*7 - _sz;
+    if (oldCtrl != NULL)
+        _allocator().deallocate(oldCtrl,_slotOffset(oldCap)+oldCap*sizeof(_Slot));
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+void rtypes::map<Key,Value,Hash,Alloc>::_allocTable(size_type newCap)
+{
+    // control bytes and slots share one allocation
+    size_type offset = _slotOffset(newCap);
+    _ctrl = static_cast<byte*>( _allocator().allocate(offset+newCap*sizeof(_Slot)) );
+    _slots = reinterpret_cast<_Slot*>(_ctrl+offset);
+    for (size_type i = 0;i<newCap;i++)
+        _ctrl[i] = _map_group::EMPTY;
+    _cap = newCap;
+    _growthLeft = newCap/8*7;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+void rtypes::map<Key,Value,Hash,Alloc>::_freeTable()
+{
+    if (_ctrl != NULL)
+        _allocator().deallocate(_ctrl,_slotOffset(_cap)+_cap*sizeof(_Slot));
+    _ctrl = NULL;
+    _slots = NULL;
+    _cap = 0;
+    _growthLeft = 0;
+}
+template<typename Key,typename Value,class Hash,class Alloc>
+rtypes::size_type rtypes::map<Key,Value,Hash,Alloc>::_slotOffset(size_type cap)
+{
+    // slots follow the control bytes at their natural alignment
+    return (cap + alignof(_Slot)-1) & ~(alignof(_Slot)-1);
+}
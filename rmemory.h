@@ -0,0 +1,21 @@
+/* rmemory.h
+ *  rlibrary/rmemory - block memory primitives; these belong to the rutility
+ * functions (and rutility.h includes this header) but are declared on their
+ * own so that the allocators and containers can use them; each chooses SSE2
+ * or AVX2 kernels by the processor on its first call; copies and fills of
+ * several megabytes bypass the cache with non-temporal stores
+ */
+#ifndef RMEMORY_H
+#define RMEMORY_H
+#include "rtypestypes.h"
+
+namespace rtypes
+{
+    void* rutil_memcpy(void* pdest,const void* psource,size_type size); // copies between blocks that do not overlap; returns 'pdest'
+    void* rutil_memmove(void* pdest,const void* psource,size_type size); // copies between blocks that may overlap; returns 'pdest'
+    int rutil_memcmp(const void* pa,const void* pb,size_type size); // compares the blocks as unsigned bytes; returns <0, 0 or >0
+    const void* rutil_memchr(const void* pdata,size_type size,byte val); // returns the first byte equal to 'val' or NULL
+    void rutil_memfill(void* pdata,size_type size,byte val); // sets every byte of the block to 'val'
+}
+
+#endif
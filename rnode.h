@@ -2,6 +2,8 @@
 #ifndef RNODE_H
 #define RNODE_H
 
+#include <utility> // get std::forward
+
 #ifndef NULL
 #define NULL 0
 #endif
@@ -79,12 +81,18 @@ namespace rtypes
         T item;
     };
 
+    // selects a node constructor that passes its arguments on to the item
+    struct _rnode_emplace {};
+
     template<typename T>
     struct _rnode_double : _rnode_double_link< _rnode_double<T> >
     {
         _rnode_double() {}
         _rnode_double(const T& value)
             : item(value) {}
+        template<class... Args>
+        explicit _rnode_double(_rnode_emplace,Args&&... args)
+            : item( std::forward<Args>(args)... ) {}
 
         T item;
     };
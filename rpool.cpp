@@ -0,0 +1,97 @@
+// rpool.cpp
+#include "rpool.h"
+using namespace rtypes;
+
+namespace
+{
+    // nodes are aligned to the strictest fundamental alignment
+    const size_type POOL_ALIGNMENT = alignof(std::max_align_t);
+    // slabs stop growing at this many nodes
+    const size_type POOL_MAX_SLAB_NODES = 4096;
+
+    inline size_type pool_align(size_type n)
+    {
+        return (n + POOL_ALIGNMENT-1) & ~(POOL_ALIGNMENT-1);
+    }
+}
+
+node_pool::node_pool(size_type nodesPerSlab)
+{
+    _free = NULL;
+    _slabs = NULL;
+    _pos = NULL;
+    _end = NULL;
+    _nodeSize = 0;
+    _slabNodes = (nodesPerSlab>0 ? nodesPerSlab : 1);
+    _inUse = 0;
+    _reserved = 0;
+}
+node_pool::~node_pool()
+{
+    release();
+}
+void* node_pool::allocate(size_type bytes)
+{
+    bytes = pool_align(bytes>0 ? bytes : 1);
+    if (_nodeSize == 0)
+        _nodeSize = bytes; // the first allocation determines the node size
+    else if (bytes != _nodeSize)
+        return ::operator new(bytes);
+    ++_inUse;
+    // recycle a freed node if possible
+    if (_free != NULL)
+    {
+        _FreeNode* n = _free;
+        _free = n->next;
+        return n;
+    }
+    // carve the next node out of the newest slab
+    if (_pos == _end)
+        _newSlab();
+    void* p = _pos;
+    _pos += _nodeSize;
+    return p;
+}
+void node_pool::deallocate(void* p,size_type bytes)
+{
+    if (p == NULL)
+        return;
+    if (pool_align(bytes>0 ? bytes : 1) != _nodeSize)
+    {
+        ::operator delete(p);
+        return;
+    }
+    _FreeNode* n = static_cast<_FreeNode*>(p);
+    n->next = _free;
+    _free = n;
+    --_inUse;
+}
+void node_pool::release()
+{
+    _Slab* s = _slabs;
+    while (s != NULL)
+    {
+        _Slab* nxt = s->next;
+        ::operator delete(s);
+        s = nxt;
+    }
+    _free = NULL;
+    _slabs = NULL;
+    _pos = NULL;
+    _end = NULL;
+    _inUse = 0;
+    _reserved = 0;
+}
+void node_pool::_newSlab()
+{
+    const size_type header = pool_align(sizeof(_Slab));
+    _Slab* s = static_cast<_Slab*>( ::operator new(header + _slabNodes*_nodeSize) );
+    s->next = _slabs;
+    _slabs = s;
+    _pos = reinterpret_cast<byte*>(s) + header;
+    _end = _pos + _slabNodes*_nodeSize;
+    _reserved += _slabNodes;
+    // grow the next slab geometrically
+    if (_slabNodes < POOL_MAX_SLAB_NODES)
+        _slabNodes *= 2;
+}
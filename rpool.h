@@ -0,0 +1,97 @@
+/* rpool.h
+ *  rlibrary/rpool - provides a fixed-size node pool memory resource and an
+ * allocator policy that lets node-based rlibrary containers (e.g. list) draw
+ * their nodes from it
+ */
+#ifndef RPOOL_H
+#define RPOOL_H
+#include "rtypestypes.h"
+
+namespace rtypes
+{
+    /* node_pool
+     *  a memory resource for objects of one fixed size; nodes are carved out of
+     * slabs that grow geometrically (starting at 'nodesPerSlab' nodes) and freed
+     * nodes are kept on a free list to be recycled by the next allocation; the
+     * node size is fixed by the first allocation, and requests of any other size
+     * are forwarded to the global heap; a pool may be shared by several containers
+     * of the same type; it must outlive every container that uses it
+     */
+    class node_pool
+    {
+    public:
+        explicit node_pool(size_type nodesPerSlab = 64);
+        ~node_pool(); // frees all slabs
+
+        void* allocate(size_type bytes);
+        void deallocate(void* p,size_type bytes);
+
+        void release(); // frees all slabs; every node must have been returned or abandoned
+
+        size_type node_size() const // zero until the first allocation
+        { return _nodeSize; }
+        size_type nodes_in_use() const
+        { return _inUse; }
+        size_type nodes_reserved() const // number of nodes held in slabs
+        { return _reserved; }
+    private:
+        struct _FreeNode
+        {
+            _FreeNode* next;
+        };
+        struct _Slab
+        {
+            _Slab* next;
+        };
+
+        _FreeNode* _free; // recycled nodes
+        _Slab* _slabs;
+        byte* _pos; // unused region of the newest slab
+        byte* _end;
+        size_type _nodeSize;
+        size_type _slabNodes; // node count for the next slab
+        size_type _inUse;
+        size_type _reserved;
+
+        void _newSlab();
+
+        // disallow copying
+        node_pool(const node_pool&);
+        node_pool& operator =(const node_pool&);
+    };
+
+    /* pool_allocator
+     *  allocator policy that draws memory from a node_pool; a default-constructed
+     * pool_allocator is not bound to a pool and uses the global heap instead
+     *  e.g. list<str,pool_allocator> l(pool_allocator(listPool));
+     */
+    class pool_allocator
+    {
+    public:
+        pool_allocator()
+            : _pool(NULL) {}
+        pool_allocator(node_pool& pool)
+            : _pool(&pool) {}
+
+        void* allocate(size_type bytes)
+        {
+            if (_pool != NULL)
+                return _pool->allocate(bytes);
+            return ::operator new(bytes);
+        }
+        void deallocate(void* p,size_type bytes)
+        {
+            if (_pool != NULL)
+                _pool->deallocate(p,bytes);
+            else
+                ::operator delete(p);
+        }
+
+        node_pool* get_pool() const
+        { return _pool; }
+    private:
+        node_pool* _pool;
+    };
+}
+
+#endif
@@ -3,11 +3,12 @@
 #define RQUEUE_H
 #include "rerror.h"
 #include "rallocator.h" // gets rtypestypes.h
+#include "rdynarray.h"
 
 namespace rtypes
 {
-    template<class T>
-    class queue : protected rallocator<T>
+    template<class T,class Alloc = default_allocator>
+    class queue : protected rallocator<T,Alloc>
     {
     public:
         queue()
@@ -15,44 +16,123 @@ namespace rtypes
             _head = 0;
             _tail = 0;
         }
+        explicit queue(const Alloc& allocator)
+            : rallocator<T,Alloc>(allocator)
+        {
+            _head = 0;
+            _tail = 0;
+        }
+        queue(const queue& obj)
+            : rallocator<T,Alloc>(obj)
+        {
+            _head = 0;
+            _tail = obj._tail-obj._head;
+            _Raw::copy_range(_getData(),obj._getData()+obj._head,_tail);
+        }
+        queue(queue&& obj)
+            : rallocator<T,Alloc>( std::move(obj) )
+        {
+            // the elements stay where they are in the taken storage
+            _head = obj._head;
+            _tail = obj._tail;
+            obj._head = 0;
+            obj._tail = 0;
+        }
+        ~queue()
+        { clear(); }
+
+        queue& operator =(const queue& obj)
+        {
+            if (this != &obj)
+            {
+                size_type sz = obj._tail-obj._head;
+                clear();
+                if (sz > _allocationSize())
+                    _alloc(sz);
+                _Raw::copy_range(_getData(),obj._getData()+obj._head,sz);
+                _tail = sz;
+            }
+            return *this;
+        }
+        queue& operator =(queue&& obj)
+        {
+            if (this != &obj)
+            {
+                clear();
+                rallocator<T,Alloc>::operator =( std::move(obj) );
+                _head = obj._head;
+                _tail = obj._tail;
+                obj._head = 0;
+                obj._tail = 0;
+            }
+            return *this;
+        }
                 
         void push(const T& elem)
+        { emplace(elem); }
+        void push(T&& elem)
+        { emplace( std::move(elem) ); }
+        template<class... Args>
+        void emplace(Args&&... args) // constructs a new element at the back in place from 'args'
         {
-            if (_tail>=_allocationSize())
+            if (_tail >= _allocationSize())
             {
-                _alloc()[_tail++] = elem;
-                return;
+                // the new element is made before the others move in case an
+                // argument refers to one of them; it goes after where they
+                // will end up, which is in the popped space if that is larger
+                size_type sz = _tail-_head;
+                if (_head > sz)
+                {
+                    _Raw::emplace(_getData()+sz,std::forward<Args>(args)...);
+                    _Raw::relocate_range(_getData(),_getData()+_head,sz);
+                    _head = 0;
+                    _tail = sz;
+                }
+                else
+                    _allocEmplace(_allocationSize()==0 ? 4 : _allocationSize()*2,sz,std::forward<Args>(args)...);
             }
-            _getData()[_tail++] = elem;
+            else
+                _Raw::emplace(_getData()+_tail,std::forward<Args>(args)...);
+            ++_tail;
         }
         void push_range(const T* elems,size_type sz)
         {
             if (sz > 0)
             {
-                size_type neededPosition = _tail+sz-1;
-                while (neededPosition>=_allocationSize())
-                    _alloc();
-                T* buffer = _getData();
-                for (size_type i = 0;i<sz;i++)
-                    buffer[_tail++] = elems[i];
+                if (_tail+sz>_allocationSize() && !_reclaim(sz))
+                {
+                    size_type newSize = (_allocationSize()==0 ? 4 : _allocationSize()*2);
+                    while (newSize < _tail-_head+sz)
+                        newSize *= 2;
+                    _alloc(newSize);
+                }
+                _Raw::copy_range(_getData()+_tail,elems,sz);
+                _tail += sz;
             }
         }
                 
         T pop()
         {
-            if (_head+1==_tail)
-            {// the queue is about to become empty
-                T* elem = _getData()+_head;
-                clear(); // promote efficient data usage
-                return *elem;
+            // move the element out before it is destroyed
+            T* elem = _getData()+_head;
+            T r( std::move(*elem) );
+            _Raw::destroy(elem);
+            if (++_head==_tail)
+            {// the queue is now empty
+                _head = 0; // promote efficient data usage
+                _tail = 0;
             }
-            return _getData()[_head++];
+            return r;
         }
         void pop_range(size_type cnt)
         {// a "virtual" pop operation for "seeking" through the data
-            _head += cnt;
-            if (_head>=_tail)
+            if (_head+cnt>=_tail)
                 clear();
+            else
+            {
+                _Raw::destroy_range(_getData()+_head,cnt);
+                _head += cnt;
+            }
         }
                 
         T& peek()
@@ -67,13 +147,13 @@ namespace rtypes
                 
         void clear() // doesn't reduce capacity
         {
+            _Raw::destroy_range(_getData()+_head,_tail-_head);
             _head = 0;
             _tail = 0;
         }
         void reset() // reduces capacity
         {
-            _head = 0;
-            _tail = 0;
+            clear();
             _dealloc();
         }
                 
@@ -86,25 +166,58 @@ namespace rtypes
         { return _tail-_head; }
         size_type capacity() const
         { return _allocationSize(); }
+
+        using rallocator<T,Alloc>::get_allocator;
     protected:
-        using rallocator<T>::_allocationSize;
-        using rallocator<T>::_getData;
-        using rallocator<T>::_dealloc;
-        using rallocator<T>::_alloc;
-        virtual void _copy(T* copyTo,const T* copyFrom)
-        {
-            size_type i = 0;
-            for (size_type h = _head;h<_tail;h++,i++)
-                copyTo[i] = copyFrom[h];
+        typedef typename rallocator<T,Alloc>::_Raw _Raw;
+
+        using rallocator<T,Alloc>::_allocationSize;
+        using rallocator<T,Alloc>::_getData;
+        using rallocator<T,Alloc>::_dealloc;
+        using rallocator<T,Alloc>::_alloc;
+        using rallocator<T,Alloc>::_allocEmplace;
+        virtual void _relocate(T* moveTo,T* moveFrom)
+        {
+            _Raw::relocate_range(moveTo,moveFrom+_head,_tail-_head);
+            _tail -= _head;
             _head = 0;
-            _tail = i;
         }
     private:
         size_type _head, _tail;
+
+        bool _reclaim(size_type cnt)
+        {
+            // move the elements down over the space freed by pops when that
+            // space is at least as large as the elements themselves (so that
+            // the ranges don't overlap) and makes room for 'cnt' more
+            size_type sz = _tail-_head;
+            if (_head<sz || sz+cnt>_allocationSize())
+                return false;
+            _Raw::relocate_range(_getData(),_getData()+_head,sz);
+            _head = 0;
+            _tail = sz;
+            return true;
+        }
     };
 
+    /* queue_span
+     *  a contiguous run of elements within a container's storage
+     */
     template<class T>
-    class wrapped_queue : protected rallocator<T>
+    struct queue_span
+    {
+        T* data;
+        size_type length;
+    };
+
+    /* wrapped_queue
+     *  a FIFO queue stored in a ring buffer whose capacity is a power of two;
+     * positions are free-running counters reduced by a mask, so every slot of
+     * the buffer is usable; the range operations move blocks of elements with
+     * at most two bulk copies, one for each contiguous span of the ring
+     */
+    template<class T,class Alloc = default_allocator>
+    class wrapped_queue : protected rallocator<T,Alloc>
     {
     public:
         wrapped_queue()
@@ -112,100 +225,246 @@ namespace rtypes
             _head = 0;
             _tail = 0;
         }
+        explicit wrapped_queue(const Alloc& allocator)
+            : rallocator<T,Alloc>(allocator)
+        {
+            _head = 0;
+            _tail = 0;
+        }
+        wrapped_queue(const wrapped_queue& obj)
+            : rallocator<T,Alloc>(obj)
+        {
+            _head = 0;
+            _tail = obj._copyElems(_getData());
+        }
+        wrapped_queue(wrapped_queue&& obj)
+            : rallocator<T,Alloc>( std::move(obj) )
+        {
+            // the positions are only meaningful with the taken storage
+            _head = obj._head;
+            _tail = obj._tail;
+            obj._head = 0;
+            obj._tail = 0;
+        }
+        ~wrapped_queue()
+        { clear(); }
+
+        wrapped_queue& operator =(const wrapped_queue& obj)
+        {
+            if (this != &obj)
+            {
+                clear();
+                if (obj.size() > _allocationSize())
+                    _alloc(obj._allocationSize());
+                _tail = obj._copyElems(_getData());
+            }
+            return *this;
+        }
+        wrapped_queue& operator =(wrapped_queue&& obj)
+        {
+            if (this != &obj)
+            {
+                clear();
+                rallocator<T,Alloc>::operator =( std::move(obj) );
+                _head = obj._head;
+                _tail = obj._tail;
+                obj._head = 0;
+                obj._tail = 0;
+            }
+            return *this;
+        }
                 
         void push(const T& elem)
+        { emplace(elem); }
+        void push(T&& elem)
+        { emplace( std::move(elem) ); }
+        template<class... Args>
+        void emplace(Args&&... args) // constructs a new element at the back in place from 'args'
         {
-            T* data;
-            // check for ability to wrap
-            if (_tail>=_allocationSize() && _head>1)
-                _tail = 0; // wrap to unused indeces
-            // check allocation and assign data
-            if (_tail>=_allocationSize() || _tail==_head-1)
-                data = _alloc(); // need more space
+            // (doubling keeps the capacity a power of two; the new element is
+            // made before the others move in case an argument refers to one)
+            if (_tail-_head == _allocationSize())
+                _allocEmplace(_allocationSize()==0 ? 4 : _allocationSize()*2,size(),std::forward<Args>(args)...);
             else
-                data = _getData();
-            // push element
-            data[_tail++] = elem;
+                _Raw::emplace(_getData()+(_tail&_mask()),std::forward<Args>(args)...);
+            ++_tail;
+        }
+        void push_range(const T* elems,size_type cnt)
+        {
+            _fit(cnt);
+            T* data = _getData();
+            size_type pos = _tail&_mask(), first = _allocationSize()-pos;
+            if (first > cnt)
+                first = cnt;
+            _Raw::copy_range(data+pos,elems,first);
+            _Raw::copy_range(data,elems+first,cnt-first);
+            _tail += cnt;
         }
                 
         T pop()
         {
-            T* data = _getData();
-            T& r = data[_head++];
-            // check tail for wrapping
-            if (_head>=_allocationSize() /* possible wrap */
-                && _tail<_head /* is wrapping */)
-                _head = 0;
-            else if (is_empty())
-                clear(); // use old space
+            // move the element out before it is destroyed
+            T* elem = _getData()+(_head&_mask());
+            T r( std::move(*elem) );
+            _Raw::destroy(elem);
+            ++_head;
             return r;
         }
+        /* pop_range( destination, count )
+         *  moves up to 'count' elements out of the queue into the (constructed)
+         *  elements at 'destination'; returns the number of elements popped
+         * pop_range( count )
+         *  removes up to 'count' elements without retrieving them
+         */
+        size_type pop_range(T* dest,size_type cnt)
+        {
+            queue_span<T> spans[2];
+            if (cnt > size())
+                cnt = size();
+            _spans(spans,cnt);
+            _moveOut(dest,spans[0].data,spans[0].length);
+            _moveOut(dest+spans[0].length,spans[1].data,spans[1].length);
+            _head += cnt;
+            return cnt;
+        }
+        size_type pop_range(size_type cnt)
+        {
+            queue_span<T> spans[2];
+            if (cnt > size())
+                cnt = size();
+            _spans(spans,cnt);
+            _Raw::destroy_range(spans[0].data,spans[0].length);
+            _Raw::destroy_range(spans[1].data,spans[1].length);
+            _head += cnt;
+            return cnt;
+        }
+        /* peek_range( first, second )
+         *  describes the elements in queue order as at most two contiguous
+         *  spans (the second is empty unless the elements wrap around the end
+         *  of the buffer); returns the number of elements; the spans are
+         *  invalidated by a subsequent push or pop
+         */
+        size_type peek_range(queue_span<T>& first,queue_span<T>& second)
+        {
+            queue_span<T> spans[2];
+            _spans(spans,size());
+            first = spans[0];
+            second = spans[1];
+            return size();
+        }
+        size_type peek_range(queue_span<const T>& first,queue_span<const T>& second) const
+        {
+            queue_span<T> spans[2];
+            _spans(spans,size());
+            first.data = spans[0].data;
+            first.length = spans[0].length;
+            second.data = spans[1].data;
+            second.length = spans[1].length;
+            return size();
+        }
                 
         T& peek()
-        { return _getData[_head]; }
+        { return _getData()[_head&_mask()]; }
         const T& peek() const
-        { return _getData[_head]; }
+        { return _getData()[_head&_mask()]; }
                 
         T& back()
-        { return _getData[_tail-1]; }
+        { return _getData()[(_tail-1)&_mask()]; }
         const T& back() const
-        { return _getData[_tail-1]; }
+        { return _getData()[(_tail-1)&_mask()]; }
                 
         bool is_empty() const
         { return _head==_tail; }
                 
         void clear()
         {// maintain current capacity
+            pop_range(size());
             _head = 0;
             _tail = 0;
         }
         void reset()
         {
+            clear();
             _dealloc(); // reduce capacity to zero
             _alloc();
         }
                 
         size_type size() const
-        {
-            if (_tail<_head)
-                return _allocationSize()-_head + _tail;
-            return _tail-_head;
-        }
+        { return _tail-_head; }
         size_type count() const
-        { return size(); }
+        { return _tail-_head; }
         size_type capacity() const // number of possible elements that could fit in queue
-        {
-            if (_head>1) // can wrap
-                //              wrapped + linear = alloc size -1
-                return _allocationSize()-1;
-            return _allocationSize()-_head;
-        }
+        { return _allocationSize(); }
+
+        using rallocator<T,Alloc>::get_allocator;
     protected:
-        using rallocator<T>::_allocationSize;
-        using rallocator<T>::_getData;
-        using rallocator<T>::_dealloc;
-        using rallocator<T>::_alloc;
-        virtual void _copy(T* copyTo,const T* copyFrom)
+        typedef typename rallocator<T,Alloc>::_Raw _Raw;
+
+        using rallocator<T,Alloc>::_allocationSize;
+        using rallocator<T,Alloc>::_getData;
+        using rallocator<T,Alloc>::_dealloc;
+        using rallocator<T,Alloc>::_alloc;
+        using rallocator<T,Alloc>::_allocEmplace;
+        virtual void _relocate(T* moveTo,T* /*moveFrom*/)
         {// callback for whenever a reallocation has occurred
-            size_type i = 0;
-            if (_tail>_head)
-            {// copy from head to tail
-                for (;_head<_tail;_head++,i++)
-                    copyTo[i] = copyFrom[_head];
-            }
-            else if (_tail<_head)
-            {// copy from head to allocation size-1 and from 0 to _tail-1
-                for (;_head<_allocationSize();_head++,i++)
-                    copyTo[i] = copyFrom[_head];
-                for (size_type t = 0;t<_tail;t++,i++)
-                    copyTo[i] = copyFrom[t];
-            }
-            // else is empty
+            queue_span<T> spans[2];
+            size_type sz = size();
+            _spans(spans,sz);
+            _Raw::relocate_range(moveTo,spans[0].data,spans[0].length);
+            _Raw::relocate_range(moveTo+spans[0].length,spans[1].data,spans[1].length);
             _head = 0;
-            _tail = i;
+            _tail = sz;
         }
     private:
-        size_type _head, _tail;
+        size_type _head, _tail; // free-running positions; reduced by _mask()
+
+        size_type _mask() const
+        { return _allocationSize()-1; }
+        void _spans(queue_span<T>* spans,size_type cnt) const
+        {// splits the first 'cnt' elements at the end of the buffer
+            T* data = _getData();
+            size_type pos = _head&_mask(), first = _allocationSize()-pos;
+            if (first > cnt)
+                first = cnt;
+            spans[0].data = data+pos;
+            spans[0].length = first;
+            spans[1].data = data;
+            spans[1].length = cnt-first;
+        }
+        void _fit(size_type cnt)
+        {// grows the buffer to the next power of two that holds 'cnt' more elements
+            size_type need = size()+cnt, newSize = _allocationSize();
+            if (need > newSize)
+            {
+                if (newSize == 0)
+                    newSize = 4;
+                while (newSize < need)
+                    newSize *= 2;
+                _alloc(newSize);
+            }
+        }
+        static void _moveOut(T* moveTo,T* moveFrom,size_type cnt)
+        {
+            if (_Raw::trivial_copy)
+            {
+                if (cnt > 0)
+                    rutil_memcpy(moveTo,moveFrom,cnt*sizeof(T));
+            }
+            else
+                for (size_type i = 0;i<cnt;i++)
+                {
+                    moveTo[i] = std::move(moveFrom[i]);
+                    moveFrom[i].~T();
+                }
+        }
+        size_type _copyElems(T* copyTo) const
+        {// copy-constructs the elements in order into raw storage
+            queue_span<T> spans[2];
+            _spans(spans,size());
+            _Raw::copy_range(copyTo,spans[0].data,spans[0].length);
+            _Raw::copy_range(copyTo+spans[0].length,spans[1].data,spans[1].length);
+            return size();
+        }
     };
 
     template<class T,class P>
@@ -215,14 +474,20 @@ namespace rtypes
         P priority;
     };
 
+    /* bucket_priority_queue
+     *  a priority queue that keeps a FIFO queue for each distinct priority in
+     * a sorted array; pushing with an existing priority is O(log k) and a new
+     * priority costs O(k) for k distinct priorities, so it suits a few coarse
+     * priorities; elements with the greatest priority are popped first
+     */
     template<class T,class P>
-    class priority_queue : protected rallocatorEx< priority_queue_elem<T,P>* >
+    class bucket_priority_queue : protected rallocatorEx< priority_queue_elem<T,P>* >
     {
     public:
-        priority_queue()
-        { }
-        priority_queue(const priority_queue& pq)
-            : rallocatorEx<_pq_data_ptr> (pq)
+        bucket_priority_queue()
+            : _count(0) { }
+        bucket_priority_queue(const bucket_priority_queue& pq)
+            : rallocatorEx<_pq_data_ptr> (pq), _count(pq._count)
         {
             // define a custom copy operation since the
             // allocator's copy c-str will only copy the pointer values
@@ -234,23 +499,32 @@ namespace rtypes
                 *(thisData[i]) = *(thatData[i]);
             }
         }
-        ~priority_queue()
+        ~bucket_priority_queue()
         {
             _pq_data_ptr* data = _getData();
             for (size_type i = 0;i<_size();i++)
                 delete data[i];
         }
-        priority_queue& operator =(const priority_queue& pq)
+        bucket_priority_queue& operator =(const bucket_priority_queue& pq)
         {
             // define a custom copy operation since the allocator 
             // will only copy pointer values
             if (&pq==this)
                 return *this;
-            _virtAlloc(pq._size());
+            size_type oldSize = _size();
             _pq_data_ptr* thisData = _getData();
+            for (size_type i = pq._size();i<oldSize;i++)
+                delete thisData[i]; // unused elements are destroyed by the allocator
+            _virtAlloc(pq._size());
+            thisData = _getData();
             _pq_data_ptr* thatData = pq._getData();
             for (size_type i = 0;i<_size();i++)
+            {
+                if (i >= oldSize)
+                    thisData[i] = new priority_queue_elem<T,P>;
                 *(thisData[i]) = *(thatData[i]);
+            }
+            _count = pq._count;
             return *this;
         }
         void push(const T& elem,const P& priority)
@@ -263,15 +537,13 @@ namespace rtypes
             }
             else
             {// create a new queue for the new priority
-                _pq_data_ptr* data;
                 _pq_data_ptr element = new priority_queue_elem<T,P>;
                 element->priority = priority;
                 element->data.push(elem);
-                _virtAlloc(_size()+1);
-                data = _getData();
-                data[_size()-1] = element;
+                _virtPush(element);
                 _sortElems(); // sort for easy searching
             }
+            ++_count;
         }
         T pop()
         {
@@ -282,6 +554,7 @@ namespace rtypes
                 i--;
             if (i>=_size())
                 throw empty_container_error(); // no element to pop (i wrapped to the top value)
+            --_count;
             return data[i]->data.pop();
         }
 
@@ -291,21 +564,22 @@ namespace rtypes
             _pq_data_ptr* data = _getData();
             for (size_type i = 0;i<_size();i++)
                 data[i]->data.clear();
+            _count = 0;
         }
         void reset() // decreases capacity
-        { _dealloc(); }
+        {
+            _pq_data_ptr* data = _getData();
+            for (size_type i = 0;i<_size();i++)
+                delete data[i];
+            _dealloc();
+            _count = 0;
+        }
                 
         bool is_empty() const
         { return size()==0; }
                 
         size_type size() const
-        {
-            _pq_data_ptr* data = _getData();
-            size_type sz = 0;
-            for (size_type i = 0;i<_size();i++)
-                sz += data[i]->data.size();
-            return sz;
-        }
+        { return _count; }
         size_type count() const
         { return size(); }
         size_type priority_count() const
@@ -332,9 +606,12 @@ namespace rtypes
         using rallocatorEx<_pq_data_ptr>::_size;
         using rallocatorEx<_pq_data_ptr>::_getData;
         using rallocatorEx<_pq_data_ptr>::_dealloc;
-        using rallocatorEx<_pq_data_ptr>::_copy;
+        using rallocatorEx<_pq_data_ptr>::_virtAlloc;
+        using rallocatorEx<_pq_data_ptr>::_virtPush;
 
     private:
+        size_type _count; // elements across all priorities
+
         void _sortElems()
         {
             _pq_data_ptr* data = _getData();
@@ -370,6 +647,256 @@ namespace rtypes
         }
     };
 
+    template<class T,class P>
+    struct _pq_heap_entry
+    {
+        T elem;
+        P priority;
+        uint64 seq; // push order; breaks ties between equal priorities
+        size_type handle;
+    };
+
+    /* priority_queue
+     *  a priority queue stored as an implicit d-ary heap in one contiguous
+     * array ('Arity' children per node; the default of 4 keeps a node's children
+     * within a cache line for small elements); push and pop are O(log n) and
+     * elements with the greatest priority are popped first, in push order among
+     * equal priorities; push returns a handle through which the element's
+     * priority may be changed or the element removed while it is in the queue;
+     * a handle is invalidated when its element leaves the queue and may then be
+     * reused; see bucket_priority_queue for a queue suited to a few coarse priorities
+     */
+    template<class T,class P,size_type Arity = 4,class Alloc = default_allocator>
+    class priority_queue : protected rallocatorEx<_pq_heap_entry<T,P>,Alloc>
+    {
+        typedef _pq_heap_entry<T,P> _Entry;
+        typedef rallocatorEx<_Entry,Alloc> _Base;
+        static const size_type _NO_HANDLE = ~size_type(0);
+        static_assert(Arity >= 2,"a heap node must have at least two children");
+    public:
+        typedef size_type handle;
+
+        priority_queue()
+            : _seq(0), _freeHandle(_NO_HANDLE) {}
+        explicit priority_queue(const Alloc& allocator)
+            : _Base(allocator), _pos(allocator), _seq(0), _freeHandle(_NO_HANDLE) {}
+
+        handle push(const T& elem,const P& priority)
+        {
+            handle h = _acquireHandle();
+            _Entry entry = { elem, priority, _seq++, h };
+            _virtPush( std::move(entry) );
+            _siftUp(_size()-1);
+            return h;
+        }
+        handle push(T&& elem,const P& priority)
+        {
+            handle h = _acquireHandle();
+            _Entry entry = { std::move(elem), priority, _seq++, h };
+            _virtPush( std::move(entry) );
+            _siftUp(_size()-1);
+            return h;
+        }
+        T pop()
+        {
+            if (_size() == 0)
+                throw empty_container_error();
+            _Entry* data = _getData();
+            T elem( std::move(data[0].elem) );
+            _releaseHandle(data[0].handle);
+            _removeAt(0);
+            return elem;
+        }
+        const T& top() const
+        {
+            if (_size() == 0)
+                throw empty_container_error();
+            return _getData()[0].elem;
+        }
+        const P& top_priority() const
+        {
+            if (_size() == 0)
+                throw empty_container_error();
+            return _getData()[0].priority;
+        }
+
+        /* update( handle, priority )
+         *  changes the priority of the element referred to by
+         *  the handle and restores its position in O(log n)
+         */
+        void update(handle h,const P& priority)
+        {
+            size_type i = _pos[h];
+            _Entry* data = _getData();
+            bool raised = data[i].priority < priority;
+            data[i].priority = priority;
+            if (raised)
+                _siftUp(i);
+            else
+                _siftDown(i);
+        }
+        /* remove( handle )
+         *  removes the element referred to by the handle
+         */
+        void remove(handle h)
+        {
+            size_type i = _pos[h];
+            _releaseHandle(h);
+            _removeAt(i);
+        }
+        const T& get(handle h) const
+        { return _getData()[_pos[h]].elem; }
+        const P& priority_of(handle h) const
+        { return _getData()[_pos[h]].priority; }
+
+        /* reserve( count )
+         *  allocates room for 'count' elements
+         */
+        void reserve(size_type cnt)
+        { _reserve(cnt); }
+
+        void clear() // maintains the current capacity
+        {
+            _virtAlloc(0);
+            _pos.clear();
+            _freeHandle = _NO_HANDLE;
+        }
+        void reset() // decreases capacity
+        {
+            _dealloc();
+            _pos.reset();
+            _freeHandle = _NO_HANDLE;
+        }
+
+        bool is_empty() const
+        { return _size()==0; }
+        size_type size() const
+        { return _size(); }
+        size_type count() const
+        { return _size(); }
+        size_type capacity() const
+        { return _allocationSize(); }
+
+        /* priority_count()
+         *  the number of distinct priorities in the queue; the heap keeps no
+         *  per-priority record (unlike bucket_priority_queue), so this takes the
+         *  priorities out of a copy of the heap in order: O(n log n)
+         */
+        size_type priority_count() const
+        {
+            priority_queue<bool,P,Arity,Alloc> ordered;
+            const _Entry* data = _getData();
+            ordered.reserve(_size());
+            for (size_type i = 0;i<_size();i++)
+                ordered.push(false,data[i].priority);
+            size_type c = 0;
+            while ( !ordered.is_empty() )
+            {
+                P p = ordered.top_priority();
+                ordered.pop();
+                if (ordered.is_empty() || ordered.top_priority()<p)
+                    ++c;
+            }
+            return c;
+        }
+
+        using _Base::get_allocator;
+    protected:
+        using _Base::_allocationSize;
+        using _Base::_size;
+        using _Base::_getData;
+        using _Base::_dealloc;
+        using _Base::_virtAlloc;
+        using _Base::_virtPush;
+        using _Base::_reserve;
+    private:
+        dynamic_array<size_type,Alloc> _pos; // heap index of each live handle; free handles are chained through it
+        uint64 _seq;
+        size_type _freeHandle;
+
+        // determines if 'a' belongs above 'b' in the heap
+        static bool _before(const _Entry& a,const _Entry& b)
+        {
+            if (b.priority < a.priority)
+                return true;
+            return !(a.priority < b.priority) && a.seq < b.seq;
+        }
+        size_type _acquireHandle()
+        {
+            if (_freeHandle != _NO_HANDLE)
+            {
+                size_type h = _freeHandle;
+                _freeHandle = _pos[h];
+                return h;
+            }
+            _pos.push_back(0);
+            return _pos.size()-1;
+        }
+        void _releaseHandle(size_type h)
+        {
+            _pos[h] = _freeHandle;
+            _freeHandle = h;
+        }
+        void _removeAt(size_type i)
+        {
+            // fill the hole with the last element and restore the heap
+            size_type last = _size()-1;
+            _Entry* data = _getData();
+            if (i < last)
+            {
+                data[i] = std::move(data[last]);
+                _pos[data[i].handle] = i;
+                _virtAlloc(last);
+                if (i>0 && _before(data[i],data[(i-1)/Arity]))
+                    _siftUp(i);
+                else
+                    _siftDown(i);
+            }
+            else
+                _virtAlloc(last);
+        }
+        void _siftUp(size_type i)
+        {
+            // move a hole up to the element's place instead of swapping
+            _Entry* data = _getData();
+            _Entry entry( std::move(data[i]) );
+            while (i > 0)
+            {
+                size_type parent = (i-1) / Arity;
+                if ( !_before(entry,data[parent]) )
+                    break;
+                data[i] = std::move(data[parent]);
+                _pos[data[i].handle] = i;
+                i = parent;
+            }
+            data[i] = std::move(entry);
+            _pos[data[i].handle] = i;
+        }
+        void _siftDown(size_type i)
+        {
+            _Entry* data = _getData();
+            size_type sz = _size();
+            _Entry entry( std::move(data[i]) );
+            while (true)
+            {
+                size_type first = i*Arity+1, best = first;
+                if (first >= sz)
+                    break;
+                size_type end = (sz-first>Arity ? first+Arity : sz);
+                for (size_type c = first+1;c<end;c++)
+                    if ( _before(data[c],data[best]) )
+                        best = c;
+                if ( !_before(data[best],entry) )
+                    break;
+                data[i] = std::move(data[best]);
+                _pos[data[i].handle] = i;
+                i = best;
+            }
+            data[i] = std::move(entry);
+            _pos[data[i].handle] = i;
+        }
+    };
+
 }
 
 #endif
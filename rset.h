@@ -2,6 +2,8 @@
 #ifndef RSET_H
 #define RSET_H
 #include "rlist.h"
+#include "rallocator.h"
+#include "rhash.h"
 
 namespace rtypes
 {
@@ -67,6 +69,101 @@ namespace rtypes
     private:
         list<T> _l;
     };
+
+    /* hash_set
+     *  a set implemented as an open-addressing hash table with Robin Hood
+     * probing; it provides the same interface as 'set' with expected O(1)
+     * insert, remove and contains; elements must be equality comparable and
+     * have a hashing trait (see rhash.h); the table capacity is always a
+     * power of two and is kept at most 7/8 full
+     */
+    template<typename T,class Hash = hash<T>,class Alloc = default_allocator>
+    class hash_set : private Alloc
+    {
+    public:
+        hash_set();
+        explicit hash_set(const Alloc& allocator);
+        hash_set(const hash_set&);
+        ~hash_set();
+
+        hash_set& operator =(const hash_set&);
+
+        /* insert( element )
+         *  adds the specified element to the set
+         *  if it does not exist already; returns false
+         *  if it already exists
+         */
+        bool insert(const T& elem);
+
+        /* remove( element )
+         *  removes the specified element if it exists;
+         */
+        void remove(const T& elem);
+
+        /* empty( )
+         *  removes all elements from the set; the
+         *  table capacity is kept
+         */
+        void empty();
+
+        /* contains( element )
+         *  determines if the element is in the set
+         */
+        bool contains(const T& elem) const
+        { return _find(elem) < _cap; }
+
+        /* reserve( count )
+         *  grows the table so that 'count' elements fit
+         *  without rehashing
+         */
+        void reserve(size_type cnt);
+
+        /* is_empty( )
+         *  determines if there are any elements in the set
+         */
+        bool is_empty() const
+        { return _sz==0; }
+
+        /* size( )
+         *  returns the number of elements in the set
+         */
+        size_type size() const
+        { return _sz; }
+
+        /* capacity( )
+         *  returns the number of slots in the table
+         */
+        size_type capacity() const
+        { return _cap; }
+
+        bool operator ==(const hash_set& obj) const;
+        bool operator !=(const hash_set& obj) const
+        { return !(*this==obj); }
+
+        Alloc get_allocator() const
+        { return *this; }
+    private:
+        typedef _rallocator_raw<T> _Raw;
+
+        T* _slots; // raw storage; only slots with a non-zero distance are constructed
+        byte* _dist; // probe distance plus one for each slot (zero marks an empty slot)
+        size_type _cap; // zero or a power of two
+        size_type _sz;
+        uint32 _shift; // 64 - log2(_cap)
+
+        Alloc& _allocator()
+        { return *this; }
+        size_type _home(const T& elem) const
+        { return size_type( (Hash()(elem) * 11400714819323198485ull) >> _shift ); }
+        size_type _find(const T& elem) const; // returns _cap if not found
+        void _place(T& elem); // places an element known not to be in the table; 'elem' is consumed
+        void _rehash(size_type newCap);
+        void _allocTable(size_type newCap);
+        void _freeTable();
+    };
 }
 
+// include out-of-line implementation
+#include "rset.tcc"
+
 #endif
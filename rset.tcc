@@ -0,0 +1,224 @@
+// rset.tcc - out-of-line implementation for rset
+
+// rtypes::hash_set<>
+template<typename T,class Hash,class Alloc>
+rtypes::hash_set<T,Hash,Alloc>::hash_set()
+{
+    _slots = NULL;
+    _dist = NULL;
+    _cap = 0;
+    _sz = 0;
+    _shift = 64;
+}
+template<typename T,class Hash,class Alloc>
+rtypes::hash_set<T,Hash,Alloc>::hash_set(const Alloc& allocator)
+    : Alloc(allocator)
+{
+    _slots = NULL;
+    _dist = NULL;
+    _cap = 0;
+    _sz = 0;
+    _shift = 64;
+}
+template<typename T,class Hash,class Alloc>
+rtypes::hash_set<T,Hash,Alloc>::hash_set(const hash_set& obj)
+    : Alloc(obj)
+{
+    _slots = NULL;
+    _dist = NULL;
+    _cap = 0;
+    _sz = 0;
+    _shift = 64;
+    *this = obj;
+}
+template<typename T,class Hash,class Alloc>
+rtypes::hash_set<T,Hash,Alloc>::~hash_set()
+{
+    empty();
+    _freeTable();
+}
+template<typename T,class Hash,class Alloc>
+rtypes::hash_set<T,Hash,Alloc>& rtypes::hash_set<T,Hash,Alloc>::operator =(const hash_set& obj)
+{
+    if (this != &obj)
+    {
+        empty();
+        if (_cap != obj._cap)
+        {
+            _freeTable();
+            if (obj._cap > 0)
+                _allocTable(obj._cap);
+        }
+        // copy the table layout as is; the hash functions agree
+        for (size_type i = 0;i<_cap;i++)
+        {
+            if (obj._dist[i] != 0)
+                _Raw::construct(_slots+i,obj._slots[i]);
+            _dist[i] = obj._dist[i];
+        }
+        _sz = obj._sz;
+    }
+    return *this;
+}
+template<typename T,class Hash,class Alloc>
+bool rtypes::hash_set<T,Hash,Alloc>::insert(const T& elem)
+{
+    if (_find(elem) < _cap)
+        return false;
+    // keep the table at most 7/8 full
+    if ((_sz+1)*8 > _cap*7)
+        _rehash(_cap==0 ? 8 : _cap*2);
+    T tmp(elem);
+    _place(tmp);
+    ++_sz;
+    return true;
+}
+template<typename T,class Hash,class Alloc>
+void rtypes::hash_set<T,Hash,Alloc>::remove(const T& elem)
+{
+    size_type i = _find(elem);
+    if (i < _cap)
+    {
+        // backward-shift deletion: pull each following displaced
+        // element back one slot so that no tombstones are needed
+        size_type mask = _cap-1, nxt = (i+1) & mask;
+        _Raw::destroy(_slots+i);
+        while (_dist[nxt] > 1)
+        {
+            _Raw::construct(_slots+i,std::move(_slots[nxt]));
+            _Raw::destroy(_slots+nxt);
+            _dist[i] = _dist[nxt]-1;
+            i = nxt;
+            nxt = (nxt+1) & mask;
+        }
+        _dist[i] = 0;
+        --_sz;
+    }
+}
+template<typename T,class Hash,class Alloc>
+void rtypes::hash_set<T,Hash,Alloc>::empty()
+{
+    for (size_type i = 0;i<_cap;i++)
+    {
+        if (_dist[i] != 0)
+        {
+            _Raw::destroy(_slots+i);
+            _dist[i] = 0;
+        }
+    }
+    _sz = 0;
+}
+template<typename T,class Hash,class Alloc>
+void rtypes::hash_set<T,Hash,Alloc>::reserve(size_type cnt)
+{
+    size_type newCap = (_cap==0 ? 8 : _cap);
+    while (cnt*8 > newCap*7)
+        newCap *= 2;
+    if (newCap > _cap)
+        _rehash(newCap);
+}
+template<typename T,class Hash,class Alloc>
+bool rtypes::hash_set<T,Hash,Alloc>::operator ==(const hash_set& obj) const
+{
+    if (_sz != obj._sz)
+        return false;
+    for (size_type i = 0;i<_cap;i++)
+        if (_dist[i]!=0 && !obj.contains(_slots[i]))
+            return false;
+    return true;
+}
+template<typename T,class Hash,class Alloc>
+rtypes::size_type rtypes::hash_set<T,Hash,Alloc>::_find(const T& elem) const
+{
+    if (_sz > 0)
+    {
+        size_type mask = _cap-1, i = _home(elem);
+        byte d = 1;
+        // an element can't be further along than a slot whose occupant is
+        // closer to its home position (or an empty slot)
+        while (_dist[i] >= d)
+        {
+            if (_dist[i]==d && _slots[i]==elem)
+                return i;
+            i = (i+1) & mask;
+            ++d;
+        }
+    }
+    return _cap;
+}
+template<typename T,class Hash,class Alloc>
+void rtypes::hash_set<T,Hash,Alloc>::_place(T& elem)
+{
+    size_type mask = _cap-1, i = _home(elem);
+    byte d = 1;
+    while (true)
+    {
+        if (_dist[i] == 0)
+        {
+            _Raw::construct(_slots+i,std::move(elem));
+            _dist[i] = d;
+            return;
+        }
+        if (_dist[i] < d)
+        {
+            // Robin Hood: take the slot from the element that is closer
+            // to its home position and carry that element on instead
+            std::swap(elem,_slots[i]);
+            std::swap(d,_dist[i]);
+        }
+        i = (i+1) & mask;
+        if (++d == 255)
+        {
+            // probe distance no longer fits; grow the table and
+            // place the carried element there
+            _rehash(_cap*2);
+            _place(elem);
+            return;
+        }
+    }
+}
+template<typename T,class Hash,class Alloc>
+void rtypes::hash_set<T,Hash,Alloc>::_rehash(size_type newCap)
+{
+    T* oldSlots = _slots;
+    byte* oldDist = _dist;
+    size_type oldCap = _cap;
+    _allocTable(newCap);
+    for (size_type i = 0;i<oldCap;i++)
+    {
+        if (oldDist[i] != 0)
+        {
+            T tmp( std::move(oldSlots[i]) );
+            _Raw::destroy(oldSlots+i);
+            _place(tmp);
+        }
+    }
+    if (oldSlots != NULL)
+        _allocator().deallocate(oldSlots,oldCap*sizeof(T)+oldCap);
+}
+template<typename T,class Hash,class Alloc>
+void rtypes::hash_set<T,Hash,Alloc>::_allocTable(size_type newCap)
+{
+    // slots and distances share one allocation
+    _slots = static_cast<T*>( _allocator().allocate(newCap*sizeof(T)+newCap) );
+    _dist = reinterpret_cast<byte*>(_slots+newCap);
+    for (size_type i = 0;i<newCap;i++)
+        _dist[i] = 0;
+    _cap = newCap;
+    _shift = 64;
+    while (newCap > 1)
+    {
+        newCap >>= 1;
+        --_shift;
+    }
+}
+template<typename T,class Hash,class Alloc>
+void rtypes::hash_set<T,Hash,Alloc>::_freeTable()
+{
+    if (_slots != NULL)
+        _allocator().deallocate(_slots,_cap*sizeof(T)+_cap);
+    _slots = NULL;
+    _dist = NULL;
+    _cap = 0;
+    _shift = 64;
+}
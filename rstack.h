@@ -6,23 +6,32 @@
 
 namespace rtypes
 {
-    template<class T>
-    class stack : protected rallocatorEx<T>
+    template<class T,class Alloc = default_allocator>
+    class stack : protected rallocatorEx<T,Alloc>
     {
     public:
+        stack()
+        { }
+        explicit stack(const Alloc& allocator)
+            : rallocatorEx<T,Alloc>(allocator)
+        { }
+
         void push(const T& elem)
-        {
-            size_type oldSize = _size();
-            _virtAlloc(oldSize+1);  
-            _getData()[oldSize] = elem;
-        }
+        { _virtPush(elem); }
+        void push(T&& elem)
+        { _virtPush( std::move(elem) ); }
+        template<class... Args>
+        void emplace(Args&&... args) // constructs a new top element in place from 'args'
+        { _virtEmplace( std::forward<Args>(args)... ); }
                 
         T pop()
         {
             if (_size()==0)
                 throw empty_container_error();
+            // move the element out before it is destroyed
+            T elem( std::move(_getData()[_size()-1]) );
             _virtAlloc(_size()-1);
-            return _getData()[_size()];
+            return elem;
         }
 
         void pop_range(size_type amount)
@@ -61,12 +70,16 @@ namespace rtypes
         { return _size(); }
         size_type capacity() const
         { return _allocationSize(); }
+
+        using rallocatorEx<T,Alloc>::get_allocator;
     protected:
-        using rallocatorEx<T>::_allocationSize;
-        using rallocatorEx<T>::_size;
-        using rallocatorEx<T>::_virtAlloc;
-        using rallocatorEx<T>::_getData;
-        using rallocatorEx<T>::_dealloc;
+        using rallocatorEx<T,Alloc>::_allocationSize;
+        using rallocatorEx<T,Alloc>::_size;
+        using rallocatorEx<T,Alloc>::_virtAlloc;
+        using rallocatorEx<T,Alloc>::_virtPush;
+        using rallocatorEx<T,Alloc>::_virtEmplace;
+        using rallocatorEx<T,Alloc>::_getData;
+        using rallocatorEx<T,Alloc>::_dealloc;
     };
 }
 
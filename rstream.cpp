@@ -2,6 +2,7 @@
 #include "rstream.h"
 #include "rstack.h"
 #include "rstreammanip.h"
+#include "rutility.h" // gets the UTF-8 functions
 using namespace rtypes;
 
 const char rtypes::newline = '\n';
@@ -64,8 +65,11 @@ void stream_buffer::_pushBackOutputString(const char* pcstr)
 }
 void stream_buffer::_pushBackOutputString(const generic_string& s)
 {
-    for (size_type i = 0;i<s.size();i++)
-        _bufOut.push(s[i]);
+    _bufOut.push_range(s.c_str(),s.size());
+}
+void stream_buffer::_pushBackOutputString(const char* pchars,size_type length)
+{
+    _bufOut.push_range(pchars,length);
 }
 
 stream_base::stream_base()
@@ -218,6 +222,12 @@ bool rstream::delimit_whitespace(bool yes)
     _delimitWhitespace = yes;
     return b;
 }
+bool rstream::filter_utf8(bool yes)
+{
+    bool b = _filterUtf8;
+    _filterUtf8 = yes;
+    return b;
+}
 uint16 rstream::width(uint16 wide)
 {
     uint16 tmp = _width;
@@ -244,32 +254,30 @@ numeric_representation rstream::representation(numeric_representation rep)
 }
 void rstream::getline(generic_string& var)
 {
-    var.clear();
-    char input;
-    while (true)
-    {
-        if ( !_popInput(input) )
-        {
-            set_input_success(var.length() > 0);
-            return;
-        }
-        else if (input == '\n')
-        {
-            set_input_success(true);
-            return;
-        }
-        //else if (input=='\r') // newline encoding is not supposed to use this with stream buffer data
-        //      continue;
-        var.push_back(input);
-    }
+    _getLine(var);
+    if (_filterUtf8)
+        rutil_utf8_repair_ref(var);
+}
+void rstream::getline(generic_wstring& var)
+{
+    str line;
+    _getLine(line);
+    var = rutil_utf8_to_wstr(line);
 }
 void rstream::putline(const generic_string& text)
 {
-    _pushBackOutputString(text);
+    _pushBackText(text.c_str(),text.length());
     _pushBackOutput('\n'); //add a newline
     if ( !does_buffer_output() )
         _outDevice();
 }
+void rstream::putline(const generic_wstring& text)
+{
+    _pushBackOutputString( rutil_wstr_to_utf8(text) );
+    _pushBackOutput('\n');
+    if ( !does_buffer_output() )
+        _outDevice();
+}
 rstream& rstream::operator >>(bool& var)
 {
     str s;
@@ -591,22 +599,16 @@ rstream& rstream::operator >>(void*& var)
 }
 rstream& rstream::operator >>(generic_string& var)
 {
-    var.clear(); // overwrite var
-    char input;
-    while (true)
-    {
-        if (!_popInput(input))
-            break;
-        else if (_isWhitespace(input))
-        {
-            if (var.size()>0)
-                break;
-            else
-                continue;
-        }
-        var.push_back(input);
-    }
-    set_input_success(var.size() > 0); // success if any characters were read
+    _getToken(var,_filterUtf8);
+    if (_filterUtf8)
+        rutil_utf8_repair_ref(var);
+    return *this;
+}
+rstream& rstream::operator >>(generic_wstring& var)
+{
+    str token;
+    _getToken(token,true);
+    var = rutil_utf8_to_wstr(token);
     return *this;
 }
 rstream& rstream::operator <<(bool b)
@@ -787,14 +789,37 @@ rstream& rstream::operator <<(const void* p)
 }
 rstream& rstream::operator <<(const char* cs)
 {
-    _pushBackOutputString(cs);
+    string_ref s(cs);
+    _pushBackText(s.data(),s.size());
     if ( !does_buffer_output() )
         _outDevice();
     return *this;
 }
 rstream& rstream::operator <<(const generic_string& s)
 {
-    _pushBackOutputString(s);
+    _pushBackText(s.c_str(),s.length());
+    if ( !does_buffer_output() )
+        _outDevice();
+    return *this;
+}
+rstream& rstream::operator <<(const string_ref& s)
+{
+    _pushBackText(s.data(),s.size());
+    if ( !does_buffer_output() )
+        _outDevice();
+    return *this;
+}
+rstream& rstream::operator <<(const wchar_t* ws)
+{
+    return *this << wstring_ref(ws);
+}
+rstream& rstream::operator <<(const generic_wstring& ws)
+{
+    return *this << wstring_ref(ws);
+}
+rstream& rstream::operator <<(const wstring_ref& ws)
+{
+    _pushBackOutputString( rutil_wstr_to_utf8(ws) );
     if ( !does_buffer_output() )
         _outDevice();
     return *this;
@@ -818,10 +843,12 @@ void rstream::_init()
     _fill = ' ';
     _repFlag = decimal;
     _delimitWhitespace = true;
+    _filterUtf8 = false;
 }
-bool rstream::_isWhitespace(char c)
+bool rstream::_isWhitespace(char c,bool utf8)
 {
-    if ( (_delimitWhitespace && (c==' ' || c=='\n' || c=='\t')) || c<=0 /* fail state for text streams (at end of stream) */ || _delimits.contains(c) )
+    // (UTF-8 text uses the bytes above 0x7f, which are negative chars)
+    if ( (_delimitWhitespace && (c==' ' || c=='\n' || c=='\t')) || (utf8 ? c==0 : c<=0) /* fail state for text streams (at end of stream) */ || _delimits.contains(c) )
     {
         _delimStrActive.push_back(c);
         return true;
@@ -833,6 +860,55 @@ bool rstream::_isWhitespace(char c)
     }
     return false;
 }
+void rstream::_getLine(generic_string& var)
+{
+    var.clear();
+    char input;
+    while (true)
+    {
+        if ( !_popInput(input) )
+        {
+            set_input_success(var.length() > 0);
+            return;
+        }
+        else if (input == '\n')
+        {
+            set_input_success(true);
+            return;
+        }
+        //else if (input=='\r') // newline encoding is not supposed to use this with stream buffer data
+        //      continue;
+        var.push_back(input);
+    }
+}
+void rstream::_getToken(generic_string& var,bool utf8)
+{
+    var.clear(); // overwrite var
+    char input;
+    while (true)
+    {
+        if (!_popInput(input))
+            break;
+        else if (_isWhitespace(input,utf8))
+        {
+            if (var.size()>0)
+                break;
+            else
+                continue;
+        }
+        var.push_back(input);
+    }
+    set_input_success(var.size() > 0); // success if any characters were read
+}
+void rstream::_pushBackText(const char* text,size_type length)
+{
+    // in UTF-8 mode only text that needs repair is copied
+    string_ref s(text,length);
+    if (_filterUtf8 && !rutil_utf8_validate(s))
+        _pushBackOutputString( rutil_utf8_repair(s) );
+    else
+        _pushBackOutputString(text,length);
+}
 template<class Numeric>
 void rstream::_pushBackNumeric(Numeric n,bool isNeg,const char* prefix)
 {
@@ -1326,6 +1402,15 @@ rbinstream& rbinstream::operator <<(const generic_string& s)
         _outDevice();
     return *this;
 }
+rbinstream& rbinstream::operator <<(const string_ref& s)
+{
+    _pushBackOutputString(s.data(),s.size());
+    if (_stringInputFormat == binary_string_null_terminated)
+        _pushBackOutput(0);
+    if ( !does_buffer_output() )
+        _outDevice();
+    return *this;
+}
 rbinstream& rbinstream::operator <<(endianness flag)
 {
     _endianFlag = flag;
@@ -60,6 +60,7 @@ namespace rtypes
          */
         void _pushBackOutputString(const char*);
         void _pushBackOutputString(const generic_string&);
+        void _pushBackOutputString(const char*,size_type length);
 
         /* _inDevice() const
          * This member function controls how input is read into the stream from the device;
@@ -201,6 +202,16 @@ namespace rtypes
         str get_active_delimited_space() const
         { return _delimStrActive; }
 
+        /* UTF-8 text mode
+         *  when on, strings read from the stream keep their non-ASCII bytes
+         * (which otherwise delimit) and strings read from or written to the
+         * stream have each ill-formed UTF-8 sequence replaced by U+FFFD; wide
+         * strings are transcoded to and from UTF-8 in either mode
+         */
+        bool filter_utf8(bool yes);
+        bool does_filter_utf8() const
+        { return _filterUtf8; }
+
         // stream manipulation
         uint16 width() const
         { return _width; }
@@ -217,8 +228,10 @@ namespace rtypes
 
         // get string delimited by endline (does not include endline character(s))
         void getline(generic_string&);
+        void getline(generic_wstring&);
         // put string followed by endline
         void putline(const generic_string&);
+        void putline(const generic_wstring&);
 
         // input operator overloads for basic types
         rstream& operator >>(bool&);
@@ -236,6 +249,7 @@ namespace rtypes
         rstream& operator >>(double&);
         rstream& operator >>(void*&);
         rstream& operator >>(generic_string&);
+        rstream& operator >>(generic_wstring&);
 
         // output operator overloads for basic types
         rstream& operator <<(bool);
@@ -254,11 +268,16 @@ namespace rtypes
         rstream& operator <<(const void*);
         rstream& operator <<(const char*);
         rstream& operator <<(const generic_string&);
+        rstream& operator <<(const string_ref&);
+        rstream& operator <<(const wchar_t*);
+        rstream& operator <<(const generic_wstring&);
+        rstream& operator <<(const wstring_ref&);
         rstream& operator <<(numeric_representation);
         rstream& operator <<(const rstream_manipulator&);
     private:
         bool _delimitWhitespace; // determines if whitespace is used as a delimiter
-        set<char> _delimits; // active delimiters not including whitespace
+        bool _filterUtf8; // determines if text is treated as UTF-8
+        hash_set<char> _delimits; // active delimiters not including whitespace
         mutable str _delimStrActive, _delimStrLast;
 
         // manipulator fields
@@ -268,7 +287,10 @@ namespace rtypes
         numeric_representation _repFlag;
 
         void _init();
-        bool _isWhitespace(char);
+        bool _isWhitespace(char,bool utf8 = false);
+        void _getLine(generic_string&);
+        void _getToken(generic_string&,bool utf8);
+        void _pushBackText(const char*,size_type length);
 
         template<typename Numeric>
         void _pushBackNumeric(Numeric,bool,const char* prefix = NULL);
@@ -344,6 +366,7 @@ namespace rtypes
         rbinstream& operator <<(const void*);
         rbinstream& operator <<(const char*);
         rbinstream& operator <<(const generic_string&);
+        rbinstream& operator <<(const string_ref&);
         rbinstream& operator <<(endianness);
         rbinstream& operator <<(binary_string_input_format);
     private:
@@ -2,24 +2,53 @@
 #ifndef RSTRING_H
 #define RSTRING_H
 #include "rtypestypes.h"
+#include "rallocator.h" // get default_allocator
+#include <atomic>
 
 #define RSTRING_DEFAULT_ALLOCATION 16
+#define RSTRING_INLINE_BYTES 24 // storage for short deep strings kept inside the object
 
 namespace rtypes
 {
+    template<typename CharType>
+    class basic_string_ref;
+
+    // search kernels for the string find members; each returns a pointer to
+    // the match within the 'n' characters at 'p' or NULL if there is none; the
+    // templates compare one character at a time while the overloads for char
+    // (in rstringsearch.cpp) scan with vector instructions where available
+    template<typename CharType>
+    const CharType* _rstring_find(const CharType* p,size_type n,CharType c);
+    template<typename CharType>
+    const CharType* _rstring_rfind(const CharType* p,size_type n,CharType c);
+    template<typename CharType>
+    const CharType* _rstring_find(const CharType* p,size_type n,const CharType* s,size_type m);
+    template<typename CharType>
+    const CharType* _rstring_find_first_of(const CharType* p,size_type n,const CharType* set,size_type m);
+    const char* _rstring_find(const char* p,size_type n,char c);
+    const char* _rstring_rfind(const char* p,size_type n,char c);
+    const char* _rstring_find(const char* p,size_type n,const char* s,size_type m);
+    const char* _rstring_find_first_of(const char* p,size_type n,const char* set,size_type m);
+
     /* rtype_string
-     *  provides abstract interface and implementation for rlibrary strings
+     *  provides abstract interface and implementation for rlibrary strings; a
+     * derived string whose buffer is never shared marks itself exclusive, and
+     * then element access and appends that fit the spare capacity write the
+     * buffer directly instead of calling the virtual interface, so that per-
+     * character loops over a generic_string& can be inlined
      */
     template<typename CharType>
     class rtype_string
     {
     public:
+        static const size_type npos = ~size_type(0); // (returned when find fails)
+
         rtype_string();
         virtual ~rtype_string();
 
         // unchecked access
         CharType& operator [](size_type index)
-        { return _access(index); }
+        { return _exclusive ? _buffer->data[index] : _access(index); }
         const CharType& operator [](size_type index) const
         { return _buffer->data[index]; }
 
@@ -34,12 +63,28 @@ namespace rtypes
         rtype_string& operator +=(CharType);
         rtype_string& operator +=(const CharType* cStr);
         rtype_string& operator +=(const rtype_string&);
+        rtype_string& operator =(const basic_string_ref<CharType>&);
+        rtype_string& operator +=(const basic_string_ref<CharType>&);
 
         // operations
-        void append(CharType);
+        void append(CharType c)
+        { push_back(c); }
         void append(const CharType*);
         void append(const rtype_string&);
-        void push_back(CharType);
+        void append(const basic_string_ref<CharType>&);
+        void push_back(CharType c)
+        {
+            if (_exclusive && _buffer->extra>0)
+            {
+                // the old null terminator is overwritten
+                _buffer->data[_buffer->size-1] = c;
+                _buffer->data[_buffer->size] = 0;
+                ++_buffer->size;
+                --_buffer->extra;
+            }
+            else
+                _pushBack(c);
+        }
         void clear(); // reduce the logical allocation size
         void reset(); // reduce the actual allocation size
         bool truncate(size_type desiredSize);
@@ -56,6 +101,22 @@ namespace rtypes
         { return _buffer->size+_buffer->extra-1; }
         size_type allocation_size() const
         { return _buffer->size+_buffer->extra; }
+
+        // searching (see basic_string_ref)
+        size_type find(CharType c,size_type start = 0) const
+        { return basic_string_ref<CharType>(*this).find(c,start); }
+        size_type find(const basic_string_ref<CharType>& s,size_type start = 0) const
+        { return basic_string_ref<CharType>(*this).find(s,start); }
+        size_type rfind(CharType c,size_type start = npos) const
+        { return basic_string_ref<CharType>(*this).rfind(c,start); }
+        size_type rfind(const basic_string_ref<CharType>& s,size_type start = npos) const
+        { return basic_string_ref<CharType>(*this).rfind(s,start); }
+        size_type find_first_of(const basic_string_ref<CharType>& set,size_type start = 0) const
+        { return basic_string_ref<CharType>(*this).find_first_of(set,start); }
+        bool contains(CharType c) const
+        { return find(c) != npos; }
+        bool contains(const basic_string_ref<CharType>& s) const
+        { return find(s) != npos; }
     protected:
         struct _StringBuffer
         {
@@ -68,6 +129,10 @@ namespace rtypes
 
             void allocate(size_type desiredSize);
             void deallocate();
+            template<class Alloc>
+            void allocate(size_type desiredSize,Alloc& allocator);
+            template<class Alloc>
+            void deallocate(Alloc& allocator);
         private:
             // disallow copying
             _StringBuffer(const _StringBuffer&);
@@ -77,6 +142,8 @@ namespace rtypes
         // string buffer
         _StringBuffer* _buffer;
 
+        explicit rtype_string(bool exclusive); // 'exclusive' if the buffer is never shared
+
         // virtual string interface
         virtual void _allocate(size_type desiredSize) = 0;
         virtual void _deallocate() = 0;
@@ -86,9 +153,88 @@ namespace rtypes
         void _copy(const CharType*);
         void _copy(const CharType*,size_type);
         void _nullTerm();
+        void _pushBack(CharType);
 
         static const _StringBuffer* _getBuffer(const rtype_string& object)
         { return object._buffer; }
+    private:
+        bool _exclusive;
+    };
+
+    /* basic_string_ref
+     *  refers to a sequence of characters that it does not own (a pointer and a
+     * length); the characters need not be null-terminated and must outlive the
+     * reference; any rlibrary string or C-string converts to a reference, so a
+     * function that only reads its argument can take a reference and be passed
+     * a substring without copying it into a temporary string
+     */
+    template<typename CharType>
+    class basic_string_ref
+    {
+    public:
+        static const size_type npos = ~size_type(0); // (returned when find fails)
+
+        basic_string_ref()
+            : _data(NULL), _size(0) {}
+        basic_string_ref(const CharType* cStr); // (scans for the null terminator once)
+        basic_string_ref(const CharType* pdata,size_type len)
+            : _data(pdata), _size(len) {}
+        basic_string_ref(const rtype_string<CharType>& s)
+            : _data(s.c_str()), _size(s.size()) {}
+
+        const CharType& operator [](size_type index) const
+        { return _data[index]; }
+
+        const CharType* data() const
+        { return _data; }
+        size_type size() const
+        { return _size; }
+        size_type length() const
+        { return _size; }
+        bool is_empty() const
+        { return _size == 0; }
+
+        /* substr( start, len )
+         *  returns a reference to at most 'len' characters starting at
+         *  'start'; the result is empty if 'start' is past the end
+         */
+        basic_string_ref substr(size_type start,size_type len = npos) const;
+
+        // these return the index of the first (or last) match at or
+        // after (or before) 'start', or npos if there is no match
+        size_type find(CharType c,size_type start = 0) const;
+        size_type find(const basic_string_ref& s,size_type start = 0) const;
+        size_type rfind(CharType c,size_type start = npos) const;
+        size_type rfind(const basic_string_ref& s,size_type start = npos) const;
+        // returns the index of the first character at or after
+        // 'start' that is one of the characters in 'set'
+        size_type find_first_of(const basic_string_ref& set,size_type start = 0) const;
+        bool contains(CharType c) const
+        { return find(c) != npos; }
+        bool contains(const basic_string_ref& s) const
+        { return find(s) != npos; }
+
+        // returns a value less than, equal to or greater than zero as the
+        // referenced characters order before, with or after those of 's'
+        int compare(const basic_string_ref& s) const;
+
+        // (found by argument-dependent lookup, so either side may be a
+        // string or C-string that converts to a reference)
+        friend bool operator ==(const basic_string_ref& left,const basic_string_ref& right)
+        { return left._size==right._size && left.compare(right)==0; }
+        friend bool operator !=(const basic_string_ref& left,const basic_string_ref& right)
+        { return !(left == right); }
+        friend bool operator <(const basic_string_ref& left,const basic_string_ref& right)
+        { return left.compare(right) < 0; }
+        friend bool operator >(const basic_string_ref& left,const basic_string_ref& right)
+        { return left.compare(right) > 0; }
+        friend bool operator <=(const basic_string_ref& left,const basic_string_ref& right)
+        { return left.compare(right) <= 0; }
+        friend bool operator >=(const basic_string_ref& left,const basic_string_ref& right)
+        { return left.compare(right) >= 0; }
+    private:
+        const CharType* _data;
+        size_type _size;
     };
 
     /* deep_string
@@ -97,38 +243,63 @@ namespace rtypes
      * these strings typically are more efficient and use less memory than their shallow string
      * counterparts; deep strings are used exclusively in the implementation of rlibrary, however
      * base class (rtype_string) references are used in read expressions (e.g. function parameters)
-     * to maintain compatibility with shallow string types
+     * to maintain compatibility with shallow string types; a short string (one whose
+     * characters and null terminator fit in RSTRING_INLINE_BYTES) is stored inside the
+     * object itself and a longer string buffer is obtained from the allocator policy 'Alloc'
      */
-    template<typename CharType>
-    class deep_string : public rtype_string<CharType>
+    template<typename CharType,class Alloc = default_allocator>
+    class deep_string : public rtype_string<CharType>,
+                        private Alloc
     {
         typedef rtype_string<CharType> _Base;
     public:
         deep_string();
-        deep_string(const CharType*);
-        explicit deep_string(const _Base&);
+        explicit deep_string(const Alloc& allocator);
+        deep_string(const CharType*,const Alloc& allocator = Alloc());
+        explicit deep_string(const _Base&,const Alloc& allocator = Alloc());
+        explicit deep_string(const basic_string_ref<CharType>&,const Alloc& allocator = Alloc());
         deep_string(const deep_string&);
-        explicit deep_string(size_type allocSize);
+        deep_string(deep_string&&); // takes a heap buffer; a short string is copied
+        explicit deep_string(size_type allocSize,const Alloc& allocator = Alloc());
+        ~deep_string();
 
         // these simply invoke the base class versions
         deep_string& operator =(CharType);
         deep_string& operator =(const CharType*);
         deep_string& operator =(const _Base&);
         deep_string& operator =(const deep_string&); // must overload for derived class type
+        deep_string& operator =(deep_string&&);
         deep_string& operator +=(CharType);
         deep_string& operator +=(const CharType* cStr);
         deep_string& operator +=(const _Base&);
         deep_string& operator +=(const deep_string&); // must overload for derived class type
+        deep_string& operator =(const basic_string_ref<CharType>&);
+        deep_string& operator +=(const basic_string_ref<CharType>&);
+
+        Alloc get_allocator() const
+        { return *this; }
     protected:
         using _Base::_buffer;
         using _Base::_copy;
         using _Base::_nullTerm;
         using _Base::_getBuffer;
     private:
+        // number of characters (including the null terminator) stored inline
+        static const size_type _INLINE_SIZE = RSTRING_INLINE_BYTES/sizeof(CharType) > 0
+            ? RSTRING_INLINE_BYTES/sizeof(CharType) : 1;
+
         virtual void _allocate(size_type desiredSize);
         virtual void _deallocate();
 
+        Alloc& _allocator()
+        { return *this; }
+        bool _isInline() const
+        { return _buf.data == _inline; }
+        void _setInline(); // points the (empty) buffer at the inline storage
+        void _take(deep_string& obj); // takes the heap buffer of 'obj' (which becomes an empty string)
+
         typename _Base::_StringBuffer _buf;
+        CharType _inline[_INLINE_SIZE];
     };
 
     /* shallow_string
@@ -136,7 +307,11 @@ namespace rtypes
      * and a deep copy on write (copy on write); this string type is available
      * for use in cases where default reference semantics are required/desired;
      * rlibrary does not typically provide such strings in its public interface
-     * or implementation
+     * or implementation; the reference count is atomic, so distinct strings
+     * that share a buffer may be used from different threads (a single string
+     * object still may not be modified by one thread while another uses it);
+     * a buffer whose count is one belongs to the calling string alone, so
+     * writes to it skip the atomic operations
      */
     template<typename CharType>
     class shallow_string : public rtype_string<CharType>
@@ -146,6 +321,7 @@ namespace rtypes
         shallow_string();
         shallow_string(const CharType*);
         explicit shallow_string(const _Base&);
+        explicit shallow_string(const basic_string_ref<CharType>&);
         shallow_string(const shallow_string&);
         explicit shallow_string(size_type allocSize);
         ~shallow_string();
@@ -161,6 +337,8 @@ namespace rtypes
         shallow_string& operator +=(const CharType* cStr);
         shallow_string& operator +=(const _Base&);
         shallow_string& operator +=(const shallow_string&); // must overload for derived class type
+        shallow_string& operator =(const basic_string_ref<CharType>&);
+        shallow_string& operator +=(const basic_string_ref<CharType>&);
     protected:
         using _Base::_buffer;
         using _Base::_copy;
@@ -171,9 +349,16 @@ namespace rtypes
         {
             _StringBufferEx();
 
-            int reference;
+            std::atomic<int> reference;
         };
 
+        bool _isShared() const
+        { return static_cast<_StringBufferEx*>(_buffer)->reference.load(std::memory_order_acquire) > 1; }
+        void _addRef()
+        { static_cast<_StringBufferEx*>(_buffer)->reference.fetch_add(1,std::memory_order_relaxed); }
+        static void _release(typename _Base::_StringBuffer* buffer); // drops a reference to 'buffer'
+        void _detach(size_type desiredSize); // copies the shared buffer into a new buffer
+
         virtual void _allocate(size_type desiredSize);
         virtual void _deallocate();
         virtual CharType& _access(size_type);
@@ -237,6 +422,8 @@ namespace rtypes
     typedef deep_string<wchar_t> wstr;
     typedef str string; // alternates for original standard string types
     typedef wstr wstring;
+    typedef basic_string_ref<char> string_ref; // non-owning references to characters
+    typedef basic_string_ref<wchar_t> wstring_ref;
 
 }
 
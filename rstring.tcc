@@ -2,9 +2,18 @@
 
 // rtypes::rtype_string<>
 template<typename CharType>
+const rtypes::size_type rtypes::rtype_string<CharType>::npos;
+template<typename CharType>
 rtypes::rtype_string<CharType>::rtype_string()
 {
     _buffer = NULL;
+    _exclusive = false;
+}
+template<typename CharType>
+rtypes::rtype_string<CharType>::rtype_string(bool exclusive)
+{
+    _buffer = NULL;
+    _exclusive = exclusive;
 }
 template<typename CharType>
 rtypes::rtype_string<CharType>::~rtype_string()
@@ -15,7 +24,7 @@ template<typename CharType>
 CharType& rtypes::rtype_string<CharType>::at(size_type index)
 {
     if (index <= _buffer->size)
-        return _access(index);
+        return operator [](index);
     throw 1;
 }
 template<typename CharType>
@@ -55,55 +64,70 @@ rtypes::rtype_string<CharType>& rtypes::rtype_string<CharType>::operator +=(Char
 template<typename CharType>
 rtypes::rtype_string<CharType>& rtypes::rtype_string<CharType>::operator +=(const CharType* pcstr)
 {
-    size_type len = 0, lastSize = size();
-    while (pcstr[len])
-        ++len;
-    _allocate(lastSize + ++len); // add 1 to len to account for the null-terminator
-    for (size_type i = 0;i<len;i++) // the terminator will be copied in from pcstr
-        _buffer->data[i+lastSize] = pcstr[i];
-    _nullTerm();
+    append( basic_string_ref<CharType>(pcstr) );
     return *this;
 }
 template<typename CharType>
 rtypes::rtype_string<CharType>& rtypes::rtype_string<CharType>::operator +=(const rtype_string<CharType>& obj)
 {
-    size_type lastSz = size();
-    _allocate(lastSz+obj._buffer->size);
-    for (size_type i = 0;i<obj._buffer->size;i++)
-        _buffer->data[i+lastSz] = obj[i];
-    _nullTerm();
+    append( basic_string_ref<CharType>(obj) );
     return *this;
 }
 template<typename CharType>
-void rtypes::rtype_string<CharType>::append(CharType t)
+rtypes::rtype_string<CharType>& rtypes::rtype_string<CharType>::operator =(const basic_string_ref<CharType>& s)
 {
-    // (a push_back synonym)
-    _allocate(_buffer->size+1);
-    _buffer->data[_buffer->size-2] = t;
+    // a reference into this string's own buffer is never longer than the
+    // string, so the buffer only shrinks and the forward copy is safe
+    const CharType* pchars = s.data();
+    size_type len = s.size();
+    _allocate(len+1);
+    rutil_memmove(_buffer->data,pchars,len*sizeof(CharType));
     _nullTerm();
+    return *this;
+}
+template<typename CharType>
+rtypes::rtype_string<CharType>& rtypes::rtype_string<CharType>::operator +=(const basic_string_ref<CharType>& s)
+{
+    append(s);
+    return *this;
 }
 template<typename CharType>
 void rtypes::rtype_string<CharType>::append(const CharType* pcstr)
 {
-    size_type len = 0, lastSize = size();
-    while (pcstr[len])
-        ++len;
-    _allocate(_buffer->size+len);
-    for (size_type i = 0;i<len;i++)
-        _buffer->data[i+lastSize] = pcstr[i];
-    _nullTerm();
+    append( basic_string_ref<CharType>(pcstr) );
 }
 template<typename CharType>
 void rtypes::rtype_string<CharType>::append(const rtype_string& obj)
 {
-    size_type lastSz = _buffer->size;
-    _allocate(_buffer->size+obj._buffer->size);
-    for (size_type i = 0;i<obj._buffer->size;i++)
-        _buffer->data[i+lastSz] = obj[i];
+    append( basic_string_ref<CharType>(obj) );
+}
+template<typename CharType>
+void rtypes::rtype_string<CharType>::append(const basic_string_ref<CharType>& s)
+{
+    const CharType* pchars = s.data();
+    size_type len = s.size(), lastSz = size();
+    if (_exclusive && _buffer->extra>=len)
+    {
+        // the characters fit the spare capacity, so the buffer stays put (and
+        // characters from this string lie before the ones being written)
+        rutil_memcpy(_buffer->data+lastSz,pchars,len*sizeof(CharType));
+        _buffer->size += len;
+        _buffer->extra -= len;
+        _nullTerm();
+        return;
+    }
+    // the characters may lie in this string's own buffer, which
+    // could move when it grows
+    bool self = pchars>=_buffer->data && pchars<_buffer->data+_buffer->size;
+    size_type offset = (self ? size_type(pchars-_buffer->data) : 0);
+    _allocate(lastSz+len+1);
+    if (self)
+        pchars = _buffer->data+offset;
+    rutil_memcpy(_buffer->data+lastSz,pchars,len*sizeof(CharType));
     _nullTerm();
 }
 template<typename CharType>
-void rtypes::rtype_string<CharType>::push_back(CharType t)
+void rtypes::rtype_string<CharType>::_pushBack(CharType t)
 {
     _allocate(_buffer->size+1);
     _buffer->data[_buffer->size-2] = t;
@@ -136,7 +160,7 @@ bool rtypes::rtype_string<CharType>::truncate(size_type desiredSize)
 template<typename CharType>
 void rtypes::rtype_string<CharType>::resize(size_type newSize)
 {
-    if (newSize != _buffer->size)
+    if (newSize+1 != _buffer->size) // (the size counts the null terminator)
     {
         _allocate(newSize+1);
         _nullTerm();
@@ -156,8 +180,7 @@ template<typename CharType>
 void rtypes::rtype_string<CharType>::_copy(const CharType* pcstr,size_type len)
 {
     _allocate(len);
-    for (size_type i = 0;i<len;i++)
-        _buffer->data[i] = pcstr[i];
+    rutil_memmove(_buffer->data,pcstr,len*sizeof(CharType));
 }
 template<typename CharType>
 void rtypes::rtype_string<CharType>::_nullTerm()
@@ -176,11 +199,26 @@ rtypes::rtype_string<CharType>::_StringBuffer::_StringBuffer()
 template<typename CharType>
 rtypes::rtype_string<CharType>::_StringBuffer::~_StringBuffer()
 {
-    if (data != NULL)
-        delete[] data;
+    // buffers obtained from other allocators are released
+    // by their owners before this point
+    default_allocator allocator;
+    deallocate(allocator);
 }
 template<typename CharType>
 void rtypes::rtype_string<CharType>::_StringBuffer::allocate(size_type desiredSize)
+{
+    default_allocator allocator;
+    allocate(desiredSize,allocator);
+}
+template<typename CharType>
+void rtypes::rtype_string<CharType>::_StringBuffer::deallocate()
+{
+    default_allocator allocator;
+    deallocate(allocator);
+}
+template<typename CharType>
+template<class Alloc>
+void rtypes::rtype_string<CharType>::_StringBuffer::allocate(size_type desiredSize,Alloc& allocator)
 {
     if (desiredSize > size)
     {
@@ -202,14 +240,13 @@ void rtypes::rtype_string<CharType>::_StringBuffer::allocate(size_type desiredSi
             if (newSize < desiredSize)
                 newSize = desiredSize;
             // create new buffer
-            CharType* newData = new CharType[newSize];
+            CharType* newData = static_cast<CharType*>( allocator.allocate(newSize*sizeof(CharType)) );
             if (data != NULL)
             {
                 // copy old data
-                for (size_type i = 0;i<size;i++)
-                    newData[i] = data[i];
+                rutil_memcpy(newData,data,size*sizeof(CharType));
                 // delete old buffer
-                delete[] data;
+                allocator.deallocate(data,allocSize*sizeof(CharType));
             }
             // assign new; recalculate extra space amount
             data = newData;
@@ -230,129 +267,384 @@ void rtypes::rtype_string<CharType>::_StringBuffer::allocate(size_type desiredSi
     // else equal, no action
 }
 template<typename CharType>
-void rtypes::rtype_string<CharType>::_StringBuffer::deallocate()
+template<class Alloc>
+void rtypes::rtype_string<CharType>::_StringBuffer::deallocate(Alloc& allocator)
 {
     if (data != NULL)
     {
-        delete[] data;
+        allocator.deallocate(data,(size+extra)*sizeof(CharType));
         data = NULL;
         size = 0;
         extra = 0;
     }
 }
 
-// rtypes::deep_string<>
+// rtypes::_rstring_find<> (and related search kernels)
+template<typename CharType>
+const CharType* rtypes::_rstring_find(const CharType* p,size_type n,CharType c)
+{
+    for (size_type i = 0;i<n;i++)
+        if (p[i] == c)
+            return p+i;
+    return NULL;
+}
 template<typename CharType>
-rtypes::deep_string<CharType>::deep_string()
+const CharType* rtypes::_rstring_rfind(const CharType* p,size_type n,CharType c)
+{
+    while (n > 0)
+        if (p[--n] == c)
+            return p+n;
+    return NULL;
+}
+template<typename CharType>
+const CharType* rtypes::_rstring_find(const CharType* p,size_type n,const CharType* s,size_type m)
+{
+    if (m > n)
+        return NULL;
+    // compare at each position where the first character matches
+    for (size_type i = 0;i<=n-m;i++)
+    {
+        size_type j = 0;
+        while (j<m && p[i+j]==s[j])
+            ++j;
+        if (j == m)
+            return p+i;
+    }
+    return NULL;
+}
+template<typename CharType>
+const CharType* rtypes::_rstring_find_first_of(const CharType* p,size_type n,const CharType* set,size_type m)
+{
+    for (size_type i = 0;i<n;i++)
+        for (size_type j = 0;j<m;j++)
+            if (p[i] == set[j])
+                return p+i;
+    return NULL;
+}
+
+// rtypes::basic_string_ref<>
+template<typename CharType>
+const rtypes::size_type rtypes::basic_string_ref<CharType>::npos;
+template<typename CharType>
+rtypes::basic_string_ref<CharType>::basic_string_ref(const CharType* cStr)
+    : _data(cStr)
+{
+    _size = 0;
+    while (cStr[_size])
+        ++_size;
+}
+template<typename CharType>
+rtypes::basic_string_ref<CharType> rtypes::basic_string_ref<CharType>::substr(size_type start,size_type len) const
+{
+    if (start >= _size)
+        return basic_string_ref(_data+_size,0);
+    if (len > _size-start)
+        len = _size-start;
+    return basic_string_ref(_data+start,len);
+}
+template<typename CharType>
+rtypes::size_type rtypes::basic_string_ref<CharType>::find(CharType c,size_type start) const
+{
+    if (start >= _size)
+        return npos;
+    const CharType* p = _rstring_find(_data+start,_size-start,c);
+    return (p!=NULL ? size_type(p-_data) : npos);
+}
+template<typename CharType>
+rtypes::size_type rtypes::basic_string_ref<CharType>::find(const basic_string_ref& s,size_type start) const
+{
+    if (start>_size || s._size>_size-start)
+        return npos;
+    const CharType* p = _rstring_find(_data+start,_size-start,s._data,s._size);
+    return (p!=NULL ? size_type(p-_data) : npos);
+}
+template<typename CharType>
+rtypes::size_type rtypes::basic_string_ref<CharType>::rfind(CharType c,size_type start) const
+{
+    const CharType* p = _rstring_rfind(_data,(start<_size ? start+1 : _size),c);
+    return (p!=NULL ? size_type(p-_data) : npos);
+}
+template<typename CharType>
+rtypes::size_type rtypes::basic_string_ref<CharType>::rfind(const basic_string_ref& s,size_type start) const
+{
+    if (s._size > _size)
+        return npos;
+    if (s._size == 0)
+        return (start<_size ? start : _size);
+    // find each earlier occurrence of the first character
+    // and compare the rest of 's' there
+    size_type n = _size-s._size;
+    if (start < n)
+        n = start;
+    ++n;
+    const CharType* p;
+    while ((p = _rstring_rfind(_data,n,s._data[0])) != NULL)
+    {
+        size_type i = size_type(p-_data), j = 1;
+        while (j<s._size && _data[i+j]==s._data[j])
+            ++j;
+        if (j == s._size)
+            return i;
+        n = i;
+    }
+    return npos;
+}
+template<typename CharType>
+rtypes::size_type rtypes::basic_string_ref<CharType>::find_first_of(const basic_string_ref& set,size_type start) const
+{
+    if (start >= _size)
+        return npos;
+    const CharType* p = _rstring_find_first_of(_data+start,_size-start,set._data,set._size);
+    return (p!=NULL ? size_type(p-_data) : npos);
+}
+template<typename CharType>
+int rtypes::basic_string_ref<CharType>::compare(const basic_string_ref& s) const
+{
+    // characters are ordered by value as with the string comparison operators
+    size_type len = (_size<s._size ? _size : s._size);
+    for (size_type i = 0;i<len;i++)
+    {
+        if (_data[i] < s._data[i])
+            return -1;
+        if (_data[i] > s._data[i])
+            return 1;
+    }
+    return (_size<s._size ? -1 : (_size>s._size ? 1 : 0));
+}
+
+// rtypes::deep_string<>
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>::deep_string()
+    : _Base(true)
 {
     // use statically-allocated buffer
     _buffer = &_buf;
+    _setInline();
     // allocate null string
-    _buf.allocate(1);
+    _allocate(1);
     _nullTerm();
 }
-template<typename CharType>
-rtypes::deep_string<CharType>::deep_string(const CharType* pcstr)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>::deep_string(const Alloc& allocator)
+    : _Base(true), Alloc(allocator)
+{
+    // use statically-allocated buffer
+    _buffer = &_buf;
+    _setInline();
+    // allocate null string
+    _allocate(1);
+    _nullTerm();
+}
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>::deep_string(const CharType* pcstr,const Alloc& allocator)
+    : _Base(true), Alloc(allocator)
 {
     // use statically-allocated buffer
     _buffer = &_buf;
+    _setInline();
     // copy string (along with null terminator)
     _copy(pcstr);
 }
-template<typename CharType>
-rtypes::deep_string<CharType>::deep_string(const _Base& obj)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>::deep_string(const _Base& obj,const Alloc& allocator)
+    : _Base(true), Alloc(allocator)
 {
     // use statically-allocated buffer
     _buffer = &_buf;
+    _setInline();
     // copy string (along with null terminator)
     const typename _Base::_StringBuffer* pbuf = _getBuffer(obj);
     _copy(pbuf->data,pbuf->size);
 }
-template<typename CharType>
-rtypes::deep_string<CharType>::deep_string(const deep_string& obj)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>::deep_string(const basic_string_ref<CharType>& s,const Alloc& allocator)
+    : _Base(true), Alloc(allocator)
 {
     // use statically-allocated buffer
     _buffer = &_buf;
+    _setInline();
+    // copy the characters and add a null terminator
+    static_cast<_Base*>(this)->operator =(s);
+}
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>::deep_string(const deep_string& obj)
+    : _Base(true), Alloc(obj)
+{
+    // use statically-allocated buffer
+    _buffer = &_buf;
+    _setInline();
     // copy string (along with null terminator)
     _copy(obj._buf.data,obj._buf.size);
 }
-template<typename CharType>
-rtypes::deep_string<CharType>::deep_string(size_type allocSize)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>::deep_string(deep_string&& obj)
+    : _Base(true), Alloc(obj)
+{
+    // use statically-allocated buffer
+    _buffer = &_buf;
+    _setInline();
+    if ( obj._isInline() )
+        _copy(obj._buf.data,obj._buf.size);
+    else
+        _take(obj);
+}
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>::deep_string(size_type allocSize,const Alloc& allocator)
+    : _Base(true), Alloc(allocator)
 {
     // use statically-allocated buffer
     _buffer = &_buf;
+    _setInline();
     // get as close to the specified allocation size as possible,
     // accounting for the null terminator automatically
-    _buf.data = new CharType[++allocSize];
+    if (++allocSize > _INLINE_SIZE)
+    {
+        _buf.data = static_cast<CharType*>( _allocator().allocate(allocSize*sizeof(CharType)) );
+        _buf.extra = 0;
+    }
+    else
+        _buf.extra = _INLINE_SIZE-allocSize;
     _buf.size = allocSize;
-    _buf.extra = 0;
     _nullTerm();
 }
-template<typename CharType>
-rtypes::deep_string<CharType>& rtypes::deep_string<CharType>::operator =(CharType c)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>::~deep_string()
+{
+    // return the buffer to the allocator before the
+    // base buffer is destroyed (which must not see
+    // the inline storage)
+    if ( !_isInline() )
+        _buf.deallocate(_allocator());
+    _buf.data = NULL;
+}
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator =(CharType c)
 {
     // just invoke the base-class version
     static_cast<_Base*>(this)->operator =(c);
     return *this;
 }
-template<typename CharType>
-rtypes::deep_string<CharType>& rtypes::deep_string<CharType>::operator =(const CharType* pcstr)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator =(const CharType* pcstr)
 {
     // just invoke the base-class version
     static_cast<_Base*>(this)->operator =(pcstr);
     return *this;
 }
-template<typename CharType>
-rtypes::deep_string<CharType>& rtypes::deep_string<CharType>::operator =(const _Base& obj)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator =(const _Base& obj)
 {
     // just invoke the base-class version
     static_cast<_Base*>(this)->operator =(obj);
     return *this;
 }
-template<typename CharType>
-rtypes::deep_string<CharType>& rtypes::deep_string<CharType>::operator =(const deep_string& obj)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator =(const deep_string& obj)
 {
     // just invoke the base-class version
     static_cast<_Base*>(this)->operator =(obj);
     return *this;
 }
-template<typename CharType>
-rtypes::deep_string<CharType>& rtypes::deep_string<CharType>::operator +=(CharType c)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator =(deep_string&& obj)
+{
+    if (this != &obj)
+    {
+        if ( obj._isInline() )
+            static_cast<_Base*>(this)->operator =(obj);
+        else
+        {
+            // the heap buffer must be freed by the allocator that produced it
+            _deallocate();
+            _allocator() = obj._allocator();
+            _take(obj);
+        }
+    }
+    return *this;
+}
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator +=(CharType c)
 {
     // just invoke the base-class version
     static_cast<_Base*>(this)->operator +=(c);
     return *this;
 }
-template<typename CharType>
-rtypes::deep_string<CharType>& rtypes::deep_string<CharType>::operator +=(const CharType* pcstr)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator +=(const CharType* pcstr)
 {
     // just invoke the base-class version
     static_cast<_Base*>(this)->operator +=(pcstr);
     return *this;
 }
-template<typename CharType>
-rtypes::deep_string<CharType>& rtypes::deep_string<CharType>::operator +=(const _Base& obj)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator +=(const _Base& obj)
 {
     // just invoke the base-class version
     static_cast<_Base*>(this)->operator +=(obj);
     return *this;
 }
-template<typename CharType>
-rtypes::deep_string<CharType>& rtypes::deep_string<CharType>::operator +=(const deep_string& obj)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator +=(const deep_string& obj)
 {
     // just invoke the base-class version
     static_cast<_Base*>(this)->operator +=(obj);
     return *this;
 }
-template<typename CharType>
-void rtypes::deep_string<CharType>::_allocate(size_type desiredSize)
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator =(const basic_string_ref<CharType>& s)
 {
-    _buf.allocate(desiredSize);
+    // just invoke the base-class version
+    static_cast<_Base*>(this)->operator =(s);
+    return *this;
 }
-template<typename CharType>
-void rtypes::deep_string<CharType>::_deallocate()
+template<typename CharType,class Alloc>
+rtypes::deep_string<CharType,Alloc>& rtypes::deep_string<CharType,Alloc>::operator +=(const basic_string_ref<CharType>& s)
 {
-    _buf.deallocate();
+    // just invoke the base-class version
+    static_cast<_Base*>(this)->operator +=(s);
+    return *this;
+}
+template<typename CharType,class Alloc>
+void rtypes::deep_string<CharType,Alloc>::_allocate(size_type desiredSize)
+{
+    if (_isInline() && desiredSize>_INLINE_SIZE)
+    {
+        // move to the heap; growth continues by doubling from the inline size
+        size_type newSize = _INLINE_SIZE*2;
+        if (newSize < desiredSize)
+            newSize = desiredSize;
+        CharType* newData = static_cast<CharType*>( _allocator().allocate(newSize*sizeof(CharType)) );
+        rutil_memcpy(newData,_inline,_buf.size*sizeof(CharType));
+        _buf.data = newData;
+        _buf.size = desiredSize;
+        _buf.extra = newSize-desiredSize;
+    }
+    else
+        _buf.allocate(desiredSize,_allocator()); // (resizes within the inline storage without allocating)
+}
+template<typename CharType,class Alloc>
+void rtypes::deep_string<CharType,Alloc>::_deallocate()
+{
+    if ( !_isInline() )
+        _buf.deallocate(_allocator());
+    _setInline();
+}
+template<typename CharType,class Alloc>
+void rtypes::deep_string<CharType,Alloc>::_setInline()
+{
+    _buf.data = _inline;
+    _buf.size = 0;
+    _buf.extra = _INLINE_SIZE;
+}
+template<typename CharType,class Alloc>
+void rtypes::deep_string<CharType,Alloc>::_take(deep_string& obj)
+{
+    _buf.data = obj._buf.data;
+    _buf.size = obj._buf.size;
+    _buf.extra = obj._buf.extra;
+    obj._setInline();
+    obj._allocate(1);
+    obj._nullTerm();
 }
 
 // rtypes::shallow_string<>
@@ -383,11 +675,20 @@ rtypes::shallow_string<CharType>::shallow_string(const _Base& obj)
     _copy(pbuf->data,pbuf->size);
 }
 template<typename CharType>
+rtypes::shallow_string<CharType>::shallow_string(const basic_string_ref<CharType>& s)
+{
+    // set up new string buffer
+    _buffer = new _StringBufferEx;
+    // copy the characters and add a null terminator
+    static_cast<_Base*>(this)->operator =(s);
+}
+template<typename CharType>
 rtypes::shallow_string<CharType>::shallow_string(const shallow_string& obj)
+    : _Base()
 {
     // copy a reference to the buffer (shallow copy)
     _buffer = obj._buffer;
-    ++static_cast<_StringBufferEx*>(_buffer)->reference; // increment reference
+    _addRef();
 }
 template<typename CharType>
 rtypes::shallow_string<CharType>::shallow_string(size_type allocSize)
@@ -396,7 +697,7 @@ rtypes::shallow_string<CharType>::shallow_string(size_type allocSize)
     _buffer = new _StringBufferEx;
     // get as close to the specified allocation size as possible,
     // accounting for the null terminator automatically
-    _buffer->data = new CharType[++allocSize];
+    _buffer->data = static_cast<CharType*>( default_allocator().allocate(++allocSize*sizeof(CharType)) );
     _buffer->size = allocSize;
     _buffer->extra = 0;
     _nullTerm();
@@ -404,10 +705,7 @@ rtypes::shallow_string<CharType>::shallow_string(size_type allocSize)
 template<typename CharType>
 rtypes::shallow_string<CharType>::~shallow_string()
 {
-    // delete the buffer if the reference
-    //  is about to be lost
-    if (--static_cast<_StringBufferEx*>(_buffer)->reference == 0)
-        delete _buffer;
+    _release(_buffer);
 }
 template<typename CharType>
 rtypes::shallow_string<CharType>& rtypes::shallow_string<CharType>::operator =(CharType t)
@@ -433,12 +731,12 @@ rtypes::shallow_string<CharType>& rtypes::shallow_string<CharType>::operator =(c
 template<typename CharType>
 rtypes::shallow_string<CharType>& rtypes::shallow_string<CharType>::operator =(const shallow_string& obj)
 {
-    // forget old reference and delete if last reference
-    if (--static_cast<_StringBufferEx*>(_buffer)->reference == 0)
-        delete _buffer;
-    // copy reference and increment reference count
+    // take the new reference before dropping the old one
+    // in case both strings share the buffer
+    typename _Base::_StringBuffer* old = _buffer;
     _buffer = obj._buffer;
-    ++static_cast<_StringBufferEx*>(_buffer)->reference;
+    _addRef();
+    _release(old);
     return *this;
 }
 template<typename CharType>
@@ -470,19 +768,27 @@ rtypes::shallow_string<CharType>& rtypes::shallow_string<CharType>::operator +=(
     return *this;
 }
 template<typename CharType>
+rtypes::shallow_string<CharType>& rtypes::shallow_string<CharType>::operator =(const basic_string_ref<CharType>& s)
+{
+    // just invoke the base-class version
+    static_cast<_Base*>(this)->operator =(s);
+    return *this;
+}
+template<typename CharType>
+rtypes::shallow_string<CharType>& rtypes::shallow_string<CharType>::operator +=(const basic_string_ref<CharType>& s)
+{
+    // just invoke the base-class version
+    static_cast<_Base*>(this)->operator +=(s);
+    return *this;
+}
+template<typename CharType>
 void rtypes::shallow_string<CharType>::_allocate(size_type desiredSize)
 {
-    _StringBufferEx* pbuf = static_cast<_StringBufferEx*>(_buffer);
-    if (pbuf->reference > 1)
+    if ( _isShared() )
     {
-        // buffer is about to be modified; lose the old one
-        // and allocate a new buffer for the pending operation
-        --pbuf->reference;
-        _buffer = new _StringBufferEx;
-        _buffer->allocate(desiredSize);
-        // copy old data (as much or as little as possible)
-        for (size_type i = 0;i<desiredSize && i<pbuf->size;i++)
-            _buffer->data[i] = pbuf->data[i];
+        // buffer is about to be modified; copy it into a new
+        // buffer for the pending operation
+        _detach(desiredSize);
     }
     else
     {
@@ -494,13 +800,12 @@ void rtypes::shallow_string<CharType>::_allocate(size_type desiredSize)
 template<typename CharType>
 void rtypes::shallow_string<CharType>::_deallocate()
 {
-    _StringBufferEx* pbuf = static_cast<_StringBufferEx*>(_buffer);
-    if (pbuf->reference > 1)
+    if ( _isShared() )
     {
         // buffer is about to be modified; lose the old one
-        // and allocate a new buffer for the pending operation
-        --pbuf->reference;
+        typename _Base::_StringBuffer* old = _buffer;
         _buffer = new _StringBufferEx; // leave in null state
+        _release(old);
     }
     else
     {
@@ -512,19 +817,32 @@ void rtypes::shallow_string<CharType>::_deallocate()
 template<typename CharType>
 CharType& rtypes::shallow_string<CharType>::_access(size_type index)
 {
-    _StringBufferEx* pbuf = static_cast<_StringBufferEx*>(_buffer);
-    if (pbuf->reference > 1)
-    {
-        // buffer is (potentially) about to be modified; lose the reference
-        // and create a new buffer for the pending operation
-        --pbuf->reference;
-        _buffer = new _StringBufferEx;
-        _buffer->allocate(pbuf->size);
-        for (size_type i = 0;i<pbuf->size;i++)
-            _buffer->data[i] = pbuf->data[i];
-    }
+    // buffer is (potentially) about to be modified
+    if ( _isShared() )
+        _detach(_buffer->size);
     return _buffer->data[index];
 }
+template<typename CharType>
+/* static */ void rtypes::shallow_string<CharType>::_release(typename _Base::_StringBuffer* buffer)
+{
+    std::atomic<int>& reference = static_cast<_StringBufferEx*>(buffer)->reference;
+    // a count of one cannot change under us since no other string refers
+    // to the buffer; otherwise the last string to let go deletes it
+    if (reference.load(std::memory_order_acquire) == 1
+        || reference.fetch_sub(1,std::memory_order_acq_rel) == 1)
+        delete static_cast<_StringBufferEx*>(buffer);
+}
+template<typename CharType>
+void rtypes::shallow_string<CharType>::_detach(size_type desiredSize)
+{
+    // copy the old data (as much or as little as possible) before
+    // letting go of the old buffer, which another string may free
+    typename _Base::_StringBuffer* old = _buffer;
+    _buffer = new _StringBufferEx;
+    _buffer->allocate(desiredSize);
+    rutil_memcpy(_buffer->data,old->data,(desiredSize<old->size ? desiredSize : old->size)*sizeof(CharType));
+    _release(old);
+}
 
 // rtypes::shallow_string<>::_StringBufferEx
 template<typename CharType>
@@ -537,14 +855,7 @@ rtypes::shallow_string<CharType>::_StringBufferEx::_StringBufferEx()
 template<typename CharType>
 bool rtypes::operator ==(const rtype_string<CharType>& left,const rtype_string<CharType>& right)
 {
-    if (left.size() == right.size())
-    {
-        for (size_type i = 0;i<left.size();i++)
-            if (left[i] != right[i])
-                return false;
-        return true;
-    }
-    return false;
+    return left.size()==right.size() && rutil_memcmp(left.c_str(),right.c_str(),left.size()*sizeof(CharType))==0;
 }
 template<typename CharType>
 bool rtypes::operator ==(const rtype_string<CharType>& left,const CharType* right)
@@ -552,14 +863,7 @@ bool rtypes::operator ==(const rtype_string<CharType>& left,const CharType* righ
     size_type len = 0;
     while (right[len])
         ++len;
-    if (left.size() == len)
-    {
-        for (size_type i = 0;i<left.size();i++)
-            if (left[i] != right[i])
-                return false;
-        return true;
-    }
-    return false;
+    return left.size()==len && rutil_memcmp(left.c_str(),right,len*sizeof(CharType))==0;
 }
 template<typename CharType>
 bool rtypes::operator ==(const CharType* left,const rtype_string<CharType>& right)
@@ -567,15 +871,7 @@ bool rtypes::operator ==(const CharType* left,const rtype_string<CharType>& righ
     size_type len = 0;
     while (left[len])
         len++;
-    if (len == right.size())
-    {
-        for (size_type i = 0;i<len;i++)
-            if (left[i] != right[i])
-                return false;
-        return true;
-    }
-    return false;
-
+    return len==right.size() && rutil_memcmp(left,right.c_str(),len*sizeof(CharType))==0;
 }
 template<typename CharType>
 bool rtypes::operator !=(const rtype_string<CharType>& left,const rtype_string<CharType>& right)
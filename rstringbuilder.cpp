@@ -0,0 +1,164 @@
+// rstringbuilder.cpp
+#include "rstringbuilder.h"
+#include "riodevice.h"
+#include "rutility.h"
+using namespace rtypes;
+
+namespace
+{
+    // chunks stop doubling at this many bytes
+    const size_type MAX_CHUNK_SIZE = 1024*1024;
+    // number of chunks gathered into each vectored write
+    const size_type WRITE_BATCH = 64;
+}
+
+string_builder::string_builder(size_type chunkSize)
+{
+    _head = NULL;
+    _tail = NULL;
+    _sz = 0;
+    _chunkSize = (chunkSize>0 ? chunkSize : 1);
+}
+string_builder::string_builder(const string_builder& obj)
+{
+    _head = NULL;
+    _tail = NULL;
+    _sz = 0;
+    _chunkSize = obj._chunkSize;
+    append(obj);
+}
+string_builder::~string_builder()
+{
+    _freeChunks(_head);
+}
+string_builder& string_builder::operator =(const string_builder& obj)
+{
+    if (this != &obj)
+    {
+        clear();
+        append(obj);
+    }
+    return *this;
+}
+string_builder& string_builder::append(const char* pcstr)
+{
+    return append(pcstr,rutil_strlen(pcstr));
+}
+string_builder& string_builder::append(const char* buffer,size_type length)
+{
+    _sz += length;
+    while (length > 0)
+    {
+        if (_tail==NULL || _tail->size==_tail->capacity)
+            _addChunk(length);
+        size_type room = _tail->capacity-_tail->size;
+        size_type n = (length<room ? length : room);
+        rutil_memcpy(_tail->data()+_tail->size,buffer,n);
+        _tail->size += n;
+        buffer += n;
+        length -= n;
+    }
+    return *this;
+}
+string_builder& string_builder::append(const string_builder& obj)
+{
+    // appending a builder to itself copies only the original contents
+    size_type remaining = obj._sz;
+    for (const _Chunk* c = obj._head;c!=NULL && remaining>0;c = c->next)
+    {
+        size_type n = (c->size<remaining ? c->size : remaining);
+        append(c->data(),n);
+        remaining -= n;
+    }
+    return *this;
+}
+str string_builder::to_string() const
+{
+    str result(_sz); // (allocates exactly)
+    if (_sz > 0)
+        copy_to(&result[0]);
+    return result;
+}
+void string_builder::copy_to(char* dest) const
+{
+    for (const _Chunk* c = _head;c!=NULL;c = c->next)
+    {
+        rutil_memcpy(dest,c->data(),c->size);
+        dest += c->size;
+    }
+}
+size_type string_builder::write_to(io_device& device) const
+{
+    io_vector vecs[WRITE_BATCH];
+    size_type total = 0;
+    const _Chunk* c = _head;
+    while (c != NULL)
+    {
+        size_type n = 0, expected = 0;
+        for (;c!=NULL && n<WRITE_BATCH;c = c->next)
+        {
+            if (c->size == 0)
+                continue;
+            vecs[n].base = c->data();
+            vecs[n].length = c->size;
+            expected += c->size;
+            ++n;
+        }
+        if (n == 0)
+            break;
+        device.write(vecs,n);
+        total += device.get_last_byte_count();
+        if (device.get_last_byte_count() < expected)
+            break; // the device stopped accepting output
+    }
+    return total;
+}
+void string_builder::clear()
+{
+    if (_head != NULL)
+    {
+        _freeChunks(_head->next);
+        _head->next = NULL;
+        _head->size = 0;
+        _tail = _head;
+    }
+    _sz = 0;
+}
+void string_builder::reset()
+{
+    _freeChunks(_head);
+    _head = NULL;
+    _tail = NULL;
+    _sz = 0;
+}
+size_type string_builder::chunk_count() const
+{
+    size_type cnt = 0;
+    for (const _Chunk* c = _head;c!=NULL;c = c->next)
+        ++cnt;
+    return cnt;
+}
+void string_builder::_addChunk(size_type minimum)
+{
+    size_type cap = (_chunkSize<minimum ? minimum : _chunkSize);
+    _Chunk* c = static_cast<_Chunk*>( ::operator new(sizeof(_Chunk)+cap) );
+    c->next = NULL;
+    c->size = 0;
+    c->capacity = cap;
+    if (_tail != NULL)
+        _tail->next = c;
+    else
+        _head = c;
+    _tail = c;
+    if (_chunkSize < MAX_CHUNK_SIZE)
+        _chunkSize *= 2;
+}
+void string_builder::_freeChunks(_Chunk* first)
+{
+    while (first != NULL)
+    {
+        _Chunk* nxt = first->next;
+        ::operator delete(first);
+        first = nxt;
+    }
+}
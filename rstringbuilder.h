@@ -0,0 +1,102 @@
+/* rstringbuilder.h
+ *  rlibrary/rstringbuilder - provides a string builder that assembles long
+ * strings in a chain of chunks rather than in one contiguous buffer
+ */
+#ifndef RSTRINGBUILDER_H
+#define RSTRINGBUILDER_H
+#include "rstring.h" // gets rtypestypes.h
+
+namespace rtypes
+{
+    class io_device;
+
+    /* string_builder
+     *  accumulates characters in a chain of chunks (a simple rope): appending
+     * never moves characters that were appended before, so building a string
+     * of n characters costs O(n) regardless of how it is split into appends;
+     * chunks double in size (up to a limit) as the builder grows; the result
+     * can be written straight to an io_device, one gathered write for many
+     * chunks, or flattened into a contiguous string on demand
+     */
+    class string_builder
+    {
+    public:
+        explicit string_builder(size_type chunkSize = 256);
+        string_builder(const string_builder&);
+        ~string_builder();
+
+        string_builder& operator =(const string_builder&);
+
+        string_builder& operator +=(char c)
+        { return append(c); }
+        string_builder& operator +=(const char* pcstr)
+        { return append(pcstr); }
+        string_builder& operator +=(const generic_string& s)
+        { return append(s); }
+        string_builder& operator +=(const string_builder& obj)
+        { return append(obj); }
+
+        string_builder& append(char c)
+        {
+            if (_tail!=NULL && _tail->size<_tail->capacity)
+            {
+                _tail->data()[_tail->size++] = c;
+                ++_sz;
+                return *this;
+            }
+            return append(&c,1);
+        }
+        string_builder& append(const char* pcstr);
+        string_builder& append(const char* buffer,size_type length);
+        string_builder& append(const generic_string& s)
+        { return append(s.c_str(),s.size()); }
+        string_builder& append(const string_builder& obj);
+
+        /* to_string( ), copy_to( dest )
+         *  flattens the contents into a new string or into
+         *  'dest' (which must hold size() characters)
+         */
+        str to_string() const;
+        void copy_to(char* dest) const;
+
+        /* write_to( device )
+         *  writes the contents to the device with vectored writes;
+         *  returns the number of bytes written, which is less than
+         *  size() if the device stopped accepting output
+         */
+        size_type write_to(io_device& device) const;
+
+        void clear(); // removes the contents; keeps the first chunk for reuse
+        void reset(); // removes the contents and frees every chunk
+
+        bool is_empty() const
+        { return _sz==0; }
+        size_type size() const
+        { return _sz; }
+        size_type length() const
+        { return _sz; }
+        size_type chunk_count() const;
+    private:
+        struct _Chunk
+        {
+            _Chunk* next;
+            size_type size;
+            size_type capacity;
+
+            char* data() // (the characters follow the header)
+            { return reinterpret_cast<char*>(this+1); }
+            const char* data() const
+            { return reinterpret_cast<const char*>(this+1); }
+        };
+
+        _Chunk* _head;
+        _Chunk* _tail;
+        size_type _sz;
+        size_type _chunkSize; // size of the next chunk
+
+        void _addChunk(size_type minimum);
+        void _freeChunks(_Chunk* first);
+    };
+}
+
+#endif
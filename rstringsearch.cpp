@@ -0,0 +1,289 @@
+/* rstringsearch.cpp
+ *  defines the search kernels for byte strings; on x86 targets they scan 16
+ * bytes at a time with SSE2 (which the target guarantees) or 32 bytes at a
+ * time with AVX2 when the processor supports it; the variant is chosen on the
+ * first search; other targets scan one byte at a time
+ */
+#include "rstring.h"
+#include "rutility.h" // gets rutil_cpu_features
+#include "impl/simd.h"
+#include <cstring>
+using namespace rtypes;
+using namespace rtypes::rimpl;
+
+namespace
+{
+    // haystacks shorter than this are scanned one byte at a time
+    const size_type SHORT_SEARCH = 16;
+
+    typedef const char* (*find_char_fn)(const char*,size_type,char);
+    typedef const char* (*find_substr_fn)(const char*,size_type,const char*,size_type);
+
+    /* char_set
+     *  the characters of a set as a 256-bit map; the nibble tables hold
+     * the same bits arranged for a 16-entry byte shuffle: entry 'lo' of
+     * 'lowRows' has bit 'hi' set if character (hi<<4 | lo) is in the set
+     * (for 'hi' below 8) and 'highRows' covers the other half
+     */
+    struct char_set
+    {
+        char_set(const char* set,size_type m)
+        {
+            for (size_type i = 0;i<8;i++)
+                bits[i] = 0;
+            for (size_type i = 0;i<16;i++)
+                lowRows[i] = highRows[i] = 0;
+            for (size_type i = 0;i<m;i++)
+            {
+                byte b = byte(set[i]), lo = b&0x0f, hi = b>>4;
+                bits[b>>5] |= uint32(1) << (b&31);
+                if (hi < 8)
+                    lowRows[lo] |= byte(1 << hi);
+                else
+                    highRows[lo] |= byte(1 << (hi-8));
+            }
+        }
+
+        bool contains(char c) const
+        { return (bits[byte(c)>>5] & (uint32(1) << (byte(c)&31))) != 0; }
+
+        uint32 bits[8];
+        byte lowRows[16];
+        byte highRows[16];
+    };
+
+    // (scalar kernels)
+    const char* find_first_of_scalar(const char* p,size_type n,const char_set& set)
+    {
+        for (size_type i = 0;i<n;i++)
+            if ( set.contains(p[i]) )
+                return p+i;
+        return NULL;
+    }
+
+#ifdef RLIB_SIMD_SSE2
+    // (SSE2 kernels)
+    inline uint32 match_sse2(const char* p,__m128i v)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        return uint32( _mm_movemask_epi8(_mm_cmpeq_epi8(x,v)) );
+    }
+    const char* find_char_sse2(const char* p,size_type n,char c)
+    {
+        __m128i v = _mm_set1_epi8(c);
+        size_type i = 0;
+        for (;i+16<=n;i+=16)
+        {
+            uint32 mask = match_sse2(p+i,v);
+            if (mask != 0)
+                return p+i+lowest_bit(mask);
+        }
+        return _rstring_find<char>(p+i,n-i,c);
+    }
+    const char* rfind_char_sse2(const char* p,size_type n,char c)
+    {
+        __m128i v = _mm_set1_epi8(c);
+        for (;n>=16;n-=16)
+        {
+            uint32 mask = match_sse2(p+n-16,v);
+            if (mask != 0)
+                return p+n-16+highest_bit(mask);
+        }
+        return _rstring_rfind<char>(p,n,c);
+    }
+    const char* find_substr_sse2(const char* p,size_type n,const char* s,size_type m)
+    {
+        // compare the first and last characters of the needle at 16 positions
+        // at once; the rest is compared only where both of them match
+        __m128i first = _mm_set1_epi8(s[0]), last = _mm_set1_epi8(s[m-1]);
+        size_type i = 0;
+        for (;i+m-1+16<=n;i+=16)
+        {
+            uint32 mask = match_sse2(p+i,first) & match_sse2(p+i+m-1,last);
+            while (mask != 0)
+            {
+                size_type j = i+lowest_bit(mask);
+                if (std::memcmp(p+j+1,s+1,m-2) == 0)
+                    return p+j;
+                mask &= mask-1;
+            }
+        }
+        return _rstring_find<char>(p+i,n-i,s,m);
+    }
+    const char* find_first_of_sse2(const char* p,size_type n,const char* set,size_type m)
+    {
+        // without a byte shuffle only small sets are compared in parallel
+        char_set cs(set,m);
+        if (m > 4)
+            return find_first_of_scalar(p,n,cs);
+        __m128i v[4];
+        for (size_type k = 0;k<4;k++)
+            v[k] = _mm_set1_epi8(set[k<m ? k : 0]);
+        size_type i = 0;
+        for (;i+16<=n;i+=16)
+        {
+            uint32 mask = match_sse2(p+i,v[0]) | match_sse2(p+i,v[1]) | match_sse2(p+i,v[2]) | match_sse2(p+i,v[3]);
+            if (mask != 0)
+                return p+i+lowest_bit(mask);
+        }
+        return find_first_of_scalar(p+i,n-i,cs);
+    }
+#endif
+
+#ifdef RLIB_SIMD_AVX2
+    // (AVX2 kernels)
+    RLIB_AVX2_FUNCTION inline uint32 match_avx2(const char* p,__m256i v)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        return uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(x,v)) );
+    }
+    RLIB_AVX2_FUNCTION const char* find_char_avx2(const char* p,size_type n,char c)
+    {
+        avx2_scope scope;
+        __m256i v = _mm256_set1_epi8(c);
+        size_type i = 0;
+        for (;i+32<=n;i+=32)
+        {
+            uint32 mask = match_avx2(p+i,v);
+            if (mask != 0)
+                return p+i+lowest_bit(mask);
+        }
+        scope.leave();
+        return find_char_sse2(p+i,n-i,c);
+    }
+    RLIB_AVX2_FUNCTION const char* rfind_char_avx2(const char* p,size_type n,char c)
+    {
+        avx2_scope scope;
+        __m256i v = _mm256_set1_epi8(c);
+        for (;n>=32;n-=32)
+        {
+            uint32 mask = match_avx2(p+n-32,v);
+            if (mask != 0)
+                return p+n-32+highest_bit(mask);
+        }
+        scope.leave();
+        return rfind_char_sse2(p,n,c);
+    }
+    RLIB_AVX2_FUNCTION const char* find_substr_avx2(const char* p,size_type n,const char* s,size_type m)
+    {
+        avx2_scope scope;
+        __m256i first = _mm256_set1_epi8(s[0]), last = _mm256_set1_epi8(s[m-1]);
+        size_type i = 0;
+        for (;i+m-1+32<=n;i+=32)
+        {
+            uint32 mask = match_avx2(p+i,first) & match_avx2(p+i+m-1,last);
+            while (mask != 0)
+            {
+                size_type j = i+lowest_bit(mask);
+                if (std::memcmp(p+j+1,s+1,m-2) == 0)
+                    return p+j;
+                mask &= mask-1;
+            }
+        }
+        scope.leave();
+        return find_substr_sse2(p+i,n-i,s,m);
+    }
+    RLIB_AVX2_FUNCTION const char* find_first_of_avx2(const char* p,size_type n,const char* set,size_type m)
+    {
+        avx2_scope scope;
+        // look up each byte's bit in the set's nibble tables: the low nibble
+        // selects a row and the high nibble a bit within the row
+        char_set cs(set,m);
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cs.lowRows));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cs.highRows));
+        __m256i lowRows = _mm256_broadcastsi128_si256(low), highRows = _mm256_broadcastsi128_si256(high);
+        __m256i bitOf = _mm256_setr_epi8(1,2,4,8,16,32,64,-128,1,2,4,8,16,32,64,-128,
+            1,2,4,8,16,32,64,-128,1,2,4,8,16,32,64,-128);
+        __m256i nibble = _mm256_set1_epi8(0x0f), seven = _mm256_set1_epi8(7), zero = _mm256_setzero_si256();
+        size_type i = 0;
+        for (;i+32<=n;i+=32)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p+i));
+            __m256i lo = _mm256_and_si256(x,nibble);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x,4),nibble);
+            __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(lowRows,lo),_mm256_shuffle_epi8(highRows,lo),
+                _mm256_cmpgt_epi8(hi,seven));
+            __m256i hit = _mm256_and_si256(row,_mm256_shuffle_epi8(bitOf,hi));
+            uint32 mask = ~uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(hit,zero)) );
+            if (mask != 0)
+                return p+i+lowest_bit(mask);
+        }
+        return find_first_of_scalar(p+i,n-i,cs);
+    }
+#endif
+
+    struct search_kernels
+    {
+        find_char_fn find;
+        find_char_fn rfind;
+        find_substr_fn findSubstr; // (needles of two or more characters)
+        find_substr_fn findFirstOf; // (sets of two or more characters)
+    };
+
+    search_kernels select_kernels()
+    {
+        search_kernels kernels;
+#if defined(RLIB_SIMD_AVX2)
+        if (rutil_cpu_features().avx2)
+        {
+            kernels.find = &find_char_avx2;
+            kernels.rfind = &rfind_char_avx2;
+            kernels.findSubstr = &find_substr_avx2;
+            kernels.findFirstOf = &find_first_of_avx2;
+            return kernels;
+        }
+#endif
+#if defined(RLIB_SIMD_SSE2)
+        kernels.find = &find_char_sse2;
+        kernels.rfind = &rfind_char_sse2;
+        kernels.findSubstr = &find_substr_sse2;
+        kernels.findFirstOf = &find_first_of_sse2;
+#else
+        kernels.find = &_rstring_find<char>;
+        kernels.rfind = &_rstring_rfind<char>;
+        kernels.findSubstr = &_rstring_find<char>;
+        kernels.findFirstOf = &_rstring_find_first_of<char>;
+#endif
+        return kernels;
+    }
+    const search_kernels& get_kernels()
+    {
+        static const search_kernels kernels = select_kernels();
+        return kernels;
+    }
+}
+
+const char* rtypes::_rstring_find(const char* p,size_type n,char c)
+{
+    if (n < SHORT_SEARCH)
+        return _rstring_find<char>(p,n,c);
+    return get_kernels().find(p,n,c);
+}
+const char* rtypes::_rstring_rfind(const char* p,size_type n,char c)
+{
+    if (n < SHORT_SEARCH)
+        return _rstring_rfind<char>(p,n,c);
+    return get_kernels().rfind(p,n,c);
+}
+const char* rtypes::_rstring_find(const char* p,size_type n,const char* s,size_type m)
+{
+    if (m > n)
+        return NULL;
+    if (m == 0)
+        return p;
+    if (m == 1)
+        return _rstring_find(p,n,s[0]);
+    if (n < SHORT_SEARCH)
+        return _rstring_find<char>(p,n,s,m);
+    return get_kernels().findSubstr(p,n,s,m);
+}
+const char* rtypes::_rstring_find_first_of(const char* p,size_type n,const char* set,size_type m)
+{
+    if (m == 0)
+        return NULL;
+    if (m == 1)
+        return _rstring_find(p,n,set[0]);
+    if (n < SHORT_SEARCH)
+        return _rstring_find_first_of<char>(p,n,set,m);
+    return get_kernels().findFirstOf(p,n,set,m);
+}
@@ -2,6 +2,28 @@
 #include "rstringstream.h"
 using namespace rtypes;
 
+namespace
+{
+    // writes characters over a string device starting at 'iter'; the
+    // characters past the end of the string are appended in one step
+    void write_chars(generic_string& device,size_type& iter,const char* data,size_type cnt)
+    {
+        // overwrite what lies past the iterator before appending the rest
+        size_type i = 0, len = device.length();
+        if (iter < len)
+        {
+            i = (cnt<len-iter ? cnt : len-iter);
+            rutil_memcpy(&device[iter],data,i);
+            iter += i;
+        }
+        if (i < cnt)
+        {
+            device.append( string_ref(data+i,cnt-i) );
+            iter += cnt-i;
+        }
+    }
+}
+
 stringstream_io::stringstream_io()
     : rstream(false)
 { // don't buffer local characters by default
@@ -11,8 +33,9 @@ bool stringstream_io::_inDeviceImpl(const generic_string* device) const
     // place all available bytes from the string into the buffer
     if (device!=NULL && _ideviceIter<device->length())
     {
-        while (_ideviceIter < device->length())
-            _bufIn.push( device->operator[](_ideviceIter++) );
+        size_type len = device->length();
+        _bufIn.push_range(device->c_str()+_ideviceIter,len-_ideviceIter);
+        _ideviceIter = len;
         return true; // data was put into the stream
     }
     return false; // data was not put into the stream
@@ -21,12 +44,7 @@ void stringstream_io::_outDeviceImpl(generic_string* device)
 {
     if (device != NULL)
     {
-        const char* data = &_bufOut.peek();
-        for (uint32 i = 0;i<_bufOut.size();i++,_odeviceIter++)
-            if (_odeviceIter < device->length()) // replace existing character
-                device->operator[](_odeviceIter) = data[i];
-            else // grow the string
-                device->push_back(data[i]);
+        write_chars(*device,_odeviceIter,&_bufOut.peek(),_bufOut.size());
         _bufOut.pop_range( _bufOut.size() );
     }
 }
@@ -44,20 +62,16 @@ bool binstringstream_io::_inDeviceImpl(const generic_string* device) const
     // place all available bytes from the string into the buffer
     if (_ideviceIter < device->length())
     {
-        while (_ideviceIter < device->length())
-            _bufIn.push( device->operator[](_ideviceIter++) );
+        size_type len = device->length();
+        _bufIn.push_range(device->c_str()+_ideviceIter,len-_ideviceIter);
+        _ideviceIter = len;
         return true; // data was put into the stream
     }
     return false; // data was not put into the stream
 }
 void binstringstream_io::_outDeviceImpl(generic_string* device)
 {
-    const char* data = &_bufOut.peek();
-    for (uint32 i = 0;i<_bufOut.size();i++,_odeviceIter++)
-        if (_odeviceIter < device->length()) // replace existing character
-            device->operator[](_odeviceIter) = data[i];
-        else // grow the string
-            device->push_back(data[i]);
+    write_chars(*device,_odeviceIter,&_bufOut.peek(),_bufOut.size());
     _bufOut.pop_range( _bufOut.size() );
 }
 
@@ -0,0 +1,48 @@
+// regress_map_alias.cpp - inserting a map's own key or value into it
+#include "rmap.h"
+#include "rstring.h"
+#include <cstdio>
+using namespace rtypes;
+
+// growing the table frees the slots that 'key' and 'value' refer to, so
+// these must be copied before the map grows
+int main()
+{
+    const int COUNT = 1000;
+    map<int,str> m;
+    m[0] = "the value at key zero, long enough not to be inline";
+    for (int i = 1;i<COUNT;i++)
+        if ( !m.insert(i,m[i-1]) )
+        {
+            std::printf("regress_map_alias: insert %d failed\n",i);
+            return 1;
+        }
+
+    // a value that names a missing key, which operator[] then inserts
+    map<str,str> n;
+    str k = "key";
+    for (int i = 0;i<COUNT;i++)
+    {
+        str next = "key";
+        next += char('0' + i%10);
+        next += char('0' + i/10%10);
+        next += char('0' + i/100%10);
+        n[k] = next;
+        n[ n[k] ];
+        k = next;
+    }
+    if (n.size() != size_type(COUNT+1))
+    {
+        std::printf("regress_map_alias: operator[] lost keys\n");
+        return 1;
+    }
+
+    for (int i = 0;i<COUNT;i++)
+        if (m[i] != m[0])
+        {
+            std::printf("regress_map_alias: value %d was corrupted\n",i);
+            return 1;
+        }
+    std::printf("regress_map_alias: ok\n");
+    return 0;
+}
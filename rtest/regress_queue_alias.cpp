@@ -0,0 +1,43 @@
+// regress_queue_alias.cpp - pushing a queue's own element onto it
+#include "rqueue.h"
+#include "rstring.h"
+#include <cstdio>
+using namespace rtypes;
+
+// growing (or reclaiming popped space) moves the elements, so the new
+// element must be made before they move
+template<class Q>
+bool check(const char* name)
+{
+    const int COUNT = 1000;
+    Q q;
+    str first = "the first element, long enough not to be inline";
+    q.push(first);
+    for (int i = 1;i<COUNT;i++)
+    {
+        q.push( q.peek() );
+        q.push( q.back() );
+        if (i%3 == 0)
+            q.pop();
+    }
+    // leave the space at the front much larger than the elements
+    while (q.size() > 2)
+        q.pop();
+    for (int i = 0;i<COUNT;i++)
+        q.push( q.peek() );
+    while ( !q.is_empty() )
+        if (q.pop() != first)
+        {
+            std::printf("regress_queue_alias: %s element was corrupted\n",name);
+            return false;
+        }
+    return true;
+}
+
+int main()
+{
+    if (!check< queue<str> >("queue") || !check< wrapped_queue<str> >("wrapped_queue"))
+        return 1;
+    std::printf("regress_queue_alias: ok\n");
+    return 0;
+}
@@ -0,0 +1,47 @@
+// regress_tree_alias.cpp - inserting a tree_map's own key or value into it
+#include "rtree.h"
+#include "rstring.h"
+#include <cstdio>
+using namespace rtypes;
+
+// inserting shifts a leaf's entries, or moves half of them to a new leaf,
+// before the new entry is made, so an entry of that leaf is copied first
+int main()
+{
+    const int COUNT = 1000;
+    tree_map<int,str> t;
+    t[0] = "the value at key zero, long enough not to be inline";
+    for (int i = 1;i<COUNT;i++)
+        if ( !t.insert(i,t.find(i-1).value()) )
+        {
+            std::printf("regress_tree_alias: insert %d failed\n",i);
+            return 1;
+        }
+    for (int i = 0;i<COUNT;i++)
+        if (t[i] != t[0])
+        {
+            std::printf("regress_tree_alias: value %d was corrupted\n",i);
+            return 1;
+        }
+
+    // a value that names a missing key, which operator[] then inserts
+    tree_map<str,str> n;
+    str k = "key";
+    for (int i = 0;i<COUNT;i++)
+    {
+        str next = "key";
+        next += char('0' + i/100%10);
+        next += char('0' + i/10%10);
+        next += char('0' + i%10);
+        n[k] = next;
+        n[ n[k] ];
+        k = next;
+    }
+    if (n.size() != size_type(COUNT+1))
+    {
+        std::printf("regress_tree_alias: operator[] lost keys\n");
+        return 1;
+    }
+    std::printf("regress_tree_alias: ok\n");
+    return 0;
+}
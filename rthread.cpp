@@ -0,0 +1,257 @@
+/* rthread.cpp
+ *  Compile target framework flags:
+ *   RLIBRARY_BUILD_POSIX - build targeting POSIX
+ *   RLIBRARY_BUILD_WIN32 - build targeting Windows API
+ */
+
+#include "rthread.h"
+#include <chrono>
+using namespace rtypes;
+
+// define target-specific code
+
+#if defined(RLIBRARY_BUILD_POSIX)
+#include "rthread_posix.cpp"
+#elif defined(RLIBRARY_BUILD_WIN32)
+#include "rthread_win32.cpp"
+#endif
+
+// define target-independent code
+
+namespace
+{
+    // initial number of slots in a worker's deque
+    const size_type DEQUE_INITIAL_CAPACITY = 256;
+    // capacity of the queue that takes tasks from non-worker threads
+    const size_type INJECT_CAPACITY = 1024;
+    // failed attempts to find work before an idle worker sleeps
+    const uint32 IDLE_SPINS = 64;
+
+    // the scheduler (if any) for which the calling thread is a worker
+    thread_local const task_scheduler* tlsScheduler = NULL;
+    thread_local ssize_type tlsWorker = -1;
+
+    inline uint64 next_random(uint64& seed)
+    {
+        // xorshift64
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    }
+}
+
+// rtypes::_ws_deque
+_ws_deque::_ws_deque()
+    : _top(0), _bottom(0)
+{
+    _buffer.store(_allocBuffer(DEQUE_INITIAL_CAPACITY,NULL),std::memory_order_relaxed);
+}
+_ws_deque::~_ws_deque()
+{
+    _Buffer* buffer = _buffer.load(std::memory_order_relaxed);
+    while (buffer != NULL)
+    {
+        _Buffer* prev = buffer->prev;
+        delete[] buffer->items;
+        delete buffer;
+        buffer = prev;
+    }
+}
+void _ws_deque::push(_rtask* task)
+{
+    ssize_type bottom = _bottom.load(std::memory_order_relaxed);
+    ssize_type top = _top.load(std::memory_order_acquire);
+    _Buffer* buffer = _buffer.load(std::memory_order_relaxed);
+    if (size_type(bottom-top) > buffer->mask)
+        buffer = _grow(buffer,top,bottom);
+    buffer->put(bottom,task);
+    // publish the task with the new bottom
+    _bottom.store(bottom+1,std::memory_order_release);
+}
+_rtask* _ws_deque::pop()
+{
+    // reserve the bottom task before looking at the top; the sequentially
+    // consistent store and load order the reservation against a thief's
+    // read of the bottom
+    ssize_type bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    _Buffer* buffer = _buffer.load(std::memory_order_relaxed);
+    _bottom.store(bottom,std::memory_order_seq_cst);
+    ssize_type top = _top.load(std::memory_order_seq_cst);
+    _rtask* task = NULL;
+    if (top <= bottom)
+    {
+        task = buffer->get(bottom);
+        if (top == bottom)
+        {
+            // this is the last task: race the thieves for it
+            if ( !_top.compare_exchange_strong(top,top+1,std::memory_order_seq_cst,std::memory_order_relaxed) )
+                task = NULL;
+            _bottom.store(bottom+1,std::memory_order_relaxed);
+        }
+    }
+    else
+        _bottom.store(bottom+1,std::memory_order_relaxed);
+    return task;
+}
+_rtask* _ws_deque::steal()
+{
+    ssize_type top = _top.load(std::memory_order_seq_cst);
+    ssize_type bottom = _bottom.load(std::memory_order_seq_cst);
+    if (top < bottom)
+    {
+        _Buffer* buffer = _buffer.load(std::memory_order_acquire);
+        _rtask* task = buffer->get(top);
+        if ( _top.compare_exchange_strong(top,top+1,std::memory_order_seq_cst,std::memory_order_relaxed) )
+            return task;
+    }
+    return NULL;
+}
+/* static */ _ws_deque::_Buffer* _ws_deque::_allocBuffer(size_type cap,_Buffer* prev)
+{
+    _Buffer* buffer = new _Buffer;
+    buffer->mask = cap-1;
+    buffer->items = new std::atomic<_rtask*>[cap];
+    buffer->prev = prev;
+    return buffer;
+}
+_ws_deque::_Buffer* _ws_deque::_grow(_Buffer* buffer,ssize_type top,ssize_type bottom)
+{
+    _Buffer* larger = _allocBuffer((buffer->mask+1)*2,buffer);
+    for (ssize_type i = top;i<bottom;i++)
+        larger->put(i,buffer->get(i));
+    _buffer.store(larger,std::memory_order_release);
+    return larger;
+}
+
+// rtypes::task_scheduler
+task_scheduler::task_scheduler(size_type workerCount,bool pinWorkers)
+    : _inject(INJECT_CAPACITY), _stop(false), _sleepers(0)
+{
+    size_type processors = std::thread::hardware_concurrency();
+    if (processors == 0)
+        processors = 1;
+    _workerCnt = (workerCount>0 ? workerCount : processors);
+    _workers = new _Worker[_workerCnt];
+    for (size_type i = 0;i<_workerCnt;i++)
+    {
+        // the victim generator must not be seeded with zero
+        _workers[i].seed = 0x9e3779b97f4a7c15ull * (i+1);
+        _workers[i].thread = std::thread(&task_scheduler::_workerMain,this,i);
+        if (pinWorkers)
+            _pinThread(_workers[i].thread,i % processors);
+    }
+}
+task_scheduler::~task_scheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepLock);
+        _stop.store(true,std::memory_order_release);
+    }
+    _wake.notify_all();
+    for (size_type i = 0;i<_workerCnt;i++)
+        _workers[i].thread.join();
+    delete[] _workers;
+}
+ssize_type task_scheduler::current_worker() const
+{
+    return (tlsScheduler==this ? tlsWorker : -1);
+}
+void task_scheduler::_workerMain(size_type index)
+{
+    uint32 idle = 0;
+    tlsScheduler = this;
+    tlsWorker = ssize_type(index);
+    while ( !_stop.load(std::memory_order_acquire) )
+    {
+        if ( _runOne(ssize_type(index),_workers[index].seed) )
+        {
+            idle = 0;
+            continue;
+        }
+        if (++idle < IDLE_SPINS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        // sleep until a task is submitted; the timeout covers a
+        // submission that checked for sleepers before we counted
+        // ourselves, after we last looked for work
+        std::unique_lock<std::mutex> lock(_sleepLock);
+        _sleepers.fetch_add(1,std::memory_order_seq_cst);
+        if (!_stop.load(std::memory_order_relaxed) && !_hasWork())
+            _wake.wait_for(lock,std::chrono::milliseconds(1));
+        _sleepers.fetch_sub(1,std::memory_order_relaxed);
+    }
+}
+void task_scheduler::_submit(_rtask* task)
+{
+    ssize_type self = current_worker();
+    if (self >= 0)
+        _workers[self].deque.push(task);
+    else if ( !_inject.try_push(task) )
+    {
+        // the shared queue is full: run the task on the calling thread
+        _execute(task);
+        return;
+    }
+    if (_sleepers.load(std::memory_order_seq_cst) > 0)
+        _wake.notify_one();
+}
+bool task_scheduler::_runOne(ssize_type self,uint64& seed)
+{
+    _rtask* task = NULL;
+    if (self >= 0)
+        task = _workers[self].deque.pop();
+    if (task==NULL && !_inject.try_pop(task))
+        task = NULL;
+    if (task == NULL)
+    {
+        // try each other worker once starting from a random victim
+        size_type start = size_type(next_random(seed) % _workerCnt);
+        for (size_type i = 0;i<_workerCnt && task==NULL;i++)
+        {
+            size_type victim = (start+i) % _workerCnt;
+            if (ssize_type(victim) != self)
+                task = _workers[victim].deque.steal();
+        }
+        if (task == NULL)
+            return false;
+    }
+    _execute(task);
+    return true;
+}
+bool task_scheduler::_hasWork() const
+{
+    if ( !_inject.is_empty() )
+        return true;
+    for (size_type i = 0;i<_workerCnt;i++)
+        if ( !_workers[i].deque.is_empty() )
+            return true;
+    return false;
+}
+/* static */ void task_scheduler::_execute(_rtask* task)
+{
+    task_group* group = task->group;
+    task->run();
+    delete task;
+    // the group may be destroyed as soon as its count reaches zero
+    group->_pending.fetch_sub(1,std::memory_order_release);
+}
+
+// rtypes::task_group
+void task_group::wait()
+{
+    // help run queued tasks (of any group) until this group's tasks have
+    // completed rather than blocking the calling thread
+    ssize_type self = _sched.current_worker();
+    uint64 seed = 0x9e3779b97f4a7c15ull ^ uint64(self+2);
+    _rcon_backoff backoff;
+    while (_pending.load(std::memory_order_acquire) > 0)
+    {
+        if ( _sched._runOne(self,seed) )
+            backoff = _rcon_backoff();
+        else
+            backoff.wait();
+    }
+}
@@ -0,0 +1,197 @@
+/* rthread.h
+ *  rlibrary/rthread - provides a task scheduler that runs fork/join work on a
+ * pool of worker threads; each worker keeps its own work-stealing deque and
+ * idle workers take tasks from the other workers' deques
+ */
+#ifndef RTHREAD_H
+#define RTHREAD_H
+#include "rtypestypes.h"
+#include "rconqueue.h" // gets CACHE_LINE_SIZE, mpmc_queue
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace rtypes
+{
+    class task_group;
+
+    /* _rtask
+     *  a unit of work queued by a task group; tasks are
+     * allocated on the heap and deleted once they have run
+     */
+    struct _rtask
+    {
+        explicit _rtask(task_group* pgroup)
+            : group(pgroup) {}
+        virtual ~_rtask() {}
+
+        virtual void run() = 0;
+
+        task_group* group;
+    };
+
+    template<class Function>
+    struct _rtask_function : _rtask
+    {
+        _rtask_function(task_group* pgroup,const Function& function)
+            : _rtask(pgroup), func(function) {}
+
+        virtual void run()
+        { func(); }
+
+        Function func;
+    };
+
+    /* _ws_deque
+     *  a Chase-Lev work-stealing deque of tasks: the owning worker pushes and
+     * pops at the bottom without contention while other threads steal from the
+     * top, racing only for the last task; the circular buffer doubles when it
+     * fills; a thief may still be reading a replaced buffer, so replaced buffers
+     * are kept until the deque is destroyed
+     */
+    class _ws_deque
+    {
+    public:
+        _ws_deque();
+        ~_ws_deque();
+
+        // (owner operations)
+        void push(_rtask* task);
+        _rtask* pop(); // returns NULL if the deque is empty
+
+        // (any thread) returns NULL if the deque is empty or the steal lost a race
+        _rtask* steal();
+
+        // (any thread) approximate while other threads are active
+        bool is_empty() const
+        { return _bottom.load(std::memory_order_acquire) <= _top.load(std::memory_order_acquire); }
+    private:
+        struct _Buffer
+        {
+            size_type mask;
+            std::atomic<_rtask*>* items;
+            _Buffer* prev; // the buffer this one replaced
+
+            _rtask* get(ssize_type i) const
+            { return items[size_type(i)&mask].load(std::memory_order_relaxed); }
+            void put(ssize_type i,_rtask* task)
+            { items[size_type(i)&mask].store(task,std::memory_order_relaxed); }
+        };
+
+        std::atomic<ssize_type> _top; // (thieves)
+        byte _pad0[CACHE_LINE_SIZE];
+        std::atomic<ssize_type> _bottom; // (owner)
+        std::atomic<_Buffer*> _buffer;
+        byte _pad1[CACHE_LINE_SIZE];
+
+        static _Buffer* _allocBuffer(size_type cap,_Buffer* prev);
+        _Buffer* _grow(_Buffer* buffer,ssize_type top,ssize_type bottom);
+
+        // disallow copying
+        _ws_deque(const _ws_deque&);
+        _ws_deque& operator =(const _ws_deque&);
+    };
+
+    /* task_scheduler
+     *  runs tasks on a fixed pool of worker threads; a task spawned from a
+     * worker goes onto that worker's deque (so recursive fork/join work stays
+     * local and is run newest first), while a task spawned from any other
+     * thread goes onto a shared queue; a worker without work steals the oldest
+     * task from a randomly chosen worker and sleeps once there is nothing to
+     * steal; tasks are spawned and waited on through a task_group
+     */
+    class task_scheduler
+    {
+        friend class task_group;
+    public:
+        /* task_scheduler( workerCount, pinWorkers )
+         *  starts 'workerCount' worker threads, or one per hardware thread
+         * if 'workerCount' is zero; if 'pinWorkers' is true then worker i is
+         * bound to processor i (modulo the number of processors)
+         */
+        explicit task_scheduler(size_type workerCount = 0,bool pinWorkers = false);
+        ~task_scheduler(); // stops the workers; pending tasks must have been waited on
+
+        size_type worker_count() const
+        { return _workerCnt; }
+
+        /* current_worker( )
+         *  returns the index of the calling thread among this
+         *  scheduler's workers or -1 if it is not a worker
+         */
+        ssize_type current_worker() const;
+    private:
+        struct _Worker
+        {
+            _ws_deque deque;
+            std::thread thread;
+            uint64 seed; // steal victim generator state
+        };
+
+        _Worker* _workers;
+        size_type _workerCnt;
+        mpmc_queue<_rtask*> _inject; // tasks spawned by non-worker threads
+        std::atomic<bool> _stop;
+        std::atomic<size_type> _sleepers;
+        std::mutex _sleepLock;
+        std::condition_variable _wake;
+
+        void _workerMain(size_type index);
+        void _submit(_rtask* task);
+        bool _runOne(ssize_type self,uint64& seed); // runs one available task; returns false if none was found
+        bool _hasWork() const;
+        static void _execute(_rtask* task);
+        static void _pinThread(std::thread& thread,size_type processor); // (target-specific)
+
+        // disallow copying
+        task_scheduler(const task_scheduler&);
+        task_scheduler& operator =(const task_scheduler&);
+    };
+
+    /* task_group
+     *  spawns related tasks on a scheduler and waits for them to complete
+     * (fork/join); a task may itself create task groups and spawn and wait on
+     * them; the waiting thread runs queued tasks until the group's tasks have
+     * completed, so waiting from inside a task does not block a worker; a
+     * task must not throw; a group waits for its tasks when it is destroyed
+     */
+    class task_group
+    {
+        friend class task_scheduler;
+    public:
+        explicit task_group(task_scheduler& scheduler)
+            : _sched(scheduler), _pending(0) {}
+        ~task_group()
+        { wait(); }
+
+        /* spawn( function )
+         *  queues a copy of 'function' to be called with
+         *  no arguments on some thread of the scheduler
+         */
+        template<class Function>
+        void spawn(const Function& function)
+        {
+            _pending.fetch_add(1,std::memory_order_relaxed);
+            _sched._submit( new _rtask_function<Function>(this,function) );
+        }
+
+        /* wait( )
+         *  returns once every task spawned on the group has completed;
+         *  memory written by the tasks is visible to the caller afterward
+         */
+        void wait();
+
+        bool is_done() const
+        { return _pending.load(std::memory_order_acquire) == 0; }
+    private:
+        task_scheduler& _sched;
+        std::atomic<size_type> _pending;
+
+        // disallow copying
+        task_group(const task_group&);
+        task_group& operator =(const task_group&);
+    };
+}
+
+#endif
@@ -0,0 +1,22 @@
+/* rthread_posix.cpp - implements rthread using POSIX
+ *  This file should never be targeted directly; it's merely an implementation file referenced conditionally.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+// rtypes::task_scheduler
+/* static */ void task_scheduler::_pinThread(std::thread& thread,size_type processor)
+{
+#if defined(__linux__)
+    // binding is only a hint: a failure leaves the thread unbound
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(processor % CPU_SETSIZE,&set);
+    pthread_setaffinity_np(thread.native_handle(),sizeof(cpu_set_t),&set);
+#else
+    // (no portable POSIX interface binds a thread to a processor)
+    (void)thread;
+    (void)processor;
+#endif
+}
@@ -0,0 +1,12 @@
+/* rthread_win32.cpp - implements rthread using the Windows API
+ *  This file should never be targeted directly; it's merely an implementation file referenced conditionally.
+ */
+
+#include <Windows.h>
+
+// rtypes::task_scheduler
+/* static */ void task_scheduler::_pinThread(std::thread& thread,size_type processor)
+{
+    // binding is only a hint: a failure leaves the thread unbound
+    SetThreadAffinityMask(thread.native_handle(),DWORD_PTR(1) << (processor % (sizeof(DWORD_PTR)*8)));
+}
@@ -1,10 +1,496 @@
 // rtree.h - provides tree data structures
 #ifndef RTREE_H
 #define RTREE_H
+#include "rerror.h"
+#include "rtypestypes.h"
+#include "rallocator.h"
+#include <functional>
 
 namespace rtypes
 {
+    // stands in for the mapped type of a tree_set
+    struct _btree_no_value {};
 
+    template<typename Value>
+    struct _btree_value_size
+    {
+        static const size_type value = sizeof(Value);
+    };
+    template<>
+    struct _btree_value_size<_btree_no_value>
+    {
+        static const size_type value = 0;
+    };
+
+    /* _btree
+     *  B+tree implementation shared by tree_map and tree_set; entries are stored
+     * only in the leaves, which are linked in key order so that a range scan never
+     * revisits the inner nodes; each node is sized to span four 64-byte cache lines,
+     * so the number of keys a node holds follows from sizeof(Key) (at least four);
+     * keys must be strictly ordered by 'operator <'; inserting or removing
+     * an entry invalidates all iterators
+     */
+    template<typename Key,typename Value,class Alloc>
+    class _btree : private Alloc
+    {
+        struct _Node;
+        struct _Leaf;
+        struct _Inner;
+    public:
+        static const size_type NODE_BYTES = 256;
+        static const size_type LEAF_ORDER = (NODE_BYTES-2*sizeof(uint32)-2*sizeof(void*)) / (sizeof(Key)+_btree_value_size<Value>::value) < 4 ? 4
+            : (NODE_BYTES-2*sizeof(uint32)-2*sizeof(void*)) / (sizeof(Key)+_btree_value_size<Value>::value);
+        static const size_type INNER_ORDER = (NODE_BYTES-2*sizeof(uint32)-sizeof(void*)) / (sizeof(Key)+sizeof(void*)) < 4 ? 4
+            : (NODE_BYTES-2*sizeof(uint32)-sizeof(void*)) / (sizeof(Key)+sizeof(void*));
+
+        class const_iterator;
+
+        /* iterator
+         *  refers to an entry in a leaf; dereferencing yields the entry's
+         * key, and value() yields its mapped value
+         */
+        class iterator
+        {
+            friend class _btree;
+            friend class const_iterator;
+        public:
+            iterator()
+                : _leaf(NULL), _idx(0), _tail(NULL) {}
+
+            const Key& key() const
+            { return _leaf->keys()[_idx]; }
+            Value& value() const
+            { return _leaf->values()[_idx]; }
+
+            const Key& operator *() const
+            { return _leaf->keys()[_idx]; }
+            const Key* operator ->() const
+            { return _leaf->keys()+_idx; }
+
+            iterator& operator ++()
+            {
+                if (++_idx >= _leaf->cnt)
+                {
+                    _leaf = _leaf->next;
+                    _idx = 0;
+                }
+                return *this;
+            }
+            iterator operator ++(int)
+            {
+                iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+            iterator& operator --()
+            {
+                if (_leaf == NULL)
+                {
+                    _leaf = *_tail;
+                    _idx = _leaf->cnt;
+                }
+                else if (_idx == 0)
+                {
+                    _leaf = _leaf->prev;
+                    _idx = _leaf->cnt;
+                }
+                --_idx;
+                return *this;
+            }
+            iterator operator --(int)
+            {
+                iterator tmp = *this;
+                --*this;
+                return tmp;
+            }
+
+            bool operator ==(const iterator& obj) const
+            { return _leaf==obj._leaf && _idx==obj._idx; }
+            bool operator !=(const iterator& obj) const
+            { return _leaf!=obj._leaf || _idx!=obj._idx; }
+        private:
+            _Leaf* _leaf; // NULL at the end
+            size_type _idx;
+            _Leaf* const* _tail; // lets end() be decremented
+
+            iterator(_Leaf* leaf,size_type idx,_Leaf* const* tail)
+                : _leaf(leaf), _idx(idx), _tail(tail) {}
+        };
+
+        class const_iterator
+        {
+            friend class _btree;
+        public:
+            const_iterator()
+                : _leaf(NULL), _idx(0), _tail(NULL) {}
+            const_iterator(const iterator& iter)
+                : _leaf(iter._leaf), _idx(iter._idx), _tail(iter._tail) {}
+
+            const Key& key() const
+            { return _leaf->keys()[_idx]; }
+            const Value& value() const
+            { return _leaf->values()[_idx]; }
+
+            const Key& operator *() const
+            { return _leaf->keys()[_idx]; }
+            const Key* operator ->() const
+            { return _leaf->keys()+_idx; }
+
+            const_iterator& operator ++()
+            {
+                if (++_idx >= _leaf->cnt)
+                {
+                    _leaf = _leaf->next;
+                    _idx = 0;
+                }
+                return *this;
+            }
+            const_iterator operator ++(int)
+            {
+                const_iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+            const_iterator& operator --()
+            {
+                if (_leaf == NULL)
+                {
+                    _leaf = *_tail;
+                    _idx = _leaf->cnt;
+                }
+                else if (_idx == 0)
+                {
+                    _leaf = _leaf->prev;
+                    _idx = _leaf->cnt;
+                }
+                --_idx;
+                return *this;
+            }
+            const_iterator operator --(int)
+            {
+                const_iterator tmp = *this;
+                --*this;
+                return tmp;
+            }
+
+            bool operator ==(const const_iterator& obj) const
+            { return _leaf==obj._leaf && _idx==obj._idx; }
+            bool operator !=(const const_iterator& obj) const
+            { return _leaf!=obj._leaf || _idx!=obj._idx; }
+        private:
+            const _Leaf* _leaf;
+            size_type _idx;
+            _Leaf* const* _tail;
+
+            const_iterator(const _Leaf* leaf,size_type idx,_Leaf* const* tail)
+                : _leaf(leaf), _idx(idx), _tail(tail) {}
+        };
+
+        iterator begin()
+        { return iterator(_head,0,&_tail); }
+        iterator end()
+        { return iterator(NULL,0,&_tail); }
+        const_iterator begin() const
+        { return const_iterator(_head,0,&_tail); }
+        const_iterator end() const
+        { return const_iterator(NULL,0,&_tail); }
+
+        /* find( key )
+         *  returns an iterator to the entry with the
+         *  specified key or end() if it does not exist
+         */
+        iterator find(const Key& key);
+        const_iterator find(const Key& key) const;
+
+        /* lower_bound( key ), upper_bound( key )
+         *  returns an iterator to the first entry whose key is
+         *  not less than (lower_bound) or greater than (upper_bound)
+         *  the specified key; [lower_bound(a),lower_bound(b)) is
+         *  the range of keys in [a,b)
+         */
+        iterator lower_bound(const Key& key);
+        const_iterator lower_bound(const Key& key) const;
+        iterator upper_bound(const Key& key);
+        const_iterator upper_bound(const Key& key) const;
+
+        /* contains( key )
+         *  determines if an entry with the key exists
+         */
+        bool contains(const Key& key) const
+        { return find(key) != end(); }
+
+        /* empty( )
+         *  removes all entries
+         */
+        void empty();
+
+        /* is_empty( )
+         *  determines if there are any entries
+         */
+        bool is_empty() const
+        { return _sz==0; }
+
+        /* size( )
+         *  returns the number of entries
+         */
+        size_type size() const
+        { return _sz; }
+
+        Alloc get_allocator() const
+        { return *this; }
+    protected:
+        _btree();
+        explicit _btree(const Alloc& allocator);
+        _btree(const _btree&);
+        ~_btree();
+
+        _btree& operator =(const _btree&);
+
+        // inserts an entry unless the key exists; 'where' is
+        // set to the entry with the key in either case
+        bool _insert(const Key& key,const Value& value,iterator& where);
+        // removes the entry with the key if it exists
+        void _remove(const Key& key);
+        // replaces the contents with 'cnt' entries taken in order from 'src',
+        // which must produce strictly increasing keys
+        template<class Source>
+        void _build(Source& src,size_type cnt);
+    private:
+        typedef _rallocator_raw<Key> _KeyRaw;
+        typedef _rallocator_raw<Value> _ValueRaw;
+
+        struct _Node
+        {
+            uint32 cnt; // number of keys
+            uint32 leaf;
+        };
+        struct _Leaf : _Node
+        {
+            _Leaf* prev;
+            _Leaf* next;
+            typename std::aligned_storage<sizeof(Key)*LEAF_ORDER,alignof(Key)>::type keyBuf;
+            typename std::aligned_storage<sizeof(Value)*LEAF_ORDER,alignof(Value)>::type valueBuf;
+
+            Key* keys()
+            { return reinterpret_cast<Key*>(&keyBuf); }
+            const Key* keys() const
+            { return reinterpret_cast<const Key*>(&keyBuf); }
+            Value* values()
+            { return reinterpret_cast<Value*>(&valueBuf); }
+            const Value* values() const
+            { return reinterpret_cast<const Value*>(&valueBuf); }
+        };
+        struct _Inner : _Node
+        {
+            // children[i] holds keys less than keys[i]; children[i+1]
+            // holds keys not less than keys[i]
+            _Node* children[INNER_ORDER+1];
+            typename std::aligned_storage<sizeof(Key)*INNER_ORDER,alignof(Key)>::type keyBuf;
+
+            Key* keys()
+            { return reinterpret_cast<Key*>(&keyBuf); }
+            const Key* keys() const
+            { return reinterpret_cast<const Key*>(&keyBuf); }
+        };
+
+        // enough for any tree that fits in memory: every inner node
+        // but the root has at least two children
+        static const size_type _MAX_DEPTH = 64;
+        static const size_type _MIN_LEAF = LEAF_ORDER/2;
+        static const size_type _MIN_INNER = (INNER_ORDER-1)/2;
+
+        _Node* _root; // NULL when the tree is empty
+        _Leaf* _head;
+        _Leaf* _tail;
+        size_type _sz;
+
+        Alloc& _allocator()
+        { return *this; }
+
+        const _Leaf* _findLeaf(const Key& key) const;
+        static size_type _lowerIndex(const Key* keys,size_type cnt,const Key& key);
+        static size_type _upperIndex(const Key* keys,size_type cnt,const Key& key);
+        void _rebalance(_Inner* parent,size_type i);
+        void _merge(_Inner* parent,size_type i);
+
+        _Leaf* _newLeaf();
+        _Inner* _newInner();
+        void _destroy(_Node* node); // destroys a subtree
+        void _freeLeaf(_Leaf* leaf);
+        void _freeInner(_Inner* inner);
+        static bool _inLeaf(const _Leaf* leaf,const void* p); // true if 'p' lies within the leaf
+
+        // array operations over the constructed prefix of a node array
+        template<typename E,typename U>
+        static void _arrInsert(E* arr,size_type cnt,size_type pos,U&& elem);
+        template<typename E>
+        static void _arrErase(E* arr,size_type cnt,size_type pos);
+
+        struct _CopySource
+        {
+            const _Leaf* leaf;
+            size_type idx;
+
+            void next(Key* key,Value* value);
+        };
+    };
+
+    /* tree_map
+     *  an ordered map implemented as a B+tree; lookups, insertions and removals
+     * are O(log n) and iteration visits entries in key order; bulk_load builds a
+     * tree from sorted input in O(n) with fully packed leaves
+     *  e.g. for (iter = m.lower_bound(lo);iter!=m.end() && *iter<hi;++iter)
+     *           visit(iter.key(),iter.value());
+     */
+    template<typename Key,typename Value,class Alloc = default_allocator>
+    class tree_map : protected _btree<Key,Value,Alloc>
+    {
+        typedef _btree<Key,Value,Alloc> _Base;
+    public:
+        typedef typename _Base::iterator iterator;
+        typedef typename _Base::const_iterator const_iterator;
+
+        tree_map() {}
+        explicit tree_map(const Alloc& allocator)
+            : _Base(allocator) {}
+
+        /* insert( key, value )
+         *  adds an entry if the key does not exist already;
+         *  returns false (leaving the existing entry alone)
+         *  if it does
+         */
+        bool insert(const Key& key,const Value& value)
+        {
+            iterator where;
+            return _Base::_insert(key,value,where);
+        }
+
+        /* remove( key )
+         *  removes the entry with the key if it exists
+         */
+        void remove(const Key& key)
+        { _Base::_remove(key); }
+
+        /* get( key )
+         *  returns the value mapped to the key; throws
+         *  element_not_found_error if there is no such entry
+         */
+        Value& get(const Key& key);
+        const Value& get(const Key& key) const;
+
+        /* bulk_load( keys, values, count )
+         *  replaces the contents of the map with the specified entries;
+         *  the keys must be strictly increasing, else invalid_operation_error
+         *  is thrown and the map is left unchanged
+         */
+        void bulk_load(const Key* keys,const Value* values,size_type cnt);
+
+        // returns the value mapped to the key, inserting
+        // a default-constructed value if necessary
+        Value& operator [](const Key& key)
+        {
+            iterator where = _Base::find(key);
+            if (where == _Base::end())
+                _Base::_insert(key,Value(),where);
+            return where.value();
+        }
+
+        using _Base::begin;
+        using _Base::end;
+        using _Base::find;
+        using _Base::lower_bound;
+        using _Base::upper_bound;
+        using _Base::contains;
+        using _Base::empty;
+        using _Base::is_empty;
+        using _Base::size;
+        using _Base::get_allocator;
+    private:
+        struct _ArraySource
+        {
+            const Key* keys;
+            const Value* values;
+
+            void next(Key* key,Value* value)
+            {
+                _rallocator_raw<Key>::construct(key,*keys++);
+                _rallocator_raw<Value>::construct(value,*values++);
+            }
+        };
+    };
+
+    /* tree_set
+     *  an ordered set implemented as a B+tree; it provides the interface of
+     * 'set' plus ordered iteration and range queries
+     */
+    template<typename T,class Alloc = default_allocator>
+    class tree_set : protected _btree<T,_btree_no_value,Alloc>
+    {
+        typedef _btree<T,_btree_no_value,Alloc> _Base;
+    public:
+        typedef typename _Base::const_iterator iterator;
+        typedef typename _Base::const_iterator const_iterator;
+
+        tree_set() {}
+        explicit tree_set(const Alloc& allocator)
+            : _Base(allocator) {}
+
+        /* insert( element )
+         *  adds the specified element to the set
+         *  if it does not exist already; returns false
+         *  if it already exists
+         */
+        bool insert(const T& elem)
+        {
+            typename _Base::iterator where;
+            return _Base::_insert(elem,_btree_no_value(),where);
+        }
+
+        /* remove( element )
+         *  removes the specified element if it exists;
+         */
+        void remove(const T& elem)
+        { _Base::_remove(elem); }
+
+        /* bulk_load( elements, count )
+         *  replaces the contents of the set with the specified elements;
+         *  the elements must be strictly increasing, else invalid_operation_error
+         *  is thrown and the set is left unchanged
+         */
+        void bulk_load(const T* elems,size_type cnt);
+
+        const_iterator begin() const
+        { return _Base::begin(); }
+        const_iterator end() const
+        { return _Base::end(); }
+        const_iterator find(const T& elem) const
+        { return _Base::find(elem); }
+        const_iterator lower_bound(const T& elem) const
+        { return _Base::lower_bound(elem); }
+        const_iterator upper_bound(const T& elem) const
+        { return _Base::upper_bound(elem); }
+
+        using _Base::contains;
+        using _Base::empty;
+        using _Base::is_empty;
+        using _Base::size;
+        using _Base::get_allocator;
+
+        bool operator ==(const tree_set& obj) const;
+        bool operator !=(const tree_set& obj) const
+        { return !(*this==obj); }
+    private:
+        struct _ArraySource
+        {
+            const T* elems;
+
+            void next(T* elem,_btree_no_value* value)
+            {
+                _rallocator_raw<T>::construct(elem,*elems++);
+                new (value) _btree_no_value();
+            }
+        };
+    };
 }
 
 // include out-of-line implementation
@@ -1,2 +1,666 @@
 // rtree.tcc - rlibrary/rtree out-of-line implementation
 
+// rtypes::_btree<>
+template<typename Key,typename Value,class Alloc>
+rtypes::_btree<Key,Value,Alloc>::_btree()
+{
+    _root = NULL;
+    _head = NULL;
+    _tail = NULL;
+    _sz = 0;
+}
+template<typename Key,typename Value,class Alloc>
+rtypes::_btree<Key,Value,Alloc>::_btree(const Alloc& allocator)
+    : Alloc(allocator)
+{
+    _root = NULL;
+    _head = NULL;
+    _tail = NULL;
+    _sz = 0;
+}
+template<typename Key,typename Value,class Alloc>
+rtypes::_btree<Key,Value,Alloc>::_btree(const _btree& obj)
+    : Alloc(obj)
+{
+    _CopySource src;
+    _root = NULL;
+    _head = NULL;
+    _tail = NULL;
+    _sz = 0;
+    src.leaf = obj._head;
+    src.idx = 0;
+    _build(src,obj._sz);
+}
+template<typename Key,typename Value,class Alloc>
+rtypes::_btree<Key,Value,Alloc>::~_btree()
+{
+    empty();
+}
+template<typename Key,typename Value,class Alloc>
+rtypes::_btree<Key,Value,Alloc>& rtypes::_btree<Key,Value,Alloc>::operator =(const _btree& obj)
+{
+    if (this != &obj)
+    {
+        _CopySource src;
+        src.leaf = obj._head;
+        src.idx = 0;
+        _build(src,obj._sz);
+    }
+    return *this;
+}
+template<typename Key,typename Value,class Alloc>
+typename rtypes::_btree<Key,Value,Alloc>::iterator rtypes::_btree<Key,Value,Alloc>::find(const Key& key)
+{
+    _Leaf* leaf = const_cast<_Leaf*>( _findLeaf(key) );
+    if (leaf != NULL)
+    {
+        size_type i = _lowerIndex(leaf->keys(),leaf->cnt,key);
+        if (i<leaf->cnt && !(key<leaf->keys()[i]))
+            return iterator(leaf,i,&_tail);
+    }
+    return end();
+}
+template<typename Key,typename Value,class Alloc>
+typename rtypes::_btree<Key,Value,Alloc>::const_iterator rtypes::_btree<Key,Value,Alloc>::find(const Key& key) const
+{
+    return const_cast<_btree*>(this)->find(key);
+}
+template<typename Key,typename Value,class Alloc>
+typename rtypes::_btree<Key,Value,Alloc>::iterator rtypes::_btree<Key,Value,Alloc>::lower_bound(const Key& key)
+{
+    _Leaf* leaf = const_cast<_Leaf*>( _findLeaf(key) );
+    if (leaf != NULL)
+    {
+        size_type i = _lowerIndex(leaf->keys(),leaf->cnt,key);
+        if (i < leaf->cnt)
+            return iterator(leaf,i,&_tail);
+        // the bound is the first entry of the next leaf
+        return iterator(leaf->next,0,&_tail);
+    }
+    return end();
+}
+template<typename Key,typename Value,class Alloc>
+typename rtypes::_btree<Key,Value,Alloc>::const_iterator rtypes::_btree<Key,Value,Alloc>::lower_bound(const Key& key) const
+{
+    return const_cast<_btree*>(this)->lower_bound(key);
+}
+template<typename Key,typename Value,class Alloc>
+typename rtypes::_btree<Key,Value,Alloc>::iterator rtypes::_btree<Key,Value,Alloc>::upper_bound(const Key& key)
+{
+    _Leaf* leaf = const_cast<_Leaf*>( _findLeaf(key) );
+    if (leaf != NULL)
+    {
+        size_type i = _upperIndex(leaf->keys(),leaf->cnt,key);
+        if (i < leaf->cnt)
+            return iterator(leaf,i,&_tail);
+        return iterator(leaf->next,0,&_tail);
+    }
+    return end();
+}
+template<typename Key,typename Value,class Alloc>
+typename rtypes::_btree<Key,Value,Alloc>::const_iterator rtypes::_btree<Key,Value,Alloc>::upper_bound(const Key& key) const
+{
+    return const_cast<_btree*>(this)->upper_bound(key);
+}
+template<typename Key,typename Value,class Alloc>
+void rtypes::_btree<Key,Value,Alloc>::empty()
+{
+    if (_root != NULL)
+        _destroy(_root);
+    _root = NULL;
+    _head = NULL;
+    _tail = NULL;
+    _sz = 0;
+}
+template<typename Key,typename Value,class Alloc>
+bool rtypes::_btree<Key,Value,Alloc>::_insert(const Key& key,const Value& value,iterator& where)
+{
+    _Inner* path[_MAX_DEPTH];
+    size_type pathIdx[_MAX_DEPTH];
+    size_type depth = 0, pos;
+    _Node* node;
+    _Leaf* leaf;
+    if (_root == NULL)
+        _root = _head = _tail = _newLeaf();
+    // descend to the leaf, remembering the path for splits
+    node = _root;
+    while (!node->leaf)
+    {
+        _Inner* inner = static_cast<_Inner*>(node);
+        size_type i = _upperIndex(inner->keys(),inner->cnt,key);
+        path[depth] = inner;
+        pathIdx[depth++] = i;
+        node = inner->children[i];
+    }
+    leaf = static_cast<_Leaf*>(node);
+    pos = _lowerIndex(leaf->keys(),leaf->cnt,key);
+    if (pos<leaf->cnt && !(key<leaf->keys()[pos]))
+    {
+        where = iterator(leaf,pos,&_tail);
+        return false;
+    }
+    // the leaf's entries are shifted (or moved to a new sibling) before the
+    // new entry is made, so an entry of this same leaf must be copied first
+    if (_inLeaf(leaf,&key) || _inLeaf(leaf,&value))
+    {
+        Key keyCopy(key);
+        Value valueCopy(value);
+        return _insert(keyCopy,valueCopy,where);
+    }
+    ++_sz;
+    if (leaf->cnt < LEAF_ORDER)
+    {
+        _arrInsert(leaf->keys(),leaf->cnt,pos,key);
+        _arrInsert(leaf->values(),leaf->cnt,pos,value);
+        ++leaf->cnt;
+        where = iterator(leaf,pos,&_tail);
+        return true;
+    }
+    // split the full leaf: the left half keeps (LEAF_ORDER+1)/2 entries
+    // counting the new one and the rest move to a new right sibling
+    _Leaf* right = _newLeaf();
+    size_type leftCnt = (LEAF_ORDER+1) / 2;
+    if (pos < leftCnt)
+    {
+        right->cnt = uint32(LEAF_ORDER-leftCnt+1);
+        _KeyRaw::relocate_range(right->keys(),leaf->keys()+leftCnt-1,right->cnt);
+        _ValueRaw::relocate_range(right->values(),leaf->values()+leftCnt-1,right->cnt);
+        leaf->cnt = uint32(leftCnt-1);
+        _arrInsert(leaf->keys(),leaf->cnt,pos,key);
+        _arrInsert(leaf->values(),leaf->cnt,pos,value);
+        ++leaf->cnt;
+        where = iterator(leaf,pos,&_tail);
+    }
+    else
+    {
+        right->cnt = uint32(LEAF_ORDER-leftCnt);
+        _KeyRaw::relocate_range(right->keys(),leaf->keys()+leftCnt,right->cnt);
+        _ValueRaw::relocate_range(right->values(),leaf->values()+leftCnt,right->cnt);
+        leaf->cnt = uint32(leftCnt);
+        _arrInsert(right->keys(),right->cnt,pos-leftCnt,key);
+        _arrInsert(right->values(),right->cnt,pos-leftCnt,value);
+        ++right->cnt;
+        where = iterator(right,pos-leftCnt,&_tail);
+    }
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next != NULL)
+        leaf->next->prev = right;
+    else
+        _tail = right;
+    leaf->next = right;
+    // insert the separator and new node into the parent, splitting
+    // full inner nodes on the way up
+    Key sep( right->keys()[0] );
+    _Node* newNode = right;
+    while (depth > 0)
+    {
+        _Inner* inner = path[--depth];
+        size_type i = pathIdx[depth];
+        if (inner->cnt < INNER_ORDER)
+        {
+            _arrInsert(inner->keys(),inner->cnt,i,std::move(sep));
+            _arrInsert(inner->children,inner->cnt+1,i+1,newNode);
+            ++inner->cnt;
+            return true;
+        }
+        // the middle key moves up; the keys after it go to the new node
+        size_type mid = INNER_ORDER / 2;
+        _Inner* rightInner = _newInner();
+        Key up( std::move(inner->keys()[mid]) );
+        _KeyRaw::destroy(inner->keys()+mid);
+        rightInner->cnt = uint32(INNER_ORDER-mid-1);
+        _KeyRaw::relocate_range(rightInner->keys(),inner->keys()+mid+1,rightInner->cnt);
+        for (size_type j = 0;j<=rightInner->cnt;j++)
+            rightInner->children[j] = inner->children[mid+1+j];
+        inner->cnt = uint32(mid);
+        if (i <= mid)
+        {
+            _arrInsert(inner->keys(),inner->cnt,i,std::move(sep));
+            _arrInsert(inner->children,inner->cnt+1,i+1,newNode);
+            ++inner->cnt;
+        }
+        else
+        {
+            _arrInsert(rightInner->keys(),rightInner->cnt,i-mid-1,std::move(sep));
+            _arrInsert(rightInner->children,rightInner->cnt+1,i-mid,newNode);
+            ++rightInner->cnt;
+        }
+        sep = std::move(up);
+        newNode = rightInner;
+    }
+    // the root was split: grow the tree by one level
+    _Inner* newRoot = _newInner();
+    _KeyRaw::construct(newRoot->keys(),sep);
+    newRoot->children[0] = _root;
+    newRoot->children[1] = newNode;
+    newRoot->cnt = 1;
+    _root = newRoot;
+    return true;
+}
+template<typename Key,typename Value,class Alloc>
+void rtypes::_btree<Key,Value,Alloc>::_remove(const Key& key)
+{
+    _Inner* path[_MAX_DEPTH];
+    size_type pathIdx[_MAX_DEPTH];
+    size_type depth = 0, pos;
+    _Node* node = _root;
+    _Leaf* leaf;
+    if (node == NULL)
+        return;
+    while (!node->leaf)
+    {
+        _Inner* inner = static_cast<_Inner*>(node);
+        size_type i = _upperIndex(inner->keys(),inner->cnt,key);
+        path[depth] = inner;
+        pathIdx[depth++] = i;
+        node = inner->children[i];
+    }
+    leaf = static_cast<_Leaf*>(node);
+    pos = _lowerIndex(leaf->keys(),leaf->cnt,key);
+    if (pos>=leaf->cnt || key<leaf->keys()[pos])
+        return;
+    _arrErase(leaf->keys(),leaf->cnt,pos);
+    _arrErase(leaf->values(),leaf->cnt,pos);
+    --leaf->cnt;
+    --_sz;
+    // restore the minimum fill on the way up; separators that
+    // equal the removed key remain valid and are left alone
+    while (depth > 0)
+    {
+        if (node->cnt >= (node->leaf ? size_type(_MIN_LEAF) : size_type(_MIN_INNER)))
+            break;
+        --depth;
+        _rebalance(path[depth],pathIdx[depth]);
+        node = path[depth];
+    }
+    if (_root->cnt == 0)
+    {
+        if (_root->leaf)
+        {
+            _freeLeaf(static_cast<_Leaf*>(_root));
+            _root = NULL;
+            _head = NULL;
+            _tail = NULL;
+        }
+        else
+        {
+            // the root has a single child left: shrink the tree by one level
+            _Inner* old = static_cast<_Inner*>(_root);
+            _root = old->children[0];
+            _freeInner(old);
+        }
+    }
+}
+template<typename Key,typename Value,class Alloc>
+template<class Source>
+void rtypes::_btree<Key,Value,Alloc>::_build(Source& src,size_type cnt)
+{
+    size_type n, leaves;
+    _Node** level;
+    const Key** mins; // smallest key of each subtree in 'level'
+    _Leaf* prev = NULL;
+    empty();
+    if (cnt == 0)
+        return;
+    // entries are spread evenly over the fewest leaves that hold them, so
+    // every leaf is (nearly) full and none falls below the minimum fill
+    leaves = (cnt+LEAF_ORDER-1) / LEAF_ORDER;
+    level = static_cast<_Node**>( _allocator().allocate(leaves*sizeof(_Node*)) );
+    mins = static_cast<const Key**>( _allocator().allocate(leaves*sizeof(const Key*)) );
+    for (size_type i = 0;i<leaves;i++)
+    {
+        size_type per = cnt/leaves + (i<cnt%leaves ? 1 : 0);
+        _Leaf* leaf = _newLeaf();
+        while (leaf->cnt < per)
+        {
+            src.next(leaf->keys()+leaf->cnt,leaf->values()+leaf->cnt);
+            ++leaf->cnt;
+        }
+        leaf->prev = prev;
+        if (prev != NULL)
+            prev->next = leaf;
+        else
+            _head = leaf;
+        prev = leaf;
+        level[i] = leaf;
+        mins[i] = leaf->keys();
+    }
+    _tail = prev;
+    _sz = cnt;
+    // build each inner level from the one below it in place
+    n = leaves;
+    while (n > 1)
+    {
+        size_type parents = (n+INNER_ORDER) / (INNER_ORDER+1), c = 0;
+        for (size_type i = 0;i<parents;i++)
+        {
+            size_type per = n/parents + (i<n%parents ? 1 : 0);
+            _Inner* inner = _newInner();
+            const Key* m = mins[c];
+            inner->children[0] = level[c];
+            for (size_type j = 1;j<per;j++)
+            {
+                _KeyRaw::construct(inner->keys()+j-1,*mins[c+j]);
+                inner->children[j] = level[c+j];
+            }
+            inner->cnt = uint32(per-1);
+            level[i] = inner;
+            mins[i] = m;
+            c += per;
+        }
+        n = parents;
+    }
+    _root = level[0];
+    _allocator().deallocate(mins,leaves*sizeof(const Key*));
+    _allocator().deallocate(level,leaves*sizeof(_Node*));
+}
+template<typename Key,typename Value,class Alloc>
+const typename rtypes::_btree<Key,Value,Alloc>::_Leaf* rtypes::_btree<Key,Value,Alloc>::_findLeaf(const Key& key) const
+{
+    const _Node* node = _root;
+    if (node == NULL)
+        return NULL;
+    while (!node->leaf)
+    {
+        const _Inner* inner = static_cast<const _Inner*>(node);
+        node = inner->children[_upperIndex(inner->keys(),inner->cnt,key)];
+    }
+    return static_cast<const _Leaf*>(node);
+}
+template<typename Key,typename Value,class Alloc>
+rtypes::size_type rtypes::_btree<Key,Value,Alloc>::_lowerIndex(const Key* keys,size_type cnt,const Key& key)
+{
+    // first index whose key is not less than 'key'; a node holds few
+    // enough keys that counting cheap keys without branches beats a
+    // binary search, whose branches are unpredictable
+    if (std::is_arithmetic<Key>::value)
+    {
+        size_type n = 0;
+        for (size_type i = 0;i<cnt;i++)
+            n += size_type(keys[i] < key);
+        return n;
+    }
+    size_type lo = 0, hi = cnt;
+    while (lo < hi)
+    {
+        size_type mid = (lo+hi) >> 1;
+        if (keys[mid] < key)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+template<typename Key,typename Value,class Alloc>
+rtypes::size_type rtypes::_btree<Key,Value,Alloc>::_upperIndex(const Key* keys,size_type cnt,const Key& key)
+{
+    // first index whose key is greater than 'key' (see _lowerIndex)
+    if (std::is_arithmetic<Key>::value)
+    {
+        size_type n = 0;
+        for (size_type i = 0;i<cnt;i++)
+            n += size_type(!(key < keys[i]));
+        return n;
+    }
+    size_type lo = 0, hi = cnt;
+    while (lo < hi)
+    {
+        size_type mid = (lo+hi) >> 1;
+        if (key < keys[mid])
+            hi = mid;
+        else
+            lo = mid+1;
+    }
+    return lo;
+}
+template<typename Key,typename Value,class Alloc>
+void rtypes::_btree<Key,Value,Alloc>::_rebalance(_Inner* parent,size_type i)
+{
+    // child 'i' of 'parent' is below the minimum fill: borrow an
+    // entry from a sibling that can spare one, or else merge
+    _Node* node = parent->children[i];
+    _Node* left = (i>0 ? parent->children[i-1] : NULL);
+    _Node* right = (i<parent->cnt ? parent->children[i+1] : NULL);
+    size_type minCnt = (node->leaf ? size_type(_MIN_LEAF) : size_type(_MIN_INNER));
+    if (left!=NULL && left->cnt>minCnt)
+    {
+        if (node->leaf)
+        {
+            _Leaf* l = static_cast<_Leaf*>(left), *n = static_cast<_Leaf*>(node);
+            _arrInsert(n->keys(),n->cnt,0,std::move(l->keys()[l->cnt-1]));
+            _arrInsert(n->values(),n->cnt,0,std::move(l->values()[l->cnt-1]));
+            --l->cnt;
+            _KeyRaw::destroy(l->keys()+l->cnt);
+            _ValueRaw::destroy(l->values()+l->cnt);
+            ++n->cnt;
+            parent->keys()[i-1] = n->keys()[0];
+        }
+        else
+        {
+            _Inner* l = static_cast<_Inner*>(left), *n = static_cast<_Inner*>(node);
+            _arrInsert(n->keys(),n->cnt,0,std::move(parent->keys()[i-1]));
+            _arrInsert(n->children,n->cnt+1,0,l->children[l->cnt]);
+            --l->cnt;
+            parent->keys()[i-1] = std::move(l->keys()[l->cnt]);
+            _KeyRaw::destroy(l->keys()+l->cnt);
+            ++n->cnt;
+        }
+    }
+    else if (right!=NULL && right->cnt>minCnt)
+    {
+        if (node->leaf)
+        {
+            _Leaf* r = static_cast<_Leaf*>(right), *n = static_cast<_Leaf*>(node);
+            _arrInsert(n->keys(),n->cnt,n->cnt,std::move(r->keys()[0]));
+            _arrInsert(n->values(),n->cnt,n->cnt,std::move(r->values()[0]));
+            _arrErase(r->keys(),r->cnt,0);
+            _arrErase(r->values(),r->cnt,0);
+            --r->cnt;
+            ++n->cnt;
+            parent->keys()[i] = r->keys()[0];
+        }
+        else
+        {
+            _Inner* r = static_cast<_Inner*>(right), *n = static_cast<_Inner*>(node);
+            _arrInsert(n->keys(),n->cnt,n->cnt,std::move(parent->keys()[i]));
+            n->children[n->cnt+1] = r->children[0];
+            parent->keys()[i] = std::move(r->keys()[0]);
+            _arrErase(r->keys(),r->cnt,0);
+            _arrErase(r->children,r->cnt+1,0);
+            --r->cnt;
+            ++n->cnt;
+        }
+    }
+    else if (left != NULL)
+        _merge(parent,i-1);
+    else
+        _merge(parent,i);
+}
+template<typename Key,typename Value,class Alloc>
+void rtypes::_btree<Key,Value,Alloc>::_merge(_Inner* parent,size_type i)
+{
+    // merge child i+1 of 'parent' into child i
+    _Node* left = parent->children[i];
+    _Node* right = parent->children[i+1];
+    if (left->leaf)
+    {
+        _Leaf* l = static_cast<_Leaf*>(left), *r = static_cast<_Leaf*>(right);
+        _KeyRaw::relocate_range(l->keys()+l->cnt,r->keys(),r->cnt);
+        _ValueRaw::relocate_range(l->values()+l->cnt,r->values(),r->cnt);
+        l->cnt += r->cnt;
+        l->next = r->next;
+        if (r->next != NULL)
+            r->next->prev = l;
+        else
+            _tail = l;
+        r->cnt = 0;
+        _freeLeaf(r);
+    }
+    else
+    {
+        // the separator comes down between the two halves
+        _Inner* l = static_cast<_Inner*>(left), *r = static_cast<_Inner*>(right);
+        _KeyRaw::construct(l->keys()+l->cnt,std::move(parent->keys()[i]));
+        _KeyRaw::relocate_range(l->keys()+l->cnt+1,r->keys(),r->cnt);
+        for (size_type j = 0;j<=r->cnt;j++)
+            l->children[l->cnt+1+j] = r->children[j];
+        l->cnt += r->cnt+1;
+        r->cnt = 0;
+        _freeInner(r);
+    }
+    _arrErase(parent->keys(),parent->cnt,i);
+    _arrErase(parent->children,parent->cnt+1,i+1);
+    --parent->cnt;
+}
+template<typename Key,typename Value,class Alloc>
+typename rtypes::_btree<Key,Value,Alloc>::_Leaf* rtypes::_btree<Key,Value,Alloc>::_newLeaf()
+{
+    _Leaf* leaf = new (_allocator().allocate(sizeof(_Leaf))) _Leaf;
+    leaf->cnt = 0;
+    leaf->leaf = 1;
+    leaf->prev = NULL;
+    leaf->next = NULL;
+    return leaf;
+}
+template<typename Key,typename Value,class Alloc>
+typename rtypes::_btree<Key,Value,Alloc>::_Inner* rtypes::_btree<Key,Value,Alloc>::_newInner()
+{
+    _Inner* inner = new (_allocator().allocate(sizeof(_Inner))) _Inner;
+    inner->cnt = 0;
+    inner->leaf = 0;
+    return inner;
+}
+template<typename Key,typename Value,class Alloc>
+void rtypes::_btree<Key,Value,Alloc>::_destroy(_Node* node)
+{
+    if (node->leaf)
+        _freeLeaf(static_cast<_Leaf*>(node));
+    else
+    {
+        _Inner* inner = static_cast<_Inner*>(node);
+        for (size_type i = 0;i<=inner->cnt;i++)
+            _destroy(inner->children[i]);
+        _freeInner(inner);
+    }
+}
+template<typename Key,typename Value,class Alloc>
+void rtypes::_btree<Key,Value,Alloc>::_freeLeaf(_Leaf* leaf)
+{
+    _KeyRaw::destroy_range(leaf->keys(),leaf->cnt);
+    _ValueRaw::destroy_range(leaf->values(),leaf->cnt);
+    leaf->~_Leaf();
+    _allocator().deallocate(leaf,sizeof(_Leaf));
+}
+template<typename Key,typename Value,class Alloc>
+void rtypes::_btree<Key,Value,Alloc>::_freeInner(_Inner* inner)
+{
+    _KeyRaw::destroy_range(inner->keys(),inner->cnt);
+    inner->~_Inner();
+    _allocator().deallocate(inner,sizeof(_Inner));
+}
+template<typename Key,typename Value,class Alloc>
+bool rtypes::_btree<Key,Value,Alloc>::_inLeaf(const _Leaf* leaf,const void* p)
+{
+    // (std::less orders unrelated pointers)
+    std::less<const void*> less;
+    return !less(p,leaf) && less(p,leaf+1);
+}
+template<typename Key,typename Value,class Alloc>
+template<typename E,typename U>
+void rtypes::_btree<Key,Value,Alloc>::_arrInsert(E* arr,size_type cnt,size_type pos,U&& elem)
+{
+    // open a hole at 'pos' and construct the element there
+    if (std::is_trivially_copyable<E>::value)
+    {
+        if (pos < cnt)
+            rutil_memmove(arr+pos+1,arr+pos,(cnt-pos)*sizeof(E));
+    }
+    else
+        for (size_type i = cnt;i>pos;i--)
+        {
+            new (arr+i) E( std::move(arr[i-1]) );
+            arr[i-1].~E();
+        }
+    new (arr+pos) E( std::forward<U>(elem) );
+}
+template<typename Key,typename Value,class Alloc>
+template<typename E>
+void rtypes::_btree<Key,Value,Alloc>::_arrErase(E* arr,size_type cnt,size_type pos)
+{
+    arr[pos].~E();
+    if (std::is_trivially_copyable<E>::value)
+    {
+        if (pos+1 < cnt)
+            rutil_memmove(arr+pos,arr+pos+1,(cnt-pos-1)*sizeof(E));
+    }
+    else
+        for (size_type i = pos+1;i<cnt;i++)
+        {
+            new (arr+i-1) E( std::move(arr[i]) );
+            arr[i].~E();
+        }
+}
+template<typename Key,typename Value,class Alloc>
+void rtypes::_btree<Key,Value,Alloc>::_CopySource::next(Key* key,Value* value)
+{
+    _KeyRaw::construct(key,leaf->keys()[idx]);
+    _ValueRaw::construct(value,leaf->values()[idx]);
+    if (++idx >= leaf->cnt)
+    {
+        leaf = leaf->next;
+        idx = 0;
+    }
+}
+
+// rtypes::tree_map<>
+template<typename Key,typename Value,class Alloc>
+Value& rtypes::tree_map<Key,Value,Alloc>::get(const Key& key)
+{
+    iterator iter = _Base::find(key);
+    if (iter == _Base::end())
+        throw element_not_found_error();
+    return iter.value();
+}
+template<typename Key,typename Value,class Alloc>
+const Value& rtypes::tree_map<Key,Value,Alloc>::get(const Key& key) const
+{
+    const_iterator iter = _Base::find(key);
+    if (iter == _Base::end())
+        throw element_not_found_error();
+    return iter.value();
+}
+template<typename Key,typename Value,class Alloc>
+void rtypes::tree_map<Key,Value,Alloc>::bulk_load(const Key* keys,const Value* values,size_type cnt)
+{
+    _ArraySource src;
+    for (size_type i = 1;i<cnt;i++)
+        if ( !(keys[i-1] < keys[i]) )
+            throw invalid_operation_error();
+    src.keys = keys;
+    src.values = values;
+    _Base::_build(src,cnt);
+}
+
+// rtypes::tree_set<>
+template<typename T,class Alloc>
+void rtypes::tree_set<T,Alloc>::bulk_load(const T* elems,size_type cnt)
+{
+    _ArraySource src;
+    for (size_type i = 1;i<cnt;i++)
+        if ( !(elems[i-1] < elems[i]) )
+            throw invalid_operation_error();
+    src.elems = elems;
+    _Base::_build(src,cnt);
+}
+template<typename T,class Alloc>
+bool rtypes::tree_set<T,Alloc>::operator ==(const tree_set& obj) const
+{
+    if (_Base::size() != obj.size())
+        return false;
+    // both sets iterate in order, so equal sets agree element-wise
+    for (const_iterator i = begin(), j = obj.begin();i!=end();++i,++j)
+        if (*i<*j || *j<*i)
+            return false;
+    return true;
+}
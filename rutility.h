@@ -7,24 +7,47 @@
 #define RUTILITY_H
 #include "rtypestypes.h"
 #include "rstring.h"
+#include "rmemory.h" // gets the block memory functions
 
 namespace rtypes
 {
+    /* cpu_features
+     *  the instruction set extensions that both the processor and the operating
+     * system support; kernels with vector variants choose one by these flags
+     */
+    struct cpu_features
+    {
+        bool sse2;
+        bool ssse3;
+        bool sse42;
+        bool avx2;
+    };
+
     // every utility function is prefixed 'rutil'
     void rutil_def_memory(void* pdata,size_type size,byte val = 0); // fills specified data with specified value
     bool rutil_strcmp(const char*,const char*); // compares two c-style strings
+    bool rutil_strcmp(const string_ref&,const string_ref&); // compares two character sequences of known length
     bool rutil_strncmp(const char*,const char*,size_type n); // compares two c-style strings up to the specified number of characters
     size_type rutil_strlen(const char*); // returns length of c-style strings
     size_type rutil_strcpy(char* buffer,const char* source); // copies source into buffer; returns number of copied chars
     size_type rutil_strncpy(char* buffer,const char* source,size_type n); // copies n-chars or strlen(source) from source into buffer; returns number of copied chars
     str rutil_to_lower(const char*); // return lower-case string variant
     str rutil_to_lower(const generic_string&);
+    str rutil_to_lower(const string_ref&);
     void rutil_to_lower_ref(generic_string&); // change string to lower-case variant
     str rutil_to_upper(const char*); // return upper-case string variant
     str rutil_to_upper(const generic_string&);
+    str rutil_to_upper(const string_ref&);
     void rutil_to_upper_ref(generic_string&); // change string to upper-case variant
     str rutil_strip_whitespace(const generic_string&); // return string variant minus leading and trailing whitespace
+    str rutil_strip_whitespace(const string_ref&);
     void rutil_strip_whitespace_ref(generic_string&); // change string to variant minus leading and trailing whitespace
+    bool rutil_utf8_validate(const string_ref&,size_type* validLength = NULL); // checks for well-formed UTF-8; optionally gets the length of the longest well-formed prefix
+    str rutil_utf8_repair(const string_ref&); // return UTF-8 variant with each ill-formed sequence replaced by U+FFFD
+    void rutil_utf8_repair_ref(generic_string&); // change string to UTF-8 variant with each ill-formed sequence replaced by U+FFFD
+    wstr rutil_utf8_to_wstr(const string_ref&); // decodes UTF-8 into UTF-32 (UTF-16 where wchar_t has 16 bits); ill-formed sequences decode to U+FFFD
+    str rutil_wstr_to_utf8(const wstring_ref&); // encodes a wide string as UTF-8; unpaired surrogates and out of range values encode U+FFFD
+    const cpu_features& rutil_cpu_features(); // detects the features once (on the first call); all false for non-x86 targets
 }
 
 #endif
@@ -0,0 +1,47 @@
+#include "rutility.h"
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define RUTIL_CPUID_MSVC
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RUTIL_CPUID_GNU
+#endif
+using namespace rtypes;
+
+static cpu_features detect_cpu_features()
+{
+    cpu_features features;
+    features.sse2 = false;
+    features.ssse3 = false;
+    features.sse42 = false;
+    features.avx2 = false;
+#if defined(RUTIL_CPUID_GNU)
+    // (these also check that the system saves the AVX registers)
+    __builtin_cpu_init();
+    features.sse2 = __builtin_cpu_supports("sse2") != 0;
+    features.ssse3 = __builtin_cpu_supports("ssse3") != 0;
+    features.sse42 = __builtin_cpu_supports("sse4.2") != 0;
+    features.avx2 = __builtin_cpu_supports("avx2") != 0;
+#elif defined(RUTIL_CPUID_MSVC)
+    int info[4];
+    __cpuid(info,0);
+    int maxLeaf = info[0];
+    __cpuid(info,1);
+    features.sse2 = (info[3] & (1<<26)) != 0;
+    features.ssse3 = (info[2] & (1<<9)) != 0;
+    features.sse42 = (info[2] & (1<<20)) != 0;
+    // the system must save the AVX registers (OSXSAVE and XCR0 bits 1 and 2)
+    bool avxState = (info[2] & (1<<27))!=0 && (info[2] & (1<<28))!=0 && (_xgetbv(0) & 6)==6;
+    if (maxLeaf>=7 && avxState)
+    {
+        __cpuidex(info,7,0);
+        features.avx2 = (info[1] & (1<<5)) != 0;
+    }
+#endif
+    return features;
+}
+
+const cpu_features& rtypes::rutil_cpu_features()
+{
+    static const cpu_features features = detect_cpu_features();
+    return features;
+}
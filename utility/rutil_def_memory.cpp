@@ -3,7 +3,5 @@ using namespace rtypes;
 
 void rtypes::rutil_def_memory(void* pdata,size_type size,byte val)
 {
-    byte* p = reinterpret_cast<byte*> (pdata);
-    for (size_type cnt = 0;cnt<size;cnt++,p++)
-        *p = val;
+    rutil_memfill(pdata,size,val);
 }
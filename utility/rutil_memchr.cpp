@@ -0,0 +1,8 @@
+#include "rutility.h"
+using namespace rtypes;
+
+const void* rtypes::rutil_memchr(const void* pdata,size_type size,byte val)
+{
+    // this is the single character search used by the strings
+    return _rstring_find(static_cast<const char*>(pdata),size,char(val));
+}
@@ -0,0 +1,78 @@
+#include "rutility.h"
+#include "../impl/simd.h"
+using namespace rtypes;
+using namespace rtypes::rimpl;
+
+typedef int (*compare_kernel)(const byte*,const byte*,size_type);
+
+static int compare_bytes(const byte* a,const byte* b,size_type n)
+{
+    for (size_type i = 0;i<n;i++)
+        if (a[i] != b[i])
+            return int(a[i]) - int(b[i]);
+    return 0;
+}
+
+#ifdef RLIB_SIMD_SSE2
+static int compare_sse2(const byte* a,const byte* b,size_type n)
+{
+    // find the first block that differs and order by its first differing byte
+    size_type i = 0;
+    for (;i+16<=n;i+=16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a+i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b+i));
+        uint32 mask = ~uint32( _mm_movemask_epi8(_mm_cmpeq_epi8(x,y)) ) & 0xffff;
+        if (mask != 0)
+        {
+            i += lowest_bit(mask);
+            return int(a[i]) - int(b[i]);
+        }
+    }
+    return compare_bytes(a+i,b+i,n-i);
+}
+#endif
+
+#ifdef RLIB_SIMD_AVX2
+RLIB_AVX2_FUNCTION static int compare_avx2(const byte* a,const byte* b,size_type n)
+{
+    avx2_scope scope;
+    size_type i = 0;
+    for (;i+32<=n;i+=32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b+i));
+        uint32 mask = ~uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(x,y)) );
+        if (mask != 0)
+        {
+            i += lowest_bit(mask);
+            return int(a[i]) - int(b[i]);
+        }
+    }
+    scope.leave();
+    return compare_sse2(a+i,b+i,n-i);
+}
+#endif
+
+static compare_kernel select_compare()
+{
+#ifdef RLIB_SIMD_AVX2
+    if (rutil_cpu_features().avx2)
+        return &compare_avx2;
+#endif
+#ifdef RLIB_SIMD_SSE2
+    return &compare_sse2;
+#else
+    return &compare_bytes;
+#endif
+}
+
+int rtypes::rutil_memcmp(const void* pa,const void* pb,size_type size)
+{
+    const byte* a = static_cast<const byte*>(pa);
+    const byte* b = static_cast<const byte*>(pb);
+    if (size < 16)
+        return compare_bytes(a,b,size);
+    static const compare_kernel kernel = select_compare();
+    return kernel(a,b,size);
+}
@@ -0,0 +1,223 @@
+#include "rutility.h"
+#include "../impl/simd.h"
+#include <cstring>
+using namespace rtypes;
+using namespace rtypes::rimpl;
+
+// copies at least this large stream past the cache when the blocks do not overlap
+static const size_type LARGE_COPY = size_type(4) << 20;
+
+// (every kernel reads all of the source bytes that it will write before
+// writing over any of them, or copies in the direction that leaves the
+// unread source intact, so the kernels also serve overlapping blocks)
+
+typedef void (*copy_kernel)(byte*,const byte*,size_type);
+
+static void copy_small(byte* d,const byte* s,size_type n)
+{
+    // copy 0 to 16 bytes with a pair of (possibly overlapping) loads and stores
+    if (n >= 8)
+    {
+        uint64 a, b;
+        std::memcpy(&a,s,8);
+        std::memcpy(&b,s+n-8,8);
+        std::memcpy(d,&a,8);
+        std::memcpy(d+n-8,&b,8);
+    }
+    else if (n >= 4)
+    {
+        uint32 a, b;
+        std::memcpy(&a,s,4);
+        std::memcpy(&b,s+n-4,4);
+        std::memcpy(d,&a,4);
+        std::memcpy(d+n-4,&b,4);
+    }
+    else if (n > 0)
+    {
+        byte a = s[0], b = s[n/2], c = s[n-1];
+        d[0] = a;
+        d[n/2] = b;
+        d[n-1] = c;
+    }
+}
+
+#ifndef RLIB_SIMD_SSE2
+static void copy_forward_words(byte* d,const byte* s,size_type n)
+{
+    if (n <= 16)
+    {
+        copy_small(d,s,n);
+        return;
+    }
+    size_type i = 0;
+    for (;i+8<=n;i+=8)
+    {
+        uint64 w;
+        std::memcpy(&w,s+i,8);
+        std::memcpy(d+i,&w,8);
+    }
+    for (;i<n;i++)
+        d[i] = s[i];
+}
+static void copy_backward_words(byte* d,const byte* s,size_type n)
+{
+    if (n <= 16)
+    {
+        copy_small(d,s,n);
+        return;
+    }
+    for (;n>=8;n-=8)
+    {
+        uint64 w;
+        std::memcpy(&w,s+n-8,8);
+        std::memcpy(d+n-8,&w,8);
+    }
+    while (n > 0)
+    {
+        --n;
+        d[n] = s[n];
+    }
+}
+#endif
+
+#ifdef RLIB_SIMD_SSE2
+static void copy_forward_sse2(byte* d,const byte* s,size_type n)
+{
+    if (n <= 16)
+    {
+        copy_small(d,s,n);
+        return;
+    }
+    // the first and last 16 bytes are copied unaligned; in between the
+    // stores are aligned to the destination
+    __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s+n-16));
+    size_type i = 16-misalignment(d,16), last = n-16;
+    bool stream = n>=LARGE_COPY && (d+n<=s || s+n<=d);
+    if (stream)
+    {
+        for (;i<last;i+=16)
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d+i),_mm_loadu_si128(reinterpret_cast<const __m128i*>(s+i)));
+        _mm_sfence();
+    }
+    else
+        for (;i<last;i+=16)
+            _mm_store_si128(reinterpret_cast<__m128i*>(d+i),_mm_loadu_si128(reinterpret_cast<const __m128i*>(s+i)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d),head);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d+n-16),tail);
+}
+static void copy_backward_sse2(byte* d,const byte* s,size_type n)
+{
+    if (n <= 16)
+    {
+        copy_small(d,s,n);
+        return;
+    }
+    __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s+n-16));
+    // 'i' is the end of the next aligned block to store
+    size_type i = n-misalignment(d+n,16);
+    for (;i>16;i-=16)
+        _mm_store_si128(reinterpret_cast<__m128i*>(d+i-16),_mm_loadu_si128(reinterpret_cast<const __m128i*>(s+i-16)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d),head);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d+n-16),tail);
+}
+#endif
+
+#ifdef RLIB_SIMD_AVX2
+RLIB_AVX2_FUNCTION static void copy_forward_avx2(byte* d,const byte* s,size_type n)
+{
+    avx2_scope scope;
+    if (n <= 32)
+    {
+        copy_forward_sse2(d,s,n);
+        return;
+    }
+    __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+    __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s+n-32));
+    size_type i = 32-misalignment(d,32), last = n-32;
+    bool stream = n>=LARGE_COPY && (d+n<=s || s+n<=d);
+    if (stream)
+    {
+        for (;i<last;i+=32)
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d+i),_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s+i)));
+        _mm_sfence();
+    }
+    else
+        for (;i<last;i+=32)
+            _mm256_store_si256(reinterpret_cast<__m256i*>(d+i),_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s+i)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d),head);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d+n-32),tail);
+}
+RLIB_AVX2_FUNCTION static void copy_backward_avx2(byte* d,const byte* s,size_type n)
+{
+    avx2_scope scope;
+    if (n <= 32)
+    {
+        copy_backward_sse2(d,s,n);
+        return;
+    }
+    __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+    __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s+n-32));
+    size_type i = n-misalignment(d+n,32);
+    for (;i>32;i-=32)
+        _mm256_store_si256(reinterpret_cast<__m256i*>(d+i-32),_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s+i-32)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d),head);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d+n-32),tail);
+}
+#endif
+
+struct copy_kernels
+{
+    copy_kernel forward;
+    copy_kernel backward;
+};
+
+static copy_kernels select_copy()
+{
+    copy_kernels kernels;
+#ifdef RLIB_SIMD_AVX2
+    if (rutil_cpu_features().avx2)
+    {
+        kernels.forward = &copy_forward_avx2;
+        kernels.backward = &copy_backward_avx2;
+        return kernels;
+    }
+#endif
+#ifdef RLIB_SIMD_SSE2
+    kernels.forward = &copy_forward_sse2;
+    kernels.backward = &copy_backward_sse2;
+#else
+    kernels.forward = &copy_forward_words;
+    kernels.backward = &copy_backward_words;
+#endif
+    return kernels;
+}
+static const copy_kernels& get_copy()
+{
+    static const copy_kernels kernels = select_copy();
+    return kernels;
+}
+
+void* rtypes::rutil_memcpy(void* pdest,const void* psource,size_type size)
+{
+    byte* d = static_cast<byte*>(pdest);
+    const byte* s = static_cast<const byte*>(psource);
+    if (size <= 16)
+        copy_small(d,s,size);
+    else
+        get_copy().forward(d,s,size);
+    return pdest;
+}
+void* rtypes::rutil_memmove(void* pdest,const void* psource,size_type size)
+{
+    byte* d = static_cast<byte*>(pdest);
+    const byte* s = static_cast<const byte*>(psource);
+    if (size <= 16)
+        copy_small(d,s,size);
+    else if (d<=s || d>=s+size)
+        get_copy().forward(d,s,size);
+    else // copy from the end so that the overlap is read before it is written
+        get_copy().backward(d,s,size);
+    return pdest;
+}
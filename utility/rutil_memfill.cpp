@@ -0,0 +1,115 @@
+#include "rutility.h"
+#include "../impl/simd.h"
+#include <cstring>
+using namespace rtypes;
+using namespace rtypes::rimpl;
+
+// fills at least this large stream past the cache
+static const size_type LARGE_FILL = size_type(4) << 20;
+
+typedef void (*fill_kernel)(byte*,size_type,byte);
+
+static void fill_small(byte* p,size_type n,byte val)
+{
+    // fill 0 to 16 bytes with a pair of (possibly overlapping) stores
+    if (n >= 8)
+    {
+        uint64 w = uint64(val) * 0x0101010101010101ull;
+        std::memcpy(p,&w,8);
+        std::memcpy(p+n-8,&w,8);
+    }
+    else if (n >= 4)
+    {
+        uint32 w = uint32(val) * 0x01010101u;
+        std::memcpy(p,&w,4);
+        std::memcpy(p+n-4,&w,4);
+    }
+    else if (n > 0)
+    {
+        p[0] = val;
+        p[n/2] = val;
+        p[n-1] = val;
+    }
+}
+
+#ifndef RLIB_SIMD_SSE2
+static void fill_words(byte* p,size_type n,byte val)
+{
+    uint64 w = uint64(val) * 0x0101010101010101ull;
+    size_type i = 0;
+    for (;i+8<=n;i+=8)
+        std::memcpy(p+i,&w,8);
+    fill_small(p+i,n-i,val);
+}
+#endif
+
+#ifdef RLIB_SIMD_SSE2
+static void fill_sse2(byte* p,size_type n,byte val)
+{
+    // the first and last 16 bytes are stored unaligned
+    // and the blocks in between are aligned
+    __m128i v = _mm_set1_epi8(char(val));
+    size_type i = 16-misalignment(p,16), last = n-16;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p),v);
+    if (n >= LARGE_FILL)
+    {
+        for (;i<last;i+=16)
+            _mm_stream_si128(reinterpret_cast<__m128i*>(p+i),v);
+        _mm_sfence();
+    }
+    else
+        for (;i<last;i+=16)
+            _mm_store_si128(reinterpret_cast<__m128i*>(p+i),v);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p+last),v);
+}
+#endif
+
+#ifdef RLIB_SIMD_AVX2
+RLIB_AVX2_FUNCTION static void fill_avx2(byte* p,size_type n,byte val)
+{
+    avx2_scope scope;
+    if (n <= 32)
+    {
+        fill_sse2(p,n,val);
+        return;
+    }
+    __m256i v = _mm256_set1_epi8(char(val));
+    size_type i = 32-misalignment(p,32), last = n-32;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p),v);
+    if (n >= LARGE_FILL)
+    {
+        for (;i<last;i+=32)
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(p+i),v);
+        _mm_sfence();
+    }
+    else
+        for (;i<last;i+=32)
+            _mm256_store_si256(reinterpret_cast<__m256i*>(p+i),v);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p+last),v);
+}
+#endif
+
+static fill_kernel select_fill()
+{
+#ifdef RLIB_SIMD_AVX2
+    if (rutil_cpu_features().avx2)
+        return &fill_avx2;
+#endif
+#ifdef RLIB_SIMD_SSE2
+    return &fill_sse2;
+#else
+    return &fill_words;
+#endif
+}
+
+void rtypes::rutil_memfill(void* pdata,size_type size,byte val)
+{
+    byte* p = static_cast<byte*>(pdata);
+    if (size <= 16)
+    {
+        fill_small(p,size,val);
+        return;
+    }
+    static const fill_kernel kernel = select_fill();
+    kernel(p,size,val);
+}
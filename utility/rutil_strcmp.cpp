@@ -1,10 +1,107 @@
 #include "rutility.h"
+#include "../impl/simd.h"
 using namespace rtypes;
+using namespace rtypes::rimpl;
 
-// compare c-style strings
-bool rtypes::rutil_strcmp(const char* pa,const char* pb)
+typedef bool (*strcmp_kernel)(const char*,const char*);
+
+#ifndef RLIB_SIMD_SSE2
+static bool strcmp_bytes(const char* pa,const char* pb)
 {
     while (*pa && *pb && (*pa==*pb))
         ++pa, ++pb;
     return *pa==0 && *pb==0;
 }
+#endif
+
+// (the vector kernels compare whole blocks only where neither string's block
+// crosses a page boundary, so they may read past the null terminators)
+
+#ifdef RLIB_SIMD_SSE2
+RLIB_BLOCK_READS static bool strcmp_sse2(const char* pa,const char* pb)
+{
+    __m128i zero = _mm_setzero_si128();
+    while (true)
+    {
+        if (on_one_page(pa,16) && on_one_page(pb,16))
+        {
+            // stop at the first null terminator or difference
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pa));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb));
+            uint32 mask = uint32( _mm_movemask_epi8(_mm_cmpeq_epi8(a,zero)) )
+                | (~uint32( _mm_movemask_epi8(_mm_cmpeq_epi8(a,b)) ) & 0xffff);
+            if (mask != 0)
+            {
+                size_type i = lowest_bit(mask);
+                return pa[i] == pb[i];
+            }
+            pa += 16, pb += 16;
+        }
+        else
+        {
+            if (*pa != *pb)
+                return false;
+            if (*pa == 0)
+                return true;
+            ++pa, ++pb;
+        }
+    }
+}
+#endif
+
+#ifdef RLIB_SIMD_AVX2
+RLIB_AVX2_FUNCTION RLIB_BLOCK_READS static bool strcmp_avx2(const char* pa,const char* pb)
+{
+    avx2_scope scope;
+    __m256i zero = _mm256_setzero_si256();
+    while (true)
+    {
+        if (on_one_page(pa,32) && on_one_page(pb,32))
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pa));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pb));
+            uint32 mask = uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(a,zero)) )
+                | ~uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(a,b)) );
+            if (mask != 0)
+            {
+                size_type i = lowest_bit(mask);
+                return pa[i] == pb[i];
+            }
+            pa += 32, pb += 32;
+        }
+        else
+        {
+            if (*pa != *pb)
+                return false;
+            if (*pa == 0)
+                return true;
+            ++pa, ++pb;
+        }
+    }
+}
+#endif
+
+static strcmp_kernel select_strcmp()
+{
+#ifdef RLIB_SIMD_AVX2
+    if (rutil_cpu_features().avx2)
+        return &strcmp_avx2;
+#endif
+#ifdef RLIB_SIMD_SSE2
+    return &strcmp_sse2;
+#else
+    return &strcmp_bytes;
+#endif
+}
+
+// compare c-style strings
+bool rtypes::rutil_strcmp(const char* pa,const char* pb)
+{
+    static const strcmp_kernel kernel = select_strcmp();
+    return kernel(pa,pb);
+}
+bool rtypes::rutil_strcmp(const string_ref& a,const string_ref& b)
+{
+    // the lengths are known, so unequal lengths need no scan
+    return a == b;
+}
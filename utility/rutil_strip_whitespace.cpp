@@ -1,45 +1,77 @@
 #include "rutility.h"
+#include "../impl/simd.h"
 using namespace rtypes;
+using namespace rtypes::rimpl;
 
 static inline bool is_space(char c)
 {
     return c==' ' || c=='\t' || c=='\n' || c=='\r';
 }
 
+#ifdef RLIB_SIMD_SSE2
+// returns a mask with bit i set if p[i] is not whitespace
+static inline uint32 non_space_sse2(const char* p)
+{
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x,_mm_set1_epi8(' ')),_mm_cmpeq_epi8(x,_mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(x,_mm_set1_epi8('\n')),_mm_cmpeq_epi8(x,_mm_set1_epi8('\r'))));
+    return ~uint32( _mm_movemask_epi8(space) ) & 0xffff;
+}
+#endif
+
+// returns the bounds [i,j) of 'item' without its leading and
+// trailing whitespace; whitespace runs are checked 16 bytes at a time
+static void find_bounds(const string_ref& item,size_type& i,size_type& j)
+{
+    const char* p = item.data();
+    i = 0;
+    j = item.length();
+#ifdef RLIB_SIMD_SSE2
+    for (;i+16<=j;i+=16)
+    {
+        uint32 mask = non_space_sse2(p+i);
+        if (mask != 0)
+        {
+            i += lowest_bit(mask);
+            break;
+        }
+    }
+#endif
+    while (i<j && is_space(p[i]))
+        ++i;
+#ifdef RLIB_SIMD_SSE2
+    for (;j>=i+16;j-=16)
+    {
+        uint32 mask = non_space_sse2(p+j-16);
+        if (mask != 0)
+        {
+            j -= 15-highest_bit(mask);
+            break;
+        }
+    }
+#endif
+    while (j>i && is_space(p[j-1]))
+        --j;
+}
+
 str rtypes::rutil_strip_whitespace(const generic_string& item)
 {
-    str tmp;
+    return rutil_strip_whitespace( string_ref(item) );
+}
+str rtypes::rutil_strip_whitespace(const string_ref& item)
+{
+    // find the bounds first so that the result is copied once
     size_type i, j;
-    if (item.length() > 0) {
-        i = 0;
-        while (i<item.length() && is_space(item[i]))
-            ++i;
-        j = item.length();
-        while (j>0 && is_space(item[j-1]))
-            --j;
-        for (;i<j;i++)
-            tmp.push_back(item[i]);
-    }
-    return tmp;
+    find_bounds(item,i,j);
+    return str( item.substr(i,j-i) );
 }
 
 void rtypes::rutil_strip_whitespace_ref(generic_string& item)
 {
-    str tmp;
     size_type i, j;
-    if (item.length() > 0) {
-        i = 0;
-        while (i<item.length() && is_space(item[i]))
-            ++i;
-        j = item.length();
-        while (j>0 && is_space(item[j-1]))
-            --j;
-        if (i > 0) {
-            for (;i<j;i++)
-                tmp.push_back(item[i]);
-            item = tmp;
-        }
-        else
-            item.resize(j);
-    }
+    find_bounds(item,i,j);
+    if (i > 0) // move the characters down in one copy
+        item = string_ref(item).substr(i,j-i);
+    else if (j < item.length())
+        item.resize(j);
 }
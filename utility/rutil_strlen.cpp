@@ -1,10 +1,111 @@
 #include "rutility.h"
+#include "../impl/simd.h"
+#include <cstring>
 using namespace rtypes;
+using namespace rtypes::rimpl;
+
+typedef size_type (*strlen_kernel)(const char*);
+
+// (these read whole aligned words or vectors, which never cross
+// a page boundary, so they may read past the null terminator)
+
+#ifndef RLIB_SIMD_SSE2
+RLIB_BLOCK_READS static size_type strlen_words(const char* pstring)
+{
+    // a word has a zero byte if subtracting one from each byte
+    // borrows into the high bit of a byte whose high bit was clear
+    const size_type ONES = ~size_type(0)/0xff, HIGHS = ONES*0x80;
+    const char* p = pstring;
+    for (;misalignment(p,sizeof(size_type))!=0;++p)
+        if (*p == 0)
+            return size_type(p-pstring);
+    while (true)
+    {
+        size_type w;
+        std::memcpy(&w,p,sizeof(size_type));
+        if (((w-ONES) & ~w & HIGHS) != 0)
+            break;
+        p += sizeof(size_type);
+    }
+    while (*p)
+        ++p;
+    return size_type(p-pstring);
+}
+#endif
+
+#ifdef RLIB_SIMD_SSE2
+RLIB_BLOCK_READS static size_type strlen_sse2(const char* pstring)
+{
+    // start at the vector that holds the first character and
+    // ignore the bytes that come before it
+    size_type off = misalignment(pstring,16);
+    const char* p = pstring-off;
+    __m128i zero = _mm_setzero_si128();
+    uint32 mask = uint32( _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(p)),zero)) ) >> off;
+    if (mask != 0)
+        return lowest_bit(mask);
+    while (true)
+    {
+        p += 16;
+        mask = uint32( _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(p)),zero)) );
+        if (mask != 0)
+            return size_type(p-pstring) + lowest_bit(mask);
+    }
+}
+#endif
+
+#ifdef RLIB_SIMD_AVX2
+RLIB_AVX2_FUNCTION RLIB_BLOCK_READS static size_type strlen_avx2(const char* pstring)
+{
+    avx2_scope scope;
+    size_type off = misalignment(pstring,32);
+    const char* p = pstring-off;
+    __m256i zero = _mm256_setzero_si256();
+    uint32 mask = uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(p)),zero)) ) >> off;
+    if (mask != 0)
+        return lowest_bit(mask);
+    p += 32;
+    if (misalignment(p,64) != 0)
+    {
+        mask = uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(p)),zero)) );
+        if (mask != 0)
+            return size_type(p-pstring) + lowest_bit(mask);
+        p += 32;
+    }
+    // test an aligned 64-byte block at a time through the minimum of its
+    // halves, which has a zero byte where either half does
+    while (true)
+    {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(p+32));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(a,b),zero)) != 0)
+        {
+            mask = uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(a,zero)) );
+            if (mask != 0)
+                return size_type(p-pstring) + lowest_bit(mask);
+            mask = uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(b,zero)) );
+            return size_type(p+32-pstring) + lowest_bit(mask);
+        }
+        p += 64;
+    }
+}
+#endif
+
+static strlen_kernel select_strlen()
+{
+#ifdef RLIB_SIMD_AVX2
+    if (rutil_cpu_features().avx2)
+        return &strlen_avx2;
+#endif
+#ifdef RLIB_SIMD_SSE2
+    return &strlen_sse2;
+#else
+    return &strlen_words;
+#endif
+}
 
 size_type rtypes::rutil_strlen(const char* pstring)
 {
-    size_type len = 0;
-    while (pstring[len])
-        ++len;
-    return len;
+    static const strlen_kernel kernel = select_strlen();
+    return kernel(pstring);
 }
@@ -1,7 +1,11 @@
 #include "rutility.h"
+#include "../impl/simd.h"
 using namespace rtypes;
+using namespace rtypes::rimpl;
 
-size_type rtypes::rutil_strncpy(char* buffer,const char* source,size_type n)
+typedef size_type (*strncpy_kernel)(char*,const char*,size_type);
+
+static size_type strncpy_bytes(char* buffer,const char* source,size_type n)
 {
     size_type i = 0;
     while (i < n)
@@ -17,3 +21,81 @@ size_type rtypes::rutil_strncpy(char* buffer,const char* source,size_type n)
     }
     return i;
 }
+
+// (the vector kernels read whole blocks of the source where they do not cross
+// a page boundary, so they may read past the null terminator; they write
+// whole blocks only when the block has no null terminator)
+
+#ifdef RLIB_SIMD_SSE2
+RLIB_BLOCK_READS static size_type strncpy_sse2(char* buffer,const char* source,size_type n)
+{
+    __m128i zero = _mm_setzero_si128();
+    size_type i = 0;
+    while (i+16 <= n)
+    {
+        if ( on_one_page(source+i,16) )
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source+i));
+            uint32 mask = uint32( _mm_movemask_epi8(_mm_cmpeq_epi8(x,zero)) );
+            if (mask != 0)
+                return i + strncpy_bytes(buffer+i,source+i,lowest_bit(mask)+1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer+i),x);
+            i += 16;
+        }
+        else
+        {
+            if ((buffer[i] = source[i]) == 0)
+                return i;
+            ++i;
+        }
+    }
+    return i + strncpy_bytes(buffer+i,source+i,n-i);
+}
+#endif
+
+#ifdef RLIB_SIMD_AVX2
+RLIB_AVX2_FUNCTION RLIB_BLOCK_READS static size_type strncpy_avx2(char* buffer,const char* source,size_type n)
+{
+    avx2_scope scope;
+    __m256i zero = _mm256_setzero_si256();
+    size_type i = 0;
+    while (i+32 <= n)
+    {
+        if ( on_one_page(source+i,32) )
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source+i));
+            uint32 mask = uint32( _mm256_movemask_epi8(_mm256_cmpeq_epi8(x,zero)) );
+            if (mask != 0)
+                return i + strncpy_bytes(buffer+i,source+i,lowest_bit(mask)+1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer+i),x);
+            i += 32;
+        }
+        else
+        {
+            if ((buffer[i] = source[i]) == 0)
+                return i;
+            ++i;
+        }
+    }
+    return i + strncpy_sse2(buffer+i,source+i,n-i);
+}
+#endif
+
+static strncpy_kernel select_strncpy()
+{
+#ifdef RLIB_SIMD_AVX2
+    if (rutil_cpu_features().avx2)
+        return &strncpy_avx2;
+#endif
+#ifdef RLIB_SIMD_SSE2
+    return &strncpy_sse2;
+#else
+    return &strncpy_bytes;
+#endif
+}
+
+size_type rtypes::rutil_strncpy(char* buffer,const char* source,size_type n)
+{
+    static const strncpy_kernel kernel = select_strncpy();
+    return kernel(buffer,source,n);
+}
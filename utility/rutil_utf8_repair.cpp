@@ -0,0 +1,51 @@
+#include "rutility.h"
+#include "../impl/utf8.h"
+using namespace rtypes;
+
+// appends 'p' to 'result' with each ill-formed sequence replaced by U+FFFD;
+// well-formed spans are appended whole
+static void append_repaired(generic_string& result,const char* p,size_type n,size_type i)
+{
+    static const char REPLACEMENT[] = "\xef\xbf\xbd";
+    size_type start = 0;
+    while (i < n)
+    {
+        if (byte(p[i]) < 0x80)
+        {
+            i += rimpl::ascii_length(p+i,n-i);
+            continue;
+        }
+        uint32 cp;
+        size_type len;
+        if ( !rimpl::utf8_decode(p+i,n-i,cp,len) )
+        {
+            result.append( string_ref(p+start,i-start) );
+            result.append( string_ref(REPLACEMENT,3) );
+            start = i+len;
+        }
+        i += len;
+    }
+    result.append( string_ref(p+start,n-start) );
+}
+
+// return variant with ill-formed UTF-8 sequences replaced
+str rtypes::rutil_utf8_repair(const string_ref& s)
+{
+    size_type valid;
+    if ( rutil_utf8_validate(s,&valid) )
+        return str(s);
+    str result;
+    append_repaired(result,s.data(),s.size(),valid);
+    return result;
+}
+
+// change string to variant with ill-formed UTF-8 sequences replaced
+void rtypes::rutil_utf8_repair_ref(generic_string& sobj)
+{
+    size_type valid;
+    if ( rutil_utf8_validate(sobj,&valid) )
+        return;
+    str result;
+    append_repaired(result,sobj.c_str(),sobj.length(),valid);
+    sobj = result;
+}
@@ -0,0 +1,34 @@
+#include "rutility.h"
+#include "../impl/utf8.h"
+using namespace rtypes;
+
+// decode UTF-8 into a wide string
+wstr rtypes::rutil_utf8_to_wstr(const string_ref& s)
+{
+    // each byte decodes to at most one wide character (a four-byte
+    // sequence makes a surrogate pair at most) so the input's length
+    // bounds the result's
+    const char* p = s.data();
+    size_type n = s.size(), i = 0, j = 0;
+    wstr result;
+    result.resize(n);
+    wchar_t* dest = &result[0];
+    while (i < n)
+    {
+        if (byte(p[i]) < 0x80)
+        {
+            size_type k = rimpl::widen_ascii(dest+j,p+i,n-i);
+            i += k;
+            j += k;
+            continue;
+        }
+        uint32 cp;
+        size_type len;
+        if ( !rimpl::utf8_decode(p+i,n-i,cp,len) )
+            cp = rimpl::REPLACEMENT_CHARACTER;
+        j += rimpl::wide_encode(dest+j,cp);
+        i += len;
+    }
+    result.truncate(j);
+    return result;
+}
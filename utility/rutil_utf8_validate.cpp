@@ -0,0 +1,31 @@
+#include "rutility.h"
+#include "../impl/utf8.h"
+using namespace rtypes;
+
+// check that a character sequence is well-formed UTF-8
+bool rtypes::rutil_utf8_validate(const string_ref& s,size_type* validLength)
+{
+    const char* p = s.data();
+    size_type n = s.size(), i = 0;
+    bool valid = true;
+    while (i < n)
+    {
+        // skip runs of ASCII in blocks; other sequences are decoded one at a time
+        if (byte(p[i]) < 0x80)
+        {
+            i += rimpl::ascii_length(p+i,n-i);
+            continue;
+        }
+        uint32 cp;
+        size_type len;
+        if ( !rimpl::utf8_decode(p+i,n-i,cp,len) )
+        {
+            valid = false;
+            break;
+        }
+        i += len;
+    }
+    if (validLength != NULL)
+        *validLength = i;
+    return valid;
+}
@@ -0,0 +1,36 @@
+#include "rutility.h"
+#include "../impl/utf8.h"
+using namespace rtypes;
+
+// encode a wide string as UTF-8
+str rtypes::rutil_wstr_to_utf8(const wstring_ref& s)
+{
+    // the result starts out sized for ASCII text and grows when other
+    // characters need more room
+    const wchar_t* p = s.data();
+    size_type n = s.size(), i = 0, j = 0;
+    str result;
+    result.resize(n);
+    while (i < n)
+    {
+        size_type room = result.length()-j;
+        if (room < 4)
+        {
+            result.resize(result.length()*2+4);
+            continue;
+        }
+        char* dest = &result[j];
+        if (uint32(p[i]) < 0x80)
+        {
+            size_type k = rimpl::narrow_ascii(dest,p+i,(n-i<room ? n-i : room));
+            i += k;
+            j += k;
+            continue;
+        }
+        size_type len;
+        j += rimpl::utf8_encode(dest,rimpl::wide_decode(p+i,n-i,len));
+        i += len;
+    }
+    result.truncate(j);
+    return result;
+}